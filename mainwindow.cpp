@@ -3,6 +3,7 @@
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
+    , degradationLabel_(nullptr)
 {
     ui->setupUi(this);
     initializeToolBar();
@@ -28,12 +29,44 @@ MainWindow::MainWindow(QWidget *parent)
         ui->vidWgt->addRTCPsource(ui->lE_videoSourceUrl->text());
     });
 
+    connect(ui->pB_openFile, &QPushButton::clicked, this, [this]() {
+        QString fileName = QFileDialog::getOpenFileName(this, "Open video file", QString(),
+                                                        "Video files (*.mp4 *.mkv *.avi *.mov *.raw);;All files (*)");
+        if (!fileName.isEmpty()) {
+            ui->vidWgt->addFileSource(fileName);
+        }
+    });
+
+    connect(ui->pB_addTestPattern, &QPushButton::clicked, this, [this]() {
+        ui->vidWgt->addTestPatternSource(static_cast<TTestPattern::Kind>(ui->cb_testPattern->currentIndex()));
+    });
+
     connect(ui->cb_formats, &QComboBox::currentIndexChanged, ui->vidWgt, &TVideoWdg::changeVideofmt);
 
     connect(ui->dsB_mmInPixelsHeight,&QDoubleSpinBox::valueChanged,ui->vidWgt->getPainter(),&TSurfacePainter::setmmInPixelsHeight);
     connect(ui->dsB_mmInPixelsWidth,&QDoubleSpinBox::valueChanged,ui->vidWgt->getPainter(),&TSurfacePainter::setmmInPixelsWidth);
 
     connect(ui->cB_edgeDetection,&QCheckBox::clicked,ui->vidWgt,&TVideoWdg::useEdgeDetector);
+
+    connect(ui->cB_latencyOverlay,&QCheckBox::clicked,ui->vidWgt,&TVideoWdg::showLatencyOverlay);
+    connect(ui->pB_saveLatencyTrace, &QPushButton::clicked, this, [this]() {
+        QString fileName = QFileDialog::getSaveFileName(this, "Save latency trace", "latency_trace.json",
+                                                        "Chrome trace (*.json)");
+        if (fileName.isEmpty()) {
+            return;
+        }
+        if (ui->vidWgt->saveLatencyTrace(fileName)) {
+            ui->statusbar->showMessage("Latency trace saved to " + fileName);
+        } else {
+            ui->statusbar->showMessage("Failed to save latency trace to " + fileName);
+        }
+    });
+
+    degradationLabel_ = new QLabel(TFrameBudget::levelName(TFrameBudget::Level::Full), this);
+    ui->statusbar->addPermanentWidget(degradationLabel_);
+    connect(ui->vidWgt, &TVideoWdg::degradationLevelChanged, this, [this](int level) {
+        degradationLabel_->setText(TFrameBudget::levelName(static_cast<TFrameBudget::Level>(level)));
+    });
 }
 
 void MainWindow::initializeToolBar()
@@ -66,6 +99,18 @@ void MainWindow::initializeToolBar()
         ui->vidWgt->getPainter()->setCurrentDrawMode(mode);
     });
 
+    QAction *actionSelectRoi = toolBar->addAction(
+        QIcon(":/assets/icons/roi.png"),
+        "Select ROI"
+        );
+    actionSelectRoi->setCheckable(true);
+    actionSelectRoi->setActionGroup(toolBarActGrp);
+    connect(actionSelectRoi, &QAction::toggled, this, [this](bool checked) {
+        TSurfacePainter::DrawMode mode = checked ? TSurfacePainter::DrawMode::Roi : TSurfacePainter::DrawMode::None;
+        ui->vidWgt->getPainter()->setSettingCircleCenter(false);
+        ui->vidWgt->getPainter()->setCurrentDrawMode(mode);
+    });
+
     QAction *actionClearScene = toolBar->addAction(
         QIcon(":/assets/icons/eraser.png"),
         "Clear Scene"
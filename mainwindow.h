@@ -12,6 +12,8 @@
 #include <QMainWindow>
 #include <QToolBar>
 #include <QActionGroup>
+#include <QFileDialog>
+#include <QLabel>
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -32,6 +34,7 @@ public:
 
 private:
     Ui::MainWindow *ui;
+    QLabel *degradationLabel_;
 
     void initializeToolBar();
 };
@@ -0,0 +1,381 @@
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "channelswizzle.h"
+#include "cvmatandqimage.h"
+
+// Подсчет выделений памяти: на glibc перехватываются malloc и его родственники (через них выделяют память и QImage,
+// и cv::Mat, и operator new), в отладочной сборке MSVC - через _CrtSetAllocHook. На остальных платформах счетчик
+// allocs/call не выводится.
+namespace {
+std::atomic<uint64_t> allocations{0};
+
+inline void countAllocation()
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+}
+}
+
+#if defined(__GLIBC__)
+#define BENCH_COUNTS_ALLOCATIONS 1
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size)
+{
+    countAllocation();
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    countAllocation();
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    countAllocation();
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    countAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    countAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    countAllocation();
+    void* mem = __libc_memalign(alignment, size);
+    if (mem == nullptr) {
+        return ENOMEM;
+    }
+    *ptr = mem;
+    return 0;
+}
+}
+#elif defined(_MSC_VER) && defined(_DEBUG)
+#define BENCH_COUNTS_ALLOCATIONS 1
+#include <crtdbg.h>
+namespace {
+int allocHook(int allocType, void*, size_t, int, long, const unsigned char*, int)
+{
+    if (allocType == _HOOK_ALLOC || allocType == _HOOK_REALLOC) {
+        countAllocation();
+    }
+    return TRUE;
+}
+}
+#else
+#define BENCH_COUNTS_ALLOCATIONS 0
+#endif
+
+namespace {
+using namespace QtOcv;
+
+// Типичные разрешения кадров камер
+const std::vector<std::pair<int, int> > kResolutions = {{640, 480}, {1280, 720}, {1920, 1080}, {3840, 2160}};
+
+struct FormatDesc {
+    QImage::Format format;
+    const char* name;
+};
+
+// Форматы, которые image2Mat_shared/mat2Image_shared отображают без копирования
+const std::vector<FormatDesc> kSharedFormats = {
+    {QImage::Format_Indexed8, "Indexed8"},
+    {QImage::Format_Alpha8, "Alpha8"},
+    {QImage::Format_Grayscale8, "Grayscale8"},
+    {QImage::Format_RGB888, "RGB888"},
+    {QImage::Format_RGB32, "RGB32"},
+    {QImage::Format_ARGB32, "ARGB32"},
+    {QImage::Format_ARGB32_Premultiplied, "ARGB32_Premultiplied"},
+    {QImage::Format_RGBX8888, "RGBX8888"},
+    {QImage::Format_RGBA8888, "RGBA8888"},
+    {QImage::Format_RGBA8888_Premultiplied, "RGBA8888_Premultiplied"},
+};
+
+// Форматы, которые image2Mat сначала приводит к ближайшему из kSharedFormats (findClosestFormat);
+// BGR888 - представитель форматов, приводимых к ARGB32 по умолчанию
+const std::vector<FormatDesc> kConvertedFormats = {
+    {QImage::Format_Mono, "Mono"},
+    {QImage::Format_MonoLSB, "MonoLSB"},
+    {QImage::Format_RGB16, "RGB16"},
+    {QImage::Format_RGB444, "RGB444"},
+    {QImage::Format_RGB555, "RGB555"},
+    {QImage::Format_RGB666, "RGB666"},
+    {QImage::Format_ARGB4444_Premultiplied, "ARGB4444_Premultiplied"},
+    {QImage::Format_ARGB6666_Premultiplied, "ARGB6666_Premultiplied"},
+    {QImage::Format_ARGB8555_Premultiplied, "ARGB8555_Premultiplied"},
+    {QImage::Format_ARGB8565_Premultiplied, "ARGB8565_Premultiplied"},
+    {QImage::Format_BGR888, "BGR888"},
+};
+
+struct MatTypeDesc {
+    int type;
+    MatColorOrder order;
+    const char* name;
+};
+
+// Все поддерживаемые глубины (8U, 16U, 32F) с каждым порядком каналов
+const std::vector<MatTypeDesc> kMatTypes = {
+    {CV_8UC1, MCO_BGR, "8UC1"},
+    {CV_8UC3, MCO_BGR, "8UC3_BGR"},
+    {CV_8UC3, MCO_RGB, "8UC3_RGB"},
+    {CV_8UC4, MCO_BGRA, "8UC4_BGRA"},
+    {CV_8UC4, MCO_RGBA, "8UC4_RGBA"},
+    {CV_8UC4, MCO_ARGB, "8UC4_ARGB"},
+    {CV_16UC1, MCO_BGR, "16UC1"},
+    {CV_16UC3, MCO_BGR, "16UC3_BGR"},
+    {CV_16UC3, MCO_RGB, "16UC3_RGB"},
+    {CV_16UC4, MCO_BGRA, "16UC4_BGRA"},
+    {CV_16UC4, MCO_RGBA, "16UC4_RGBA"},
+    {CV_16UC4, MCO_ARGB, "16UC4_ARGB"},
+    {CV_32FC1, MCO_BGR, "32FC1"},
+    {CV_32FC3, MCO_BGR, "32FC3_BGR"},
+    {CV_32FC3, MCO_RGB, "32FC3_RGB"},
+    {CV_32FC4, MCO_BGRA, "32FC4_BGRA"},
+    {CV_32FC4, MCO_RGBA, "32FC4_RGBA"},
+    {CV_32FC4, MCO_ARGB, "32FC4_ARGB"},
+};
+
+// Подсказки формата для mat2Image; Format_Invalid - формат по умолчанию для типа
+const std::vector<FormatDesc> kFormatHints = {
+    {QImage::Format_Invalid, "default"},
+    {QImage::Format_Indexed8, "Indexed8"},
+    {QImage::Format_Grayscale8, "Grayscale8"},
+    {QImage::Format_RGB888, "RGB888"},
+    {QImage::Format_RGB32, "RGB32"},
+    {QImage::Format_ARGB32, "ARGB32"},
+    {QImage::Format_ARGB32_Premultiplied, "ARGB32_Premultiplied"},
+    {QImage::Format_RGBA8888, "RGBA8888"},
+};
+
+// Изображение с псевдослучайным содержимым
+QImage makeImage(int width, int height, QImage::Format format)
+{
+    QImage img(width, height, format);
+    if (format == QImage::Format_Mono || format == QImage::Format_MonoLSB) {
+        img.setColorTable({qRgb(0, 0, 0), qRgb(255, 255, 255)});
+    } else if (format == QImage::Format_Indexed8) {
+        QVector<QRgb> colorTable;
+        for (int i = 0; i < 256; ++i) {
+            colorTable.append(qRgb(i, i, i));
+        }
+        img.setColorTable(colorTable);
+    }
+    uint32_t state = 12345u;
+    for (int y = 0; y < img.height(); ++y) {
+        uchar* line = img.scanLine(y);
+        for (qsizetype x = 0; x < img.bytesPerLine(); ++x) {
+            state = state * 1664525u + 1013904223u;
+            line[x] = static_cast<uchar>(state >> 24);
+        }
+    }
+    return img;
+}
+
+// cv::Mat с псевдослучайным содержимым
+cv::Mat makeMat(int width, int height, int type)
+{
+    cv::Mat mat(height, width, type);
+    cv::RNG rng(12345);
+    if (CV_MAT_DEPTH(type) == CV_32F) {
+        rng.fill(mat, cv::RNG::UNIFORM, 0.0, 1.0);
+    } else if (CV_MAT_DEPTH(type) == CV_16U) {
+        rng.fill(mat, cv::RNG::UNIFORM, 0, 65536);
+    } else {
+        rng.fill(mat, cv::RNG::UNIFORM, 0, 256);
+    }
+    return mat;
+}
+
+std::string resolutionName(int width, int height)
+{
+    return std::to_string(width) + "x" + std::to_string(height);
+}
+
+// Общий цикл замера: пропускная способность (GB=.../s) по объему исходного кадра и число выделений памяти на вызов
+template<typename Convert>
+void runConversion(benchmark::State& state, size_t frameBytes, Convert convert)
+{
+    const uint64_t allocationsBefore = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        convert();
+    }
+    const uint64_t allocationsAfter = allocations.load(std::memory_order_relaxed);
+    state.counters["GB"] = benchmark::Counter(double(state.iterations()) * frameBytes / 1e9,
+                                                benchmark::Counter::kIsRate);
+#if BENCH_COUNTS_ALLOCATIONS
+    state.counters["allocs/call"] = benchmark::Counter(double(allocationsAfter - allocationsBefore),
+                                                       benchmark::Counter::kAvgIterations);
+#else
+    Q_UNUSED(allocationsBefore);
+    Q_UNUSED(allocationsAfter);
+#endif
+}
+
+void registerImage2Mat()
+{
+    std::vector<FormatDesc> formats = kSharedFormats;
+    formats.insert(formats.end(), kConvertedFormats.begin(), kConvertedFormats.end());
+    for (const FormatDesc& format : formats) {
+        for (const MatTypeDesc& target : kMatTypes) {
+            for (const auto& res : kResolutions) {
+                const std::string name = std::string("image2Mat/") + format.name + "->" + target.name + "/"
+                        + resolutionName(res.first, res.second);
+                benchmark::RegisterBenchmark(name.c_str(), [format, target, res](benchmark::State& state) {
+                    const QImage img = makeImage(res.first, res.second, format.format);
+                    runConversion(state, img.sizeInBytes(), [&]() {
+                        cv::Mat mat = image2Mat(img, target.type, target.order);
+                        benchmark::DoNotOptimize(mat.data);
+                    });
+                })->Unit(benchmark::kMicrosecond);
+            }
+        }
+    }
+}
+
+void registerMat2Image()
+{
+    for (const MatTypeDesc& source : kMatTypes) {
+        for (const FormatDesc& hint : kFormatHints) {
+            for (const auto& res : kResolutions) {
+                const std::string name = std::string("mat2Image/") + source.name + "->" + hint.name + "/"
+                        + resolutionName(res.first, res.second);
+                benchmark::RegisterBenchmark(name.c_str(), [source, hint, res](benchmark::State& state) {
+                    const cv::Mat mat = makeMat(res.first, res.second, source.type);
+                    runConversion(state, mat.total() * mat.elemSize(), [&]() {
+                        QImage img = mat2Image(mat, source.order, hint.format);
+                        benchmark::DoNotOptimize(img.constBits());
+                    });
+                })->Unit(benchmark::kMicrosecond);
+            }
+        }
+    }
+}
+
+void registerSharedConversions()
+{
+    for (const FormatDesc& format : kSharedFormats) {
+        for (const auto& res : kResolutions) {
+            const std::string image2MatName = std::string("image2Mat_shared/") + format.name + "/"
+                    + resolutionName(res.first, res.second);
+            benchmark::RegisterBenchmark(image2MatName.c_str(), [format, res](benchmark::State& state) {
+                const QImage img = makeImage(res.first, res.second, format.format);
+                runConversion(state, img.sizeInBytes(), [&]() {
+                    MatColorOrder order;
+                    cv::Mat mat = image2Mat_shared(img, &order);
+                    benchmark::DoNotOptimize(mat.data);
+                    benchmark::DoNotOptimize(order);
+                });
+            });
+
+            const std::string mat2ImageName = std::string("mat2Image_shared/") + format.name + "/"
+                    + resolutionName(res.first, res.second);
+            benchmark::RegisterBenchmark(mat2ImageName.c_str(), [format, res](benchmark::State& state) {
+                const QImage img = makeImage(res.first, res.second, format.format);
+                const cv::Mat mat = image2Mat_shared(img);
+                runConversion(state, mat.total() * mat.elemSize(), [&]() {
+                    QImage view = mat2Image_shared(mat, format.format);
+                    benchmark::DoNotOptimize(view.constBits());
+                });
+            });
+        }
+    }
+}
+
+void registerSwizzleKernels()
+{
+    const std::pair<SwizzleIsa, const char*> isas[] = {
+        {SwizzleIsa::Scalar, "Scalar"}, {SwizzleIsa::SSSE3, "SSSE3"}, {SwizzleIsa::AVX2, "AVX2"}};
+    for (const auto& isa : isas) {
+        if (!isSwizzleIsaSupported(isa.first)) {
+            continue;
+        }
+        for (const auto& res : kResolutions) {
+            const std::string name = std::string("swizzle4/") + isa.second + "/" + resolutionName(res.first, res.second);
+            benchmark::RegisterBenchmark(name.c_str(), [isa, res](benchmark::State& state) {
+                const cv::Mat src = makeMat(res.first, res.second, CV_8UC4);
+                cv::Mat dst(src.size(), src.type());
+                const uint8_t order[4] = {3, 2, 1, 0};
+                runConversion(state, src.total() * src.elemSize(), [&]() {
+                    swizzle4(src.ptr<uint8_t>(), dst.ptr<uint8_t>(), src.total(), order, isa.first);
+                    benchmark::DoNotOptimize(dst.data);
+                });
+            })->Unit(benchmark::kMicrosecond);
+        }
+    }
+}
+
+void registerYuvConversions()
+{
+    const std::pair<YuvFormat, const char*> formats[] = {
+        {YUV_NV12, "NV12"}, {YUV_I420, "I420"}, {YUV_YUYV, "YUYV"}};
+    for (const auto& format : formats) {
+        for (const auto& res : kResolutions) {
+            const std::string name = std::string("yuv2Mat/") + format.second + "->BGRA/"
+                    + resolutionName(res.first, res.second);
+            benchmark::RegisterBenchmark(name.c_str(), [format, res](benchmark::State& state) {
+                const int width = res.first;
+                const int height = res.second;
+                const bool packed = format.first == YUV_YUYV;
+                // Непрерывный буфер кадра, как у отображенного QVideoFrame
+                const cv::Mat frame = makeMat(width, packed ? height : height * 3 / 2, packed ? CV_8UC2 : CV_8UC1);
+                YuvImage yuv = {format.first, width, height, {frame.data, nullptr, nullptr}, {frame.step, 0, 0}};
+                if (format.first == YUV_NV12) {
+                    yuv.planes[1] = frame.ptr(height);
+                    yuv.steps[1] = frame.step;
+                } else if (format.first == YUV_I420) {
+                    yuv.planes[1] = frame.ptr(height);
+                    yuv.planes[2] = yuv.planes[1] + size_t(width) * height / 4;
+                    yuv.steps[1] = yuv.steps[2] = width / 2;
+                }
+                // Запись в повторно используемый буфер изображения, как в TFramePacket::convertToImage()
+                QImage img(width, height, QImage::Format_RGB32);
+                cv::Mat view(height, width, CV_8UC4, img.bits(), img.bytesPerLine());
+                runConversion(state, frame.total() * frame.elemSize(), [&]() {
+                    yuv2Mat(yuv, view, CV_8UC4, MCO_BGRA);
+                    benchmark::DoNotOptimize(view.data);
+                });
+            })->Unit(benchmark::kMicrosecond);
+        }
+    }
+}
+}
+
+int main(int argc, char** argv)
+{
+#if defined(_MSC_VER) && defined(_DEBUG)
+    _CrtSetAllocHook(allocHook);
+#endif
+    registerImage2Mat();
+    registerMat2Image();
+    registerSharedConversions();
+    registerSwizzleKernels();
+    registerYuvConversions();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include "channelswizzle.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SWIZZLE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define SWIZZLE_X86 0
+#endif
+
+// GCC and Clang compile each kernel for its own instruction set, no global -mavx2 is needed; MSVC always accepts the
+// intrinsics.
+#if SWIZZLE_X86 && (defined(__GNUC__) || defined(__clang__))
+#define SWIZZLE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SWIZZLE_TARGET(isa)
+#endif
+
+namespace QtOcv {
+namespace {
+
+using SwizzleKernel = void (*)(const uint8_t*, uint8_t*, size_t, const uint8_t*);
+
+void swizzleScalar(const uint8_t* src, uint8_t* dst, size_t pixels, const uint8_t* order)
+{
+    for (size_t i = 0; i < pixels; ++i, src += 4, dst += 4) {
+        // Read the whole pixel first, src may be dst.
+        const uint8_t px[4] = {src[0], src[1], src[2], src[3]};
+        dst[0] = px[order[0]];
+        dst[1] = px[order[1]];
+        dst[2] = px[order[2]];
+        dst[3] = px[order[3]];
+    }
+}
+
+#if SWIZZLE_X86
+// Fills a pshufb mask for 4 pixels.
+void shuffleMask(const uint8_t* order, uint8_t mask[16])
+{
+    for (int i = 0; i < 16; ++i) {
+        mask[i] = static_cast<uint8_t>((i & ~3) + order[i & 3]);
+    }
+}
+
+SWIZZLE_TARGET("ssse3")
+void swizzleSsse3(const uint8_t* src, uint8_t* dst, size_t pixels, const uint8_t* order)
+{
+    alignas(16) uint8_t maskBytes[16];
+    shuffleMask(order, maskBytes);
+    const __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i*>(maskBytes));
+    size_t i = 0;
+    for (; i + 8 <= pixels; i += 8) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * i + 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * i), _mm_shuffle_epi8(a, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * i + 16), _mm_shuffle_epi8(b, mask));
+    }
+    for (; i + 4 <= pixels; i += 4) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * i), _mm_shuffle_epi8(a, mask));
+    }
+    swizzleScalar(src + 4 * i, dst + 4 * i, pixels - i, order);
+}
+
+SWIZZLE_TARGET("avx2")
+void swizzleAvx2(const uint8_t* src, uint8_t* dst, size_t pixels, const uint8_t* order)
+{
+    // vpshufb shuffles within 128-bit lanes, the same 4-pixel mask serves both lanes.
+    alignas(32) uint8_t maskBytes[32];
+    shuffleMask(order, maskBytes);
+    shuffleMask(order, maskBytes + 16);
+    const __m256i mask = _mm256_load_si256(reinterpret_cast<const __m256i*>(maskBytes));
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 4 * i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 4 * i + 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 4 * i), _mm256_shuffle_epi8(a, mask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 4 * i + 32), _mm256_shuffle_epi8(b, mask));
+    }
+    for (; i + 8 <= pixels; i += 8) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 4 * i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 4 * i), _mm256_shuffle_epi8(a, mask));
+    }
+    // Remaining 0-7 pixels: the SSSE3 kernel handles whole quads, the scalar one the rest.
+    swizzleSsse3(src + 4 * i, dst + 4 * i, pixels - i, order);
+}
+
+bool cpuSupports(SwizzleIsa isa)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    const bool ssse3 = (info[2] & (1 << 9)) != 0;
+    if (isa == SwizzleIsa::SSSE3) {
+        return ssse3;
+    }
+    // AVX2 also needs the OS to save the YMM registers.
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || maxLeaf < 7 || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    if (isa == SwizzleIsa::SSSE3) {
+        return __builtin_cpu_supports("ssse3");
+    }
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+SwizzleKernel kernel(SwizzleIsa isa)
+{
+#if SWIZZLE_X86
+    switch (isa) {
+    case SwizzleIsa::AVX2:
+        return swizzleAvx2;
+    case SwizzleIsa::SSSE3:
+        return swizzleSsse3;
+    case SwizzleIsa::Scalar:
+        break;
+    }
+#else
+    (void)isa;
+#endif
+    return swizzleScalar;
+}
+} //namespace
+
+bool isSwizzleIsaSupported(SwizzleIsa isa)
+{
+    if (isa == SwizzleIsa::Scalar) {
+        return true;
+    }
+#if SWIZZLE_X86
+    return cpuSupports(isa);
+#else
+    return false;
+#endif
+}
+
+SwizzleIsa bestSwizzleIsa()
+{
+    static const SwizzleIsa best = isSwizzleIsaSupported(SwizzleIsa::AVX2) ? SwizzleIsa::AVX2
+                                 : isSwizzleIsaSupported(SwizzleIsa::SSSE3) ? SwizzleIsa::SSSE3
+                                 : SwizzleIsa::Scalar;
+    return best;
+}
+
+void swizzle4(const uint8_t *src, uint8_t *dst, size_t pixels, const uint8_t order[4])
+{
+    static const SwizzleKernel best = kernel(bestSwizzleIsa());
+    best(src, dst, pixels, order);
+}
+
+void swizzle4(const uint8_t *src, uint8_t *dst, size_t pixels, const uint8_t order[4], SwizzleIsa isa)
+{
+    kernel(isSwizzleIsaSupported(isa) ? isa : SwizzleIsa::Scalar)(src, dst, pixels, order);
+}
+
+} //namespace QtOcv
@@ -0,0 +1,63 @@
+/** @file
+ *
+ * TVideoWdg - SimpleMeasurementByVideoTool
+ * By Ilia.belou <ilia.belou@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef CHANNELSWIZZLE_H
+#define CHANNELSWIZZLE_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace QtOcv {
+
+/*!
+ * \brief Instruction sets of the channel swizzle kernels.
+ */
+enum class SwizzleIsa : unsigned int {
+    Scalar, ///< Portable byte-by-byte kernel.
+    SSSE3,  ///< 4 pixels per pshufb.
+    AVX2    ///< 8 pixels per vpshufb.
+};
+
+/*!
+ * \brief Checks if a swizzle kernel can run on this CPU.
+ * \param isa The instruction set of the kernel.
+ * \return True if the kernel is compiled in and supported by the CPU.
+ */
+bool isSwizzleIsaSupported(SwizzleIsa isa);
+
+/*!
+ * \brief Retrieves the fastest swizzle kernel available on this CPU.
+ * \return The instruction set used by swizzle4() without an explicit kernel.
+ */
+SwizzleIsa bestSwizzleIsa();
+
+/*!
+ * \brief Reorders the channels of 4-channel 8-bit pixels.
+ * \param src The source pixels.
+ * \param dst The destination pixels. May be equal to src, but must not overlap it otherwise.
+ * \param pixels The number of pixels.
+ * \param order Source channel of each destination channel: dst[4 * i + k] = src[4 * i + order[k]]. Each entry must be
+ * less than 4.
+ *
+ * Runs the fastest kernel available on this CPU, selected once at first use. Pointers need no particular alignment.
+ */
+void swizzle4(const uint8_t* src, uint8_t* dst, size_t pixels, const uint8_t order[4]);
+
+/*!
+ * \brief Reorders the channels of 4-channel 8-bit pixels with a given kernel.
+ * \param src The source pixels.
+ * \param dst The destination pixels. May be equal to src, but must not overlap it otherwise.
+ * \param pixels The number of pixels.
+ * \param order Source channel of each destination channel, see swizzle4().
+ * \param isa The kernel to run. The scalar kernel is used if it is not supported.
+ */
+void swizzle4(const uint8_t* src, uint8_t* dst, size_t pixels, const uint8_t order[4], SwizzleIsa isa);
+
+} //namespace QtOcv
+
+#endif // CHANNELSWIZZLE_H
@@ -24,6 +24,7 @@
 ****************************************************************************/
 
 #include "cvmatandqimage.h"
+#include "channelswizzle.h"
 #include <QImage>
 #include <QSysInfo>
 #include <QDebug>
@@ -34,18 +35,36 @@
 namespace QtOcv {
 namespace {
 
-/*ARGB <==> BGRA
+/*Reorder the channels of a 4 channels mat: channel k of the result is channel order[k] of mat.
+ *8-bit mats go through the SIMD kernels of swizzle4(), other depths through cv::mixChannels().
  */
-cv::Mat argb2bgra(const cv::Mat &mat)
+cv::Mat reorderChannels(const cv::Mat &mat, const uint8_t order[4])
 {
     Q_ASSERT(mat.channels()==4);
 
     cv::Mat newMat(mat.rows, mat.cols, mat.type());
-    int from_to[] = {0,3, 1,2, 2,1, 3,0};
+    if (mat.depth() == CV_8U) {
+        if (mat.isContinuous() && newMat.isContinuous()) {
+            swizzle4(mat.ptr<uint8_t>(), newMat.ptr<uint8_t>(), mat.total(), order);
+        } else {
+            for (int y = 0; y < mat.rows; ++y)
+                swizzle4(mat.ptr<uint8_t>(y), newMat.ptr<uint8_t>(y), mat.cols, order);
+        }
+        return newMat;
+    }
+    int from_to[] = {order[0],0, order[1],1, order[2],2, order[3],3};
     cv::mixChannels(&mat, 1, &newMat, 1, from_to, 4);
     return newMat;
 }
 
+/*ARGB <==> BGRA
+ */
+cv::Mat argb2bgra(const cv::Mat &mat)
+{
+    const uint8_t order[] = {3, 2, 1, 0};
+    return reorderChannels(mat, order);
+}
+
 cv::Mat adjustChannelsOrder(const cv::Mat &srcMat, MatColorOrder srcOrder, MatColorOrder targetOrder)
 {
     Q_ASSERT(srcMat.channels()==4);
@@ -53,27 +72,22 @@ cv::Mat adjustChannelsOrder(const cv::Mat &srcMat, MatColorOrder srcOrder, MatCo
     if (srcOrder == targetOrder)
         return srcMat.clone();
 
-    cv::Mat desMat;
-
     if ((srcOrder == MCO_ARGB && targetOrder == MCO_BGRA)
             ||(srcOrder == MCO_BGRA && targetOrder == MCO_ARGB)) {
         //ARGB <==> BGRA
-        desMat = argb2bgra(srcMat);
+        return argb2bgra(srcMat);
     } else if (srcOrder == MCO_ARGB && targetOrder == MCO_RGBA) {
         //ARGB ==> RGBA
-        desMat = cv::Mat(srcMat.rows, srcMat.cols, srcMat.type());
-        int from_to[] = {0,3, 1,0, 2,1, 3,2};
-        cv::mixChannels(&srcMat, 1, &desMat, 1, from_to, 4);
+        const uint8_t order[] = {1, 2, 3, 0};
+        return reorderChannels(srcMat, order);
     } else if (srcOrder == MCO_RGBA && targetOrder == MCO_ARGB) {
         //RGBA ==> ARGB
-        desMat = cv::Mat(srcMat.rows, srcMat.cols, srcMat.type());
-        int from_to[] = {0,1, 1,2, 2,3, 3,0};
-        cv::mixChannels(&srcMat, 1, &desMat, 1, from_to, 4);
-    } else {
-        //BGRA <==> RBGA
-        cv::cvtColor(srcMat, desMat, cv::COLOR_BGRA2RGBA);
+        const uint8_t order[] = {3, 0, 1, 2};
+        return reorderChannels(srcMat, order);
     }
-    return desMat;
+    //BGRA <==> RBGA
+    const uint8_t order[] = {2, 1, 0, 3};
+    return reorderChannels(srcMat, order);
 }
 
 QImage::Format findClosestFormat(QImage::Format formatHint)
@@ -133,6 +147,127 @@ MatColorOrder getColorOrderOfRGB32Format()
         return MCO_ARGB;
 #endif
 }
+
+#if CV_VERSION_MAJOR >= 4
+typedef cv::AccessFlag MatAccessFlags;
+#else
+typedef int MatAccessFlags;
+#endif
+
+/*Allocator of cv::Mat data owned by a QImage.
+ *UMatData::userdata holds a copy of the QImage, released with the last cv::Mat.
+ *New allocations (e.g. cv::Mat::create() with another size) go to the standard allocator.
+ */
+class QImageMatAllocator : public cv::MatAllocator
+{
+public:
+    cv::UMatData *allocate(int dims, const int *sizes, int type, void *data, size_t *step,
+                           MatAccessFlags flags, cv::UMatUsageFlags usageFlags) const override
+    {
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+
+    bool allocate(cv::UMatData *data, MatAccessFlags accessFlags, cv::UMatUsageFlags usageFlags) const override
+    {
+        return cv::Mat::getStdAllocator()->allocate(data, accessFlags, usageFlags);
+    }
+
+    void deallocate(cv::UMatData *data) const override
+    {
+        if (!data)
+            return;
+        Q_ASSERT(data->refcount == 0 && data->urefcount == 0);
+        delete static_cast<QImage *>(data->userdata);
+        delete data;
+    }
+};
+
+const cv::MatAllocator *qImageMatAllocator()
+{
+    //Never destroyed: cv::Mat objects may outlive static destruction.
+    static const QImageMatAllocator *allocator = new QImageMatAllocator;
+    return allocator;
+}
+
+void releaseMat(void *info)
+{
+    delete static_cast<cv::Mat *>(info);
+}
+
+/*Check the geometry and the planes of a YUV image.
+ */
+bool isValidYuv(const YuvImage &yuv)
+{
+    int planeCount;
+    switch (yuv.format) {
+    case YUV_NV12:
+    case YUV_NV21:
+        planeCount = 2;
+        break;
+    case YUV_I420:
+    case YUV_YV12:
+        planeCount = 3;
+        break;
+    case YUV_YUYV:
+    case YUV_UYVY:
+        planeCount = 1;
+        break;
+    default:
+        return false;
+    }
+    if (yuv.width <= 0 || yuv.height <= 0 || yuv.width % 2 || (planeCount > 1 && yuv.height % 2))
+        return false;
+    for (int i=0; i<planeCount; ++i) {
+        if (!yuv.planes[i])
+            return false;
+    }
+    return true;
+}
+
+cv::Mat planeMat(const YuvImage &yuv, int plane, int rows, int cols, int type)
+{
+    return cv::Mat(rows, cols, type, const_cast<uchar *>(yuv.planes[plane]), yuv.steps[plane]);
+}
+
+/*cv::cvtColor() code converting a YUV format to 3 or 4 channels.
+ *MCO_ARGB gives RGB for 3 channels (as image2Mat() does) and BGRA for 4 channels, reordered by the caller.
+ */
+int yuvConversionCode(YuvFormat format, int channels, MatColorOrder order)
+{
+    static const int codes[][4] = {
+        /* BGR, RGB, BGRA, RGBA */
+        {cv::COLOR_YUV2BGR_NV12, cv::COLOR_YUV2RGB_NV12, cv::COLOR_YUV2BGRA_NV12, cv::COLOR_YUV2RGBA_NV12},
+        {cv::COLOR_YUV2BGR_NV21, cv::COLOR_YUV2RGB_NV21, cv::COLOR_YUV2BGRA_NV21, cv::COLOR_YUV2RGBA_NV21},
+        {cv::COLOR_YUV2BGR_I420, cv::COLOR_YUV2RGB_I420, cv::COLOR_YUV2BGRA_I420, cv::COLOR_YUV2RGBA_I420},
+        {cv::COLOR_YUV2BGR_YV12, cv::COLOR_YUV2RGB_YV12, cv::COLOR_YUV2BGRA_YV12, cv::COLOR_YUV2RGBA_YV12},
+        {cv::COLOR_YUV2BGR_YUYV, cv::COLOR_YUV2RGB_YUYV, cv::COLOR_YUV2BGRA_YUYV, cv::COLOR_YUV2RGBA_YUYV},
+        {cv::COLOR_YUV2BGR_UYVY, cv::COLOR_YUV2RGB_UYVY, cv::COLOR_YUV2BGRA_UYVY, cv::COLOR_YUV2RGBA_UYVY}
+    };
+    const bool rgb = channels == 3 ? order != MCO_BGR : order == MCO_RGBA;
+    return codes[format][(channels == 4 ? 2 : 0) + (rgb ? 1 : 0)];
+}
+
+/*Single channel mat of an I420/YV12 image in the layout cv::cvtColor() expects: the chroma planes follow the
+ *Y plane, rows packed at half its width. Planes laid out otherwise (padded rows, separate buffers) are copied
+ *into buffer first.
+ */
+cv::Mat planar420Mat(const YuvImage &yuv, cv::Mat &buffer)
+{
+    const size_t ySize = size_t(yuv.width) * yuv.height;
+    const size_t chromaSize = ySize / 4;
+    if (yuv.steps[0] == size_t(yuv.width) && yuv.steps[1] == size_t(yuv.width/2) && yuv.steps[2] == yuv.steps[1]
+            && yuv.planes[1] == yuv.planes[0] + ySize && yuv.planes[2] == yuv.planes[1] + chromaSize)
+        return planeMat(yuv, 0, yuv.height * 3/2, yuv.width, CV_8UC1);
+
+    buffer.create(yuv.height * 3/2, yuv.width, CV_8UC1);
+    planeMat(yuv, 0, yuv.height, yuv.width, CV_8UC1).copyTo(buffer.rowRange(0, yuv.height));
+    uchar *chroma = buffer.ptr(yuv.height);
+    for (int i=1; i<3; ++i, chroma += chromaSize) {
+        cv::Mat packed(yuv.height/2, yuv.width/2, CV_8UC1, chroma);
+        planeMat(yuv, i, yuv.height/2, yuv.width/2, CV_8UC1).copyTo(packed);
+    }
+    return buffer;
+}
 } //namespace
 
 
@@ -415,4 +550,110 @@ QImage mat2Image_shared(const cv::Mat &mat, QImage::Format formatHint)
     return img;
 }
 
+/* Convert QImage to cv::Mat without data copy, keeping the QImage data alive
+ */
+cv::Mat image2Mat_refcounted(const QImage &img, MatColorOrder *order)
+{
+    cv::Mat view = image2Mat_shared(img, order);
+    if (view.empty())
+        return view;
+
+    //A shallow copy holds a reference to the data; constBits() does not detach it.
+    QImage *owner = new QImage(img);
+    cv::Mat mat(owner->height(), owner->width(), view.type(), const_cast<uchar *>(owner->constBits()),
+                static_cast<size_t>(owner->bytesPerLine()));
+    cv::UMatData *u = new cv::UMatData(qImageMatAllocator());
+    u->data = u->origdata = mat.data;
+    u->size = static_cast<size_t>(owner->sizeInBytes());
+    u->userdata = owner;
+    mat.u = u;
+    mat.addref();
+    return mat;
+}
+
+/* Convert cv::Mat to QImage without data copy, keeping the cv::Mat data alive
+ */
+QImage mat2Image_refcounted(const cv::Mat &mat, QImage::Format formatHint)
+{
+    QImage view = mat2Image_shared(mat, formatHint);
+    if (view.isNull())
+        return view;
+
+    //The copy holds a reference to the data until the QImage cleanup function runs.
+    cv::Mat *owner = new cv::Mat(mat);
+    QImage img(owner->data, owner->cols, owner->rows, static_cast<qsizetype>(owner->step), view.format(),
+               releaseMat, owner);
+    if (img.isNull()) {
+        delete owner;
+        return img;
+    }
+    if (view.format() == QImage::Format_Indexed8)
+        img.setColorTable(view.colorTable());
+    return img;
+}
+
+/* Convert YUV image to cv::Mat
+ */
+cv::Mat yuv2Gray_shared(const YuvImage &yuv)
+{
+    if (!isValidYuv(yuv) || yuv.format == YUV_YUYV || yuv.format == YUV_UYVY)
+        return cv::Mat();
+    return planeMat(yuv, 0, yuv.height, yuv.width, CV_8UC1);
+}
+
+cv::Mat yuv2Mat(const YuvImage &yuv, int requiredMatType, MatColorOrder requiredOrder)
+{
+    cv::Mat mat;
+    yuv2Mat(yuv, mat, requiredMatType, requiredOrder);
+    return mat;
+}
+
+bool yuv2Mat(const YuvImage &yuv, cv::Mat &dst, int requiredMatType, MatColorOrder requiredOrder)
+{
+    int targetDepth = CV_MAT_DEPTH(requiredMatType);
+    int targetChannels = CV_MAT_CN(requiredMatType);
+    Q_ASSERT(targetChannels==1 || targetChannels==3 || targetChannels==4);
+    Q_ASSERT(targetDepth==CV_8U || targetDepth==CV_16U || targetDepth==CV_32F);
+
+    if (!isValidYuv(yuv))
+        return false;
+
+    //8-bit results go straight to dst, other depths are converted afterwards.
+    cv::Mat mat8u;
+    cv::Mat &out = targetDepth == CV_8U ? dst : mat8u;
+    if (targetChannels == 1) {
+        if (yuv.format == YUV_YUYV || yuv.format == YUV_UYVY)
+            cv::extractChannel(planeMat(yuv, 0, yuv.height, yuv.width, CV_8UC2), out, yuv.format == YUV_YUYV ? 0 : 1);
+        else
+            yuv2Gray_shared(yuv).copyTo(out);
+    } else {
+        const int code = yuvConversionCode(yuv.format, targetChannels, requiredOrder);
+        cv::Mat buffer;
+        switch (yuv.format) {
+        case YUV_NV12:
+        case YUV_NV21:
+            cv::cvtColorTwoPlane(planeMat(yuv, 0, yuv.height, yuv.width, CV_8UC1),
+                                 planeMat(yuv, 1, yuv.height/2, yuv.width/2, CV_8UC2), out, code);
+            break;
+        case YUV_I420:
+        case YUV_YV12:
+            cv::cvtColor(planar420Mat(yuv, buffer), out, code);
+            break;
+        default:
+            cv::cvtColor(planeMat(yuv, 0, yuv.height, yuv.width, CV_8UC2), out, code);
+            break;
+        }
+        if (targetChannels == 4 && requiredOrder == MCO_ARGB) {
+            //BGRA ==> ARGB in place
+            const uint8_t order[] = {3, 2, 1, 0};
+            for (int y = 0; y < out.rows; ++y)
+                swizzle4(out.ptr<uint8_t>(y), out.ptr<uint8_t>(y), out.cols, order);
+        }
+    }
+
+    if (targetDepth != CV_8U)
+        mat8u.convertTo(dst, CV_MAKE_TYPE(targetDepth, targetChannels), targetDepth == CV_16U ? 255.0 : 1/255.0);
+    return true;
+}
+
 } //namespace QtOcv
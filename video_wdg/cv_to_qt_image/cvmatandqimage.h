@@ -39,6 +39,32 @@ enum MatColorOrder {
     MCO_ARGB
 };
 
+enum YuvFormat {
+    YUV_NV12, /* Y plane, interleaved U V plane (4:2:0) */
+    YUV_NV21, /* Y plane, interleaved V U plane (4:2:0) */
+    YUV_I420, /* Y, U and V planes (4:2:0) */
+    YUV_YV12, /* Y, V and U planes (4:2:0) */
+    YUV_YUYV, /* Y0 U Y1 V packed (4:2:2) */
+    YUV_UYVY  /* U Y0 V Y1 packed (4:2:2) */
+};
+
+/* 8-bit YUV image in memory, e.g. a mapped QVideoFrame
+ *
+ * - planes[i] and steps[i] are the start and the bytes per line of
+ *   plane i, in the order of the format: 2 planes for NV12/NV21,
+ *   3 for I420/YV12 (the second one is V for YV12), 1 for YUYV/UYVY.
+ *   Unused entries are ignored.
+ *
+ * - The width must be even, and the height too for 4:2:0 formats.
+ */
+struct YuvImage {
+    YuvFormat format;
+    int width;
+    int height;
+    const uchar *planes[3];
+    size_t steps[3];
+};
+
 
 /* Convert QImage to/from cv::Mat
  *
@@ -83,6 +109,49 @@ QImage mat2Image(const cv::Mat &mat, MatColorOrder order=MCO_BGR, QImage::Format
 cv::Mat image2Mat_shared(const QImage &img, MatColorOrder *order=0);
 QImage mat2Image_shared(const cv::Mat &mat, QImage::Format formatHint = QImage::Format_Invalid);
 
+/* Convert QImage to/from cv::Mat without data copy, sharing ownership of the data
+ *
+ * - Same formats and channel orders as image2Mat_shared() and mat2Image_shared().
+ *
+ * - The result keeps the source data alive: the QImage returned by
+ *   mat2Image_refcounted() holds a reference to the cv::Mat data that is
+ *   released by the QImage cleanup function, the cv::Mat returned by
+ *   image2Mat_refcounted() holds a copy of the QImage that is released
+ *   when the last cv::Mat sharing the data goes away. The source may
+ *   therefore be destroyed before the result.
+ *
+ * - Both views write to the same pixels. A QImage that was copied still
+ *   detaches on write as usual, the cv::Mat never does.
+ *
+ * - A cv::Mat that does not own its data (constructed on a user buffer)
+ *   cannot be kept alive, the caller must keep that buffer alive.
+ */
+cv::Mat image2Mat_refcounted(const QImage &img, MatColorOrder *order=0);
+QImage mat2Image_refcounted(const cv::Mat &mat, QImage::Format formatHint = QImage::Format_Invalid);
+
+/* Convert YUV image to cv::Mat
+ *
+ * - yuv2Gray_shared() returns the Y plane of a planar or semi-planar
+ *   image as CV_8UC1 without data copy, or an empty cv::Mat for
+ *   packed formats. Like image2Mat_shared(), the result must not
+ *   outlive the image memory.
+ *
+ * - yuv2Mat() converts to the same cv::Mat types and channel orders as
+ *   image2Mat(). 3 and 4 channels 8-bit results are computed by one
+ *   cv::cvtColor() pass straight from the planes (BT.601, as OpenCV
+ *   does), without an intermediate RGB image; other depths are
+ *   converted afterwards.
+ *
+ * - The overload taking dst writes into it when it already has the
+ *   required size and type, so a view over an existing buffer (e.g.
+ *   the bits of a QImage::Format_RGB32 image, MCO_BGRA on little
+ *   endian systems) receives the pixels without further copy. It
+ *   returns false, leaving dst untouched, if the image is invalid.
+ */
+cv::Mat yuv2Gray_shared(const YuvImage &yuv);
+cv::Mat yuv2Mat(const YuvImage &yuv, int requiredMatType = CV_8UC3, MatColorOrder requiredOrder=MCO_BGR);
+bool yuv2Mat(const YuvImage &yuv, cv::Mat &dst, int requiredMatType = CV_8UC3, MatColorOrder requiredOrder=MCO_BGR);
+
 } //namespace QtOcv
 
 #endif // CVMATANDQIMAGE_H
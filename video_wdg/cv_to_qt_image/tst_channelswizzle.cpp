@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include "channelswizzle.h"
+#include "cvmatandqimage.h"
+
+using namespace QtOcv;
+
+namespace {
+const SwizzleIsa kIsas[] = {SwizzleIsa::Scalar, SwizzleIsa::SSSE3, SwizzleIsa::AVX2};
+
+// Эталон: перестановка каналов через cv::mixChannels, как в прежней реализации
+cv::Mat referenceSwizzle(const cv::Mat& src, const uint8_t order[4]) {
+    cv::Mat dst(src.rows, src.cols, src.type());
+    int from_to[] = {order[0], 0, order[1], 1, order[2], 2, order[3], 3};
+    cv::mixChannels(&src, 1, &dst, 1, from_to, 4);
+    return dst;
+}
+
+cv::Mat randomMat(int rows, int cols, int type) {
+    cv::Mat mat(rows, cols, type);
+    cv::randu(mat, cv::Scalar::all(0), cv::Scalar::all(256));
+    return mat;
+}
+
+bool matsEqual(const cv::Mat& a, const cv::Mat& b) {
+    return a.size() == b.size() && a.type() == b.type() && cv::norm(a, b, cv::NORM_INF) == 0;
+}
+}
+
+// Все ядра побитово совпадают с mixChannels для всех перестановок, длин строк (включая хвосты) и смещений
+TEST(TChannelSwizzleTest, MatchesMixChannelsForAllOrders) {
+    const cv::Mat src = randomMat(1, 67 + 3, CV_8UC4);
+    for (SwizzleIsa isa : kIsas) {
+        if (!isSwizzleIsaSupported(isa)) {
+            continue;
+        }
+        for (int o = 0; o < 256; ++o) {
+            const uint8_t order[4] = {uint8_t(o & 3), uint8_t((o >> 2) & 3), uint8_t((o >> 4) & 3), uint8_t((o >> 6) & 3)};
+            for (int offset = 0; offset < 3; ++offset) {
+                for (int pixels = 1; pixels <= 67; ++pixels) {
+                    const cv::Mat row = src(cv::Rect(offset, 0, pixels, 1));
+                    cv::Mat dst(1, pixels, CV_8UC4, cv::Scalar::all(0xAB));
+                    swizzle4(row.ptr<uint8_t>(), dst.ptr<uint8_t>(), pixels, order, isa);
+                    ASSERT_TRUE(matsEqual(dst, referenceSwizzle(row, order)))
+                        << "isa " << static_cast<unsigned int>(isa) << " order " << o << " pixels " << pixels;
+                }
+            }
+        }
+    }
+}
+
+// Перестановка на месте дает тот же результат
+TEST(TChannelSwizzleTest, WorksInPlace) {
+    const uint8_t order[4] = {2, 1, 0, 3};
+    const cv::Mat src = randomMat(37, 101, CV_8UC4);
+    const cv::Mat expected = referenceSwizzle(src, order);
+    for (SwizzleIsa isa : kIsas) {
+        if (!isSwizzleIsaSupported(isa)) {
+            continue;
+        }
+        cv::Mat mat = src.clone();
+        swizzle4(mat.ptr<uint8_t>(), mat.ptr<uint8_t>(), mat.total(), order, isa);
+        EXPECT_TRUE(matsEqual(mat, expected)) << "isa " << static_cast<unsigned int>(isa);
+    }
+}
+
+// Автовыбор ядра совпадает с эталоном на кадре Full HD
+TEST(TChannelSwizzleTest, DispatchMatchesReference) {
+    EXPECT_TRUE(isSwizzleIsaSupported(bestSwizzleIsa()));
+    const uint8_t order[4] = {3, 2, 1, 0};
+    const cv::Mat src = randomMat(1080, 1920, CV_8UC4);
+    cv::Mat dst(src.size(), src.type());
+    swizzle4(src.ptr<uint8_t>(), dst.ptr<uint8_t>(), src.total(), order);
+    EXPECT_TRUE(matsEqual(dst, referenceSwizzle(src, order)));
+}
+
+// Преобразования cvmatandqimage с перестановкой каналов совпадают с прежними путями mixChannels/cvtColor
+TEST(TChannelSwizzleTest, ConversionsMatchPreviousImplementation) {
+    // Не непрерывная матрица: строки обрабатываются по одной
+    const cv::Mat full = randomMat(481, 643, CV_8UC4);
+    const cv::Mat src = full(cv::Rect(1, 1, 641, 479));
+    ASSERT_FALSE(src.isContinuous());
+
+    cv::Mat bgra;
+    {
+        int from_to[] = {0, 3, 1, 2, 2, 1, 3, 0};
+        bgra = cv::Mat(src.size(), src.type());
+        cv::mixChannels(&src, 1, &bgra, 1, from_to, 4);
+    }
+    // ARGB ==> BGRA (QImage::Format_ARGB32 на little endian)
+    QImage argbImage = mat2Image(src, MCO_ARGB, QImage::Format_ARGB32);
+    EXPECT_TRUE(matsEqual(image2Mat_shared(argbImage), bgra));
+
+    // ARGB ==> RGBA
+    cv::Mat rgba;
+    {
+        int from_to[] = {0, 3, 1, 0, 2, 1, 3, 2};
+        rgba = cv::Mat(src.size(), src.type());
+        cv::mixChannels(&src, 1, &rgba, 1, from_to, 4);
+    }
+    QImage rgbaImage = mat2Image(src, MCO_ARGB, QImage::Format_RGBA8888);
+    EXPECT_TRUE(matsEqual(image2Mat_shared(rgbaImage), rgba));
+
+    // RGBA ==> ARGB
+    cv::Mat argb;
+    {
+        int from_to[] = {0, 1, 1, 2, 2, 3, 3, 0};
+        argb = cv::Mat(src.size(), src.type());
+        cv::mixChannels(&rgba, 1, &argb, 1, from_to, 4);
+    }
+    EXPECT_TRUE(matsEqual(image2Mat(rgbaImage, CV_8UC4, MCO_ARGB), argb));
+
+    // BGRA <==> RGBA
+    cv::Mat swapped;
+    cv::cvtColor(src, swapped, cv::COLOR_BGRA2RGBA);
+    QImage bgraImage = mat2Image(src, MCO_BGRA, QImage::Format_RGBA8888);
+    EXPECT_TRUE(matsEqual(image2Mat_shared(bgraImage), swapped));
+
+    // Глубина 32F идет через mixChannels и тоже совпадает
+    cv::Mat src32f;
+    src.convertTo(src32f, CV_32FC4, 1 / 255.0);
+    const uint8_t order[4] = {3, 2, 1, 0};
+    QImage image32f = mat2Image(src32f, MCO_ARGB, QImage::Format_ARGB32);
+    EXPECT_TRUE(matsEqual(image2Mat_shared(image32f), referenceSwizzle(src, order)));
+}
@@ -0,0 +1,324 @@
+#include <gtest/gtest.h>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <utility>
+#include <vector>
+#include "cvmatandqimage.h"
+
+using namespace QtOcv;
+
+namespace {
+// Буфер изображения с функцией очистки, отмечающей освобождение
+struct TrackedBuffer {
+    std::vector<uchar> data;
+    bool released = false;
+};
+
+void releaseTracked(void* info) {
+    static_cast<TrackedBuffer*>(info)->released = true;
+}
+
+// Случайный YUV 4:2:0 кадр в непрерывной раскладке I420: плоскость Y, затем U и V
+cv::Mat randomI420(int width, int height) {
+    cv::Mat mat(height * 3 / 2, width, CV_8UC1);
+    cv::randu(mat, cv::Scalar::all(0), cv::Scalar::all(256));
+    return mat;
+}
+
+YuvImage yuvImage(YuvFormat format, int width, int height) {
+    YuvImage yuv = {format, width, height, {nullptr, nullptr, nullptr}, {0, 0, 0}};
+    return yuv;
+}
+
+bool matsEqual(const cv::Mat& a, const cv::Mat& b) {
+    return a.size() == b.size() && a.type() == b.type() && cv::norm(a, b, cv::NORM_INF) == 0;
+}
+
+QImage trackedImage(TrackedBuffer& buffer, int width, int height, QImage::Format format) {
+    const int bytesPerLine = width * 4;
+    buffer.data.assign(size_t(bytesPerLine) * height, 0);
+    for (size_t i = 0; i < buffer.data.size(); ++i) {
+        buffer.data[i] = static_cast<uchar>(i * 7);
+    }
+    return QImage(buffer.data.data(), width, height, bytesPerLine, format, releaseTracked, &buffer);
+}
+}
+
+// cv::Mat из image2Mat_refcounted продлевает жизнь данных QImage до освобождения последней копии
+TEST(TCvMatAndQImageTest, MatKeepsImageDataAlive) {
+    TrackedBuffer buffer;
+    cv::Mat roi;
+    {
+        QImage img = trackedImage(buffer, 64, 32, QImage::Format_RGB32);
+        MatColorOrder order;
+        cv::Mat mat = image2Mat_refcounted(img, &order);
+        ASSERT_FALSE(mat.empty());
+        EXPECT_EQ(mat.type(), CV_8UC4);
+        EXPECT_EQ(order, MCO_BGRA);
+        // Без копирования
+        EXPECT_EQ(mat.data, buffer.data.data());
+        EXPECT_EQ(mat.step, size_t(64 * 4));
+        roi = mat(cv::Rect(8, 4, 16, 8));
+    }
+    // Изображение и исходная матрица уничтожены, подматрица еще держит данные
+    EXPECT_FALSE(buffer.released);
+    EXPECT_EQ(roi.at<cv::Vec4b>(0, 0)[0], static_cast<uchar>((4 * 64 * 4 + 8 * 4) * 7));
+    cv::Mat copy = roi;
+    roi.release();
+    EXPECT_FALSE(buffer.released);
+    copy.release();
+    EXPECT_TRUE(buffer.released);
+}
+
+// Запись через cv::Mat видна в QImage, которое делит с ним данные
+TEST(TCvMatAndQImageTest, MatWritesIntoImage) {
+    QImage img(16, 16, QImage::Format_Grayscale8);
+    img.fill(0);
+    cv::Mat mat = image2Mat_refcounted(img);
+    ASSERT_EQ(mat.type(), CV_8UC1);
+    mat.at<uchar>(3, 5) = 200;
+    EXPECT_EQ(img.constScanLine(3)[5], 200);
+}
+
+// Неподдерживаемый формат дает пустую матрицу
+TEST(TCvMatAndQImageTest, UnsupportedImageFormat) {
+    QImage img(16, 16, QImage::Format_RGB16);
+    img.fill(0);
+    EXPECT_TRUE(image2Mat_refcounted(img).empty());
+    EXPECT_TRUE(image2Mat_refcounted(QImage()).empty());
+}
+
+// QImage из mat2Image_refcounted держит ссылку на данные cv::Mat до функции очистки
+TEST(TCvMatAndQImageTest, ImageKeepsMatDataAlive) {
+    cv::Mat mat(24, 40, CV_8UC3);
+    cv::randu(mat, cv::Scalar::all(0), cv::Scalar::all(256));
+    const cv::Mat expected = mat.clone();
+    cv::UMatData* u = mat.u;
+    ASSERT_NE(u, nullptr);
+
+    QImage img = mat2Image_refcounted(mat);
+    ASSERT_FALSE(img.isNull());
+    EXPECT_EQ(img.format(), QImage::Format_RGB888);
+    EXPECT_EQ(img.constBits(), mat.data);
+    EXPECT_EQ(u->refcount, 2);
+
+    const uchar* data = mat.data;
+    mat.release();
+    // Запись в изображение не копирует данные
+    img.bits()[0] = static_cast<uchar>(expected.data[0] + 1);
+    EXPECT_EQ(img.constBits(), data);
+    EXPECT_EQ(u->refcount, 1);
+    for (int y = 0; y < expected.rows; ++y) {
+        const uchar* line = img.constScanLine(y);
+        for (int x = y == 0 ? 1 : 0; x < expected.cols * 3; ++x) {
+            ASSERT_EQ(line[x], expected.ptr<uchar>(y)[x]) << "at " << x << "," << y;
+        }
+    }
+}
+
+// Копия QImage освобождает матрицу вместе с последней ссылкой
+TEST(TCvMatAndQImageTest, ImageCopiesShareMat) {
+    cv::Mat mat(8, 8, CV_8UC4, cv::Scalar(1, 2, 3, 4));
+    cv::UMatData* u = mat.u;
+    QImage copy;
+    {
+        QImage img = mat2Image_refcounted(mat, QImage::Format_RGB32);
+        EXPECT_EQ(img.format(), QImage::Format_RGB32);
+        copy = img;
+        EXPECT_EQ(u->refcount, 2);
+    }
+    EXPECT_EQ(u->refcount, 2);
+    copy = QImage();
+    EXPECT_EQ(u->refcount, 1);
+}
+
+// Одноканальная матрица по умолчанию дает Indexed8 с серой палитрой
+TEST(TCvMatAndQImageTest, GrayMatToIndexed8) {
+    cv::Mat mat(4, 4, CV_8UC1, cv::Scalar(77));
+    QImage img = mat2Image_refcounted(mat);
+    ASSERT_EQ(img.format(), QImage::Format_Indexed8);
+    ASSERT_EQ(img.colorCount(), 256);
+    EXPECT_EQ(img.pixel(1, 1), qRgb(77, 77, 77));
+    EXPECT_EQ(mat2Image_refcounted(mat, QImage::Format_Grayscale8).format(), QImage::Format_Grayscale8);
+}
+
+// Кадр проходит QImage -> cv::Mat -> QImage без копий, промежуточные объекты можно уничтожить
+TEST(TCvMatAndQImageTest, RoundTripWithoutCopies) {
+    TrackedBuffer buffer;
+    QImage result;
+    {
+        QImage img = trackedImage(buffer, 32, 16, QImage::Format_ARGB32);
+        cv::Mat mat = image2Mat_refcounted(img);
+        result = mat2Image_refcounted(mat, QImage::Format_ARGB32);
+    }
+    EXPECT_FALSE(buffer.released);
+    EXPECT_EQ(result.constBits(), buffer.data.data());
+    result = QImage();
+    EXPECT_TRUE(buffer.released);
+}
+
+// Y плоскость отдается без копирования, упакованные форматы ее не имеют
+TEST(TCvMatAndQImageTest, YuvGrayShared) {
+    const cv::Mat i420 = randomI420(64, 48);
+    YuvImage yuv = yuvImage(YUV_I420, 64, 48);
+    yuv.planes[0] = i420.data;
+    yuv.planes[1] = i420.data + 64 * 48;
+    yuv.planes[2] = i420.data + 64 * 48 * 5 / 4;
+    yuv.steps[0] = 64;
+    yuv.steps[1] = yuv.steps[2] = 32;
+    const cv::Mat gray = yuv2Gray_shared(yuv);
+    ASSERT_EQ(gray.type(), CV_8UC1);
+    EXPECT_EQ(gray.data, i420.data);
+    EXPECT_EQ(gray.size(), cv::Size(64, 48));
+    EXPECT_TRUE(matsEqual(yuv2Mat(yuv, CV_8UC1), i420.rowRange(0, 48)));
+
+    YuvImage packed = yuvImage(YUV_YUYV, 32, 48);
+    packed.planes[0] = i420.data;
+    packed.steps[0] = 64;
+    EXPECT_TRUE(yuv2Gray_shared(packed).empty());
+    // Яркость упакованного формата - каждый второй байт
+    const cv::Mat luma = yuv2Mat(packed, CV_8UC1);
+    ASSERT_EQ(luma.size(), cv::Size(32, 48));
+    EXPECT_EQ(luma.at<uchar>(5, 7), i420.at<uchar>(5, 14));
+}
+
+// Все 4:2:0 форматы совпадают с cv::cvtColor по непрерывному буферу, в том числе при строках с выравниванием
+TEST(TCvMatAndQImageTest, Yuv420MatchesCvtColor) {
+    const int width = 40;
+    const int height = 30;  // высота не кратна 4
+    const int pad = 24;
+    const cv::Mat i420 = randomI420(width, height);
+    const uchar* y = i420.data;
+    const uchar* u = y + width * height;
+    const uchar* v = u + width * height / 4;
+
+    // Те же плоскости с выравниванием строк
+    cv::Mat yPadded(height, width + pad, CV_8UC1, cv::Scalar(0));
+    cv::Mat uPadded(height / 2, width / 2 + pad, CV_8UC1, cv::Scalar(0));
+    cv::Mat vPadded(height / 2, width / 2 + pad, CV_8UC1, cv::Scalar(0));
+    cv::Mat(height, width, CV_8UC1, const_cast<uchar*>(y)).copyTo(yPadded.colRange(0, width));
+    cv::Mat(height / 2, width / 2, CV_8UC1, const_cast<uchar*>(u)).copyTo(uPadded.colRange(0, width / 2));
+    cv::Mat(height / 2, width / 2, CV_8UC1, const_cast<uchar*>(v)).copyTo(vPadded.colRange(0, width / 2));
+
+    const struct {
+        int type;
+        MatColorOrder order;
+        int code;
+    } cases[] = {
+        {CV_8UC3, MCO_BGR, cv::COLOR_YUV2BGR_I420},
+        {CV_8UC3, MCO_RGB, cv::COLOR_YUV2RGB_I420},
+        {CV_8UC4, MCO_BGRA, cv::COLOR_YUV2BGRA_I420},
+        {CV_8UC4, MCO_RGBA, cv::COLOR_YUV2RGBA_I420},
+    };
+    for (const auto& c : cases) {
+        cv::Mat expected;
+        cv::cvtColor(i420, expected, c.code);
+
+        YuvImage contiguous = yuvImage(YUV_I420, width, height);
+        contiguous.planes[0] = y;
+        contiguous.planes[1] = u;
+        contiguous.planes[2] = v;
+        contiguous.steps[0] = width;
+        contiguous.steps[1] = contiguous.steps[2] = width / 2;
+        EXPECT_TRUE(matsEqual(yuv2Mat(contiguous, c.type, c.order), expected)) << c.code;
+
+        YuvImage padded = yuvImage(YUV_I420, width, height);
+        padded.planes[0] = yPadded.data;
+        padded.planes[1] = uPadded.data;
+        padded.planes[2] = vPadded.data;
+        padded.steps[0] = yPadded.step;
+        padded.steps[1] = uPadded.step;
+        padded.steps[2] = vPadded.step;
+        EXPECT_TRUE(matsEqual(yuv2Mat(padded, c.type, c.order), expected)) << c.code;
+
+        // YV12: V перед U
+        YuvImage yv12 = padded;
+        yv12.format = YUV_YV12;
+        std::swap(yv12.planes[1], yv12.planes[2]);
+        EXPECT_TRUE(matsEqual(yuv2Mat(yv12, c.type, c.order), expected)) << c.code;
+
+        // NV12 / NV21: чередующиеся плоскости цветности в отдельном буфере
+        cv::Mat uv(height / 2, width / 2, CV_8UC2);
+        cv::Mat vu(height / 2, width / 2, CV_8UC2);
+        const cv::Mat uPlane(height / 2, width / 2, CV_8UC1, const_cast<uchar*>(u));
+        const cv::Mat vPlane(height / 2, width / 2, CV_8UC1, const_cast<uchar*>(v));
+        const cv::Mat uvPlanes[] = {uPlane, vPlane};
+        const cv::Mat vuPlanes[] = {vPlane, uPlane};
+        cv::merge(uvPlanes, 2, uv);
+        cv::merge(vuPlanes, 2, vu);
+        YuvImage nv12 = yuvImage(YUV_NV12, width, height);
+        nv12.planes[0] = yPadded.data;
+        nv12.steps[0] = yPadded.step;
+        nv12.planes[1] = uv.data;
+        nv12.steps[1] = uv.step;
+        EXPECT_TRUE(matsEqual(yuv2Mat(nv12, c.type, c.order), expected)) << c.code;
+        YuvImage nv21 = nv12;
+        nv21.format = YUV_NV21;
+        nv21.planes[1] = vu.data;
+        EXPECT_TRUE(matsEqual(yuv2Mat(nv21, c.type, c.order), expected)) << c.code;
+    }
+}
+
+// Упакованные 4:2:2 форматы совпадают с cv::cvtColor
+TEST(TCvMatAndQImageTest, PackedYuvMatchesCvtColor) {
+    cv::Mat yuyv(20, 32, CV_8UC2);
+    cv::randu(yuyv, cv::Scalar::all(0), cv::Scalar::all(256));
+    YuvImage yuv = yuvImage(YUV_YUYV, 32, 20);
+    yuv.planes[0] = yuyv.data;
+    yuv.steps[0] = yuyv.step;
+    cv::Mat expected;
+    cv::cvtColor(yuyv, expected, cv::COLOR_YUV2BGR_YUYV);
+    EXPECT_TRUE(matsEqual(yuv2Mat(yuv), expected));
+
+    yuv.format = YUV_UYVY;
+    cv::cvtColor(yuyv, expected, cv::COLOR_YUV2RGBA_UYVY);
+    EXPECT_TRUE(matsEqual(yuv2Mat(yuv, CV_8UC4, MCO_RGBA), expected));
+}
+
+// Результат пишется прямо в буфер QImage, порядок ARGB и другие глубины тоже поддерживаются
+TEST(TCvMatAndQImageTest, YuvIntoImageBuffer) {
+    const cv::Mat i420 = randomI420(16, 8);
+    YuvImage yuv = yuvImage(YUV_I420, 16, 8);
+    yuv.planes[0] = i420.data;
+    yuv.planes[1] = i420.data + 16 * 8;
+    yuv.planes[2] = i420.data + 16 * 8 * 5 / 4;
+    yuv.steps[0] = 16;
+    yuv.steps[1] = yuv.steps[2] = 8;
+    cv::Mat bgra;
+    cv::cvtColor(i420, bgra, cv::COLOR_YUV2BGRA_I420);
+
+    QImage img(16, 8, QImage::Format_RGB32);
+    cv::Mat view(img.height(), img.width(), CV_8UC4, img.bits(), img.bytesPerLine());
+    ASSERT_TRUE(yuv2Mat(yuv, view, CV_8UC4, MCO_BGRA));
+    EXPECT_EQ(view.data, img.constBits());
+    EXPECT_TRUE(matsEqual(image2Mat_shared(img), bgra));
+
+    const uint8_t order[] = {3, 2, 1, 0};
+    cv::Mat argb(bgra.size(), bgra.type());
+    int from_to[] = {order[0], 0, order[1], 1, order[2], 2, order[3], 3};
+    cv::mixChannels(&bgra, 1, &argb, 1, from_to, 4);
+    EXPECT_TRUE(matsEqual(yuv2Mat(yuv, CV_8UC4, MCO_ARGB), argb));
+
+    cv::Mat bgr;
+    cv::Mat expected16u;
+    cv::cvtColor(i420, bgr, cv::COLOR_YUV2BGR_I420);
+    bgr.convertTo(expected16u, CV_16UC3, 255.0);
+    EXPECT_TRUE(matsEqual(yuv2Mat(yuv, CV_16UC3), expected16u));
+}
+
+// Нечетная ширина или отсутствующая плоскость дают ошибку и не трогают dst
+TEST(TCvMatAndQImageTest, InvalidYuv) {
+    const cv::Mat i420 = randomI420(16, 8);
+    YuvImage yuv = yuvImage(YUV_NV12, 15, 8);
+    yuv.planes[0] = yuv.planes[1] = i420.data;
+    yuv.steps[0] = yuv.steps[1] = 16;
+    cv::Mat dst(2, 2, CV_8UC3, cv::Scalar::all(7));
+    EXPECT_FALSE(yuv2Mat(yuv, dst));
+    EXPECT_EQ(dst.size(), cv::Size(2, 2));
+    EXPECT_TRUE(yuv2Mat(yuv).empty());
+    EXPECT_TRUE(yuv2Gray_shared(yuv).empty());
+
+    yuv.width = 16;
+    yuv.planes[1] = nullptr;
+    EXPECT_FALSE(yuv2Mat(yuv, dst));
+}
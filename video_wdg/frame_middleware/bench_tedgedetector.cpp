@@ -0,0 +1,62 @@
+#include <benchmark/benchmark.h>
+#include <QImage>
+#include <QPainter>
+#include "tedgedetector.h"
+
+namespace {
+// Синтетический кадр с контрастными фигурами, как в tst_tedgedetector
+QImage makeTestFrame(int width, int height) {
+    QImage img(width, height, QImage::Format_RGB32);
+    img.fill(Qt::gray);
+    QPainter painter(&img);
+    painter.setPen(Qt::NoPen);
+    const int stepX = width / 16;
+    const int stepY = height / 9;
+    for (int y = 0; y + stepY <= height; y += stepY) {
+        for (int x = 0; x + stepX <= width; x += stepX) {
+            painter.setBrush(((x / stepX + y / stepY) % 2) ? Qt::black : Qt::white);
+            painter.drawEllipse(x + stepX / 8, y + stepY / 8, stepX * 3 / 4, stepY * 3 / 4);
+        }
+    }
+    painter.end();
+    return img;
+}
+
+void silentMessageHandler(QtMsgType, const QMessageLogContext&, const QString&) {}
+
+// Обработка кадра width x height; восстановление исходного кадра не входит в замер
+void BM_ProcessFrame(benchmark::State& state, TEdgeDetector::Mode mode) {
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    TEdgeDetector detector(100, 200, mode);
+    const QImage source = makeTestFrame(width, height);
+    QImage work;
+    for (auto _ : state) {
+        state.PauseTiming();
+        work = source.copy();
+        state.ResumeTiming();
+        detector.processFrame(&work);
+        benchmark::DoNotOptimize(work.constBits());
+    }
+    state.SetBytesProcessed(state.iterations() * source.sizeInBytes());
+}
+BENCHMARK_CAPTURE(BM_ProcessFrame, Debug, TEdgeDetector::Mode::Debug)
+    ->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160})->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ProcessFrame, Production, TEdgeDetector::Mode::Production)
+    ->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160})->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ProcessFrame, Parallel, TEdgeDetector::Mode::Parallel)
+    ->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160})->Unit(benchmark::kMillisecond);
+}
+
+int main(int argc, char** argv)
+{
+    // Режим Debug пишет в лог каждый шаг каждого кадра
+    qInstallMessageHandler(silentMessageHandler);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -10,6 +10,11 @@
 #define IFRAMEMIDDLEWARE_H
 
 #include <QImage>
+#include <QPainter>
+#include <QRect>
+#include <opencv2/core.hpp>
+
+#include "video_wdg/frame_packet/tframepacket.h"
 
 /*!
  * \class IFrameMiddleware
@@ -18,7 +23,9 @@
  * The `IFrameMiddleware` class is a pure virtual interface that defines the contract for classes that process video frames
  * represented as `QImage` objects. Derived classes must implement the `processFrame` method to apply specific image
  * processing operations, such as edge detection or filtering. This interface is designed to be used in a video processing
- * pipeline, allowing modular and extensible frame manipulation.
+ * pipeline, allowing modular and extensible frame manipulation. Middleware that only needs the luma of a frame can opt in
+ * to `processLuma`, which receives the Y plane of native camera frames without any colour conversion. When a region of
+ * interest is set, the chain calls `processRoi` instead and the rest of the frame passes through unchanged.
  */
 class IFrameMiddleware
 {
@@ -37,12 +44,77 @@ public:
      */
     virtual void processFrame(QImage* img) = 0;
 
+    /*!
+     * \brief Processes a frame packet.
+     * \param packet The packet holding the frame.
+     *
+     * Entry point used by the processing chain. The default implementation converts a native frame to image, if
+     * needed, and calls processFrame() on it. The packet metadata must be left unchanged.
+     */
+    virtual void processPacket(TFramePacket& packet) { processFrame(&packet.convertToImage()); }
+
+    /*!
+     * \brief Processes a region of interest of a frame packet.
+     * \param packet The packet holding the frame.
+     * \param roi The region in frame pixels, lying inside the frame.
+     *
+     * Pixels outside `roi` must be left unchanged. The default implementation runs processFrame() on a copy of the
+     * region and draws the result back; middleware that can work on the frame buffer directly should override it.
+     */
+    virtual void processRoi(TFramePacket& packet, const QRect& roi) {
+        QImage& img = packet.convertToImage();
+        QImage region = img.copy(roi);
+        processFrame(&region);
+        if (region.size() != roi.size()) {
+            return;
+        }
+        QPainter painter(&img);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.drawImage(roi.topLeft(), region);
+    }
+
+    /*!
+     * \brief Checks if the middleware can process the luma of a frame.
+     * \return True if processLuma() is implemented. Default is false.
+     */
+    virtual bool acceptsLuma() const { return false; }
+
+    /*!
+     * \brief Processes the luma of a video frame.
+     * \param luma Single-channel 8-bit luma of the frame. May alias the frame memory and must not be modified.
+     * \param img Pointer to the QImage receiving the result.
+     *
+     * Called instead of processFrame() when acceptsLuma() returns true and the frame luma is available natively.
+     */
+    virtual void processLuma(const cv::Mat& luma, QImage* img) { Q_UNUSED(luma); Q_UNUSED(img); }
+
+    /*!
+     * \brief Retrieves the name of the middleware.
+     * \return The name used for the stage in frame traces. Must stay valid for the lifetime of the program.
+     */
+    virtual const char* name() const { return "middleware"; }
+
+    /*!
+     * \brief Marks the middleware as optional.
+     * \param optional If true, the chain may bypass the middleware when it runs out of time.
+     */
+    void setOptional(bool optional) { optional_ = optional; }
+
+    /*!
+     * \brief Checks if the middleware is optional.
+     * \return True if the chain may bypass it under load. Default is false.
+     */
+    bool isOptional() const { return optional_; }
+
     /*!
      * \brief Virtual destructor.
      *
      * Ensures proper cleanup in derived classes.
      */
     virtual ~IFrameMiddleware() = default;
+
+private:
+    bool optional_ = false; ///< Flag indicating if the middleware may be bypassed under load.
 };
 
 #endif // IFRAMEMIDDLEWARE_H
@@ -0,0 +1,96 @@
+/** @file
+ *
+ * TVideoWdg - SimpleMeasurementByVideoTool
+ * By Ilia.belou <ilia.belou@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef IMATFRAMEMIDDLEWARE_H
+#define IMATFRAMEMIDDLEWARE_H
+
+#include <opencv2/core.hpp>
+
+#include "iframemiddleware.h"
+
+/*!
+ * \class IMatFrameMiddleware
+ * \brief Abstract interface for processing video frames as OpenCV matrices in place.
+ *
+ * The `IMatFrameMiddleware` class is a pure virtual interface for middleware that works on `cv::Mat`. Instead of
+ * converting each frame from `QImage` to `cv::Mat` and back, the derived class receives a `CV_8UC4` view (B G R A
+ * channel order on little endian systems) that aliases the pixel buffer of the frame packet, and writes its result
+ * into the same view. Chained matrix middleware therefore shares one buffer and the frame is displayed without any
+ * conversion. Calls through the `QImage` entry point of `IFrameMiddleware` are adapted to the matrix view, so such
+ * middleware can still be used wherever a `QImage` middleware is expected. A region of interest is handed over as a
+ * submatrix of the same view, so only its pixels are touched and nothing is copied.
+ */
+class IMatFrameMiddleware : public IFrameMiddleware
+{
+public:
+    /*!
+     * \brief Processes a video frame in place.
+     * \param frame `CV_8UC4` view of the frame buffer.
+     *
+     * Must be implemented by derived classes. The result must be written into `frame`, keeping its size and type,
+     * so that the view keeps aliasing the frame buffer. The view may be a submatrix of a larger frame.
+     */
+    virtual void processMat(cv::Mat& frame) = 0;
+
+    /*!
+     * \brief Processes a frame packet through its matrix view.
+     * \param packet The packet holding the frame.
+     */
+    void processPacket(TFramePacket& packet) override {
+        cv::Mat view = matView(packet.convertToImage());
+        if (!view.empty()) {
+            processMat(view);
+        }
+    }
+
+    /*!
+     * \brief Processes a region of interest of a frame packet through a submatrix of its view.
+     * \param packet The packet holding the frame.
+     * \param roi The region in frame pixels, lying inside the frame.
+     */
+    void processRoi(TFramePacket& packet, const QRect& roi) override {
+        cv::Mat view = matView(packet.convertToImage());
+        if (!view.empty()) {
+            cv::Mat region = view(cv::Rect(roi.x(), roi.y(), roi.width(), roi.height()));
+            processMat(region);
+        }
+    }
+
+    /*!
+     * \brief Processes a video frame through its matrix view.
+     * \param img Pointer to the QImage to be processed.
+     *
+     * Adapter for callers of the `QImage` interface. The image is converted to `Format_RGB32` first if needed.
+     */
+    void processFrame(QImage* img) override {
+        if (img == nullptr) return;
+        cv::Mat view = matView(*img);
+        if (!view.empty()) {
+            processMat(view);
+        }
+    }
+
+    /*!
+     * \brief Creates a `CV_8UC4` view of an image buffer.
+     * \param img The image. Converted to `Format_RGB32` in place unless it is already a 32-bit RGB format.
+     * \return Matrix aliasing the image pixels, or an empty matrix for a null image.
+     */
+    static cv::Mat matView(QImage& img) {
+        if (img.isNull()) {
+            return cv::Mat();
+        }
+        if (img.format() != QImage::Format_RGB32
+                && img.format() != QImage::Format_ARGB32
+                && img.format() != QImage::Format_ARGB32_Premultiplied) {
+            img = img.convertToFormat(QImage::Format_RGB32);
+        }
+        return cv::Mat(img.height(), img.width(), CV_8UC4, img.bits(), img.bytesPerLine());
+    }
+};
+
+#endif // IMATFRAMEMIDDLEWARE_H
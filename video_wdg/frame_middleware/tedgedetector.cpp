@@ -1,12 +1,43 @@
 #include "tedgedetector.h"
 
-TEdgeDetector::TEdgeDetector(double thr1, double thr2) :
+#include <algorithm>
+
+namespace {
+
+/*!
+ * \brief Runs a function on every stripe of a frame on the OpenCV thread pool.
+ * \param rows The frame height in rows.
+ * \param stripes The number of stripes.
+ * \param fn Callable taking the stripe index, its first row and the row past its end.
+ */
+template<typename Fn>
+void forEachStripe(int rows, int stripes, const Fn& fn)
+{
+    cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; ++i) {
+            fn(i, rows * i / stripes, rows * (i + 1) / stripes);
+        }
+    });
+}
+
+} // namespace
+
+TEdgeDetector::TEdgeDetector(double thr1, double thr2, Mode mode) :
     thr1_(thr1),
-    thr2_(thr2)
+    thr2_(thr2),
+    mode_(mode)
 {}
 
 void TEdgeDetector::processFrame(QImage *img)
 {
+    if (mode_ != Mode::Debug) {
+        cv::Mat view = matView(*img);
+        if (!view.empty()) {
+            processMat(view);
+        }
+        return;
+    }
+
     if (img->isNull()) {
         qDebug() << "Null QImage";
         return;
@@ -51,10 +82,110 @@ void TEdgeDetector::processFrame(QImage *img)
     }
     qDebug() << "Gray size:" << gray.cols << "x" << gray.rows << "type:" << gray.type();
 
+    detectEdges(gray, img);
+}
+
+void TEdgeDetector::processMat(cv::Mat &frame)
+{
+    if (mode_ == Mode::Production) {
+        if (frame.empty() || frame.type() != CV_8UC4) return;
+        cv::cvtColor(frame, gray_, cv::COLOR_BGRA2GRAY);
+        cv::GaussianBlur(gray_, blurred_, cv::Size(5, 5), 0);
+        cv::Canny(blurred_, edges_, thr1_, thr2_);
+        cv::cvtColor(edges_, frame, cv::COLOR_GRAY2BGRA);
+        return;
+    }
+
+    if (mode_ == Mode::Parallel) {
+        if (frame.empty() || frame.type() != CV_8UC4) return;
+        const int stripes = stripeCount(frame.rows);
+        gray_.create(frame.size(), CV_8UC1);
+        forEachStripe(frame.rows, stripes, [&](int, int r0, int r1) {
+            cv::Mat gray = gray_.rowRange(r0, r1);
+            cv::cvtColor(frame.rowRange(r0, r1), gray, cv::COLOR_BGRA2GRAY);
+        });
+        blurStripes(gray_, blurred_);
+        cv::Canny(blurred_, edges_, thr1_, thr2_);
+        forEachStripe(frame.rows, stripes, [&](int, int r0, int r1) {
+            cv::Mat out = frame.rowRange(r0, r1);
+            cv::cvtColor(edges_.rowRange(r0, r1), out, cv::COLOR_GRAY2BGRA);
+        });
+        return;
+    }
+
+    if (frame.empty() || frame.type() != CV_8UC4) {
+        qDebug() << "Unsupported frame cv::Mat";
+        return;
+    }
+    cv::Mat gray;
+    cv::cvtColor(frame, gray, cv::COLOR_BGRA2GRAY);
     cv::GaussianBlur(gray, gray, cv::Size(5, 5), 0);
     cv::Mat edges;
     cv::Canny(gray, edges, thr1_, thr2_);
-    cv::cvtColor(edges, processed, cv::COLOR_GRAY2BGRA);
+    // Same size and type: writes into the aliased frame buffer.
+    cv::cvtColor(edges, frame, cv::COLOR_GRAY2BGRA);
+}
+
+void TEdgeDetector::processLuma(const cv::Mat &luma, QImage *img)
+{
+    if (mode_ != Mode::Debug) {
+        if (luma.empty() || luma.type() != CV_8UC1) return;
+        if (mode_ == Mode::Parallel) {
+            blurStripes(luma, blurred_);
+        } else {
+            cv::GaussianBlur(luma, blurred_, cv::Size(5, 5), 0);
+        }
+        // Reuse the packet buffer when it already holds an edge map of this size.
+        if (img->width() != luma.cols || img->height() != luma.rows || img->format() != QImage::Format_Grayscale8) {
+            *img = QImage(luma.cols, luma.rows, QImage::Format_Grayscale8);
+        }
+        cv::Mat edges(img->height(), img->width(), CV_8UC1, img->bits(), img->bytesPerLine());
+        cv::Canny(blurred_, edges, thr1_, thr2_);
+        return;
+    }
+
+    if (luma.empty() || luma.type() != CV_8UC1) {
+        qDebug() << "Unsupported luma cv::Mat";
+        return;
+    }
+    detectEdges(luma, img);
+}
 
-    *img = QtOcv::mat2Image(edges);
+void TEdgeDetector::detectEdges(const cv::Mat &gray, QImage *img)
+{
+    cv::Mat blurred;
+    cv::GaussianBlur(gray, blurred, cv::Size(5, 5), 0);
+    cv::Mat edges;
+    cv::Canny(blurred, edges, thr1_, thr2_);
+
+    // The image takes over the edge map buffer, no copy.
+    *img = QtOcv::mat2Image_refcounted(edges, QImage::Format_Grayscale8);
+}
+
+int TEdgeDetector::stripeCount(int rows) const
+{
+    int count = stripeCount_ > 0 ? stripeCount_ : cv::getNumThreads();
+    return std::max(1, std::min(count, rows / EDGE_MIN_STRIPE_ROWS));
+}
+
+void TEdgeDetector::blurStripes(const cv::Mat &gray, cv::Mat &blurred)
+{
+    const int stripes = stripeCount(gray.rows);
+    if (stripes == 1) {
+        cv::GaussianBlur(gray, blurred, cv::Size(5, 5), 0);
+        return;
+    }
+    blurred.create(gray.size(), CV_8UC1);
+    if (stripes_.size() < static_cast<size_t>(stripes)) {
+        stripes_.resize(stripes);
+    }
+    forEachStripe(gray.rows, stripes, [&](int i, int r0, int r1) {
+        const int top = std::max(0, r0 - EDGE_BLUR_RADIUS);
+        const int bottom = std::min(gray.rows, r1 + EDGE_BLUR_RADIUS);
+        // Isolated: the overlap rows are real neighbours, the frame edges are reflected as in the serial blur.
+        cv::GaussianBlur(gray.rowRange(top, bottom), stripes_[i], cv::Size(5, 5), 0, 0,
+                         cv::BORDER_DEFAULT | cv::BORDER_ISOLATED);
+        cv::Mat out = blurred.rowRange(r0, r1);
+        stripes_[i].rowRange(r0 - top, r1 - top).copyTo(out);
+    });
 }
@@ -13,42 +13,130 @@
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/videoio.hpp>
+#include <vector>
 
-#include "iframemiddleware.h"
+#include "imatframemiddleware.h"
 #include "video_wdg/cv_to_qt_image/cvmatandqimage.h"
 
+constexpr int EDGE_BLUR_RADIUS = 2;         ///< Radius of the 5x5 Gaussian kernel, overlap between stripes in rows.
+constexpr int EDGE_MIN_STRIPE_ROWS = 32;    ///< Minimum height of a stripe in Mode::Parallel.
+
 /*!
  * \class TEdgeDetector
  * \brief Frame middleware for applying Canny edge detection to video frames.
  *
- * The `TEdgeDetector` class implements the `IFrameMiddleware` interface to perform edge detection on video frames using
+ * The `TEdgeDetector` class implements the `IMatFrameMiddleware` interface to perform edge detection on video frames using
  * OpenCV's Canny algorithm. It converts input `QImage` frames to OpenCV `cv::Mat`, applies grayscale conversion, Gaussian
  * blur, and Canny edge detection, then converts the result back to a `QImage`. The class supports configurable thresholds
  * for the Canny algorithm and ensures input images are in a compatible format (`Format_RGB32` or `Format_ARGB32`).
+ * When the native luma of a camera frame is available it is used directly, skipping the colour conversions. In a
+ * processing chain the matrix entry point is used, which writes the edges back into the shared frame buffer.
+ *
+ * In `Mode::Production` the detector does no logging and keeps its intermediate matrices between frames, so after the
+ * first frame of a given size it allocates nothing of its own; the `QImage` entry point then also writes the edges
+ * into the input buffer (as `Format_RGB32`) instead of replacing the image. `Mode::Debug` keeps the original,
+ * step-by-step logged behaviour.
+ *
+ * `Mode::Parallel` works like `Mode::Production` but splits the frame into horizontal stripes processed on the OpenCV
+ * thread pool. The stripes of the blur overlap by the kernel radius, so the stitched result matches the serial one
+ * bit for bit. Canny runs on the whole stitched frame, because its hysteresis step follows edges across stripe
+ * boundaries.
  */
-class TEdgeDetector : public IFrameMiddleware
+class TEdgeDetector : public IMatFrameMiddleware
 {
 public:
+    /*!
+     * \brief Enumeration for processing modes.
+     */
+    enum class Mode : uint {
+        Debug,      ///< Log each step and work on temporary copies.
+        Production, ///< No logging, persistent scratch buffers, edges written in place.
+        Parallel    ///< As Production, with the per-pixel stages split into stripes across all cores.
+    };
+
     /*!
      * \brief Constructs a TEdgeDetector instance.
      * \param thr1 The first threshold for the Canny edge detection (default is 100.0).
      * \param thr2 The second threshold for the Canny edge detection (default is 200.0).
+     * \param mode The processing mode (default is Mode::Debug).
      *
      * Initializes the edge detector with the specified thresholds for the Canny algorithm.
      */
-    TEdgeDetector(double thr1 = 100.0,double thr2 = 200.0);
+    TEdgeDetector(double thr1 = 100.0,double thr2 = 200.0, Mode mode = Mode::Debug);
 
     /*!
      * \brief Processes a video frame by applying Canny edge detection.
      * \param img Pointer to the QImage to be processed.
      *
      * Converts the input image to `Format_RGB32` if necessary, applies grayscale conversion, Gaussian blur,
-     * and Canny edge detection, then updates the image with the detected edges.
+     * and Canny edge detection, then updates the image with the detected edges. In Mode::Debug the image is replaced
+     * by a grayscale edge image; in Mode::Production the edges are written into the image buffer.
      */
     void processFrame(QImage* img) override;
+
+    /*!
+     * \brief Applies Canny edge detection to a video frame in place.
+     * \param frame `CV_8UC4` view of the frame buffer, replaced by the detected edges (white on black).
+     */
+    void processMat(cv::Mat& frame) override;
+
+    /*!
+     * \brief Reports that edge detection only needs the luma of a frame.
+     * \return Always true.
+     */
+    bool acceptsLuma() const override { return true; }
+
+    /*!
+     * \brief Applies Canny edge detection to the luma of a video frame.
+     * \param luma Single-channel 8-bit luma of the frame.
+     * \param img Pointer to the QImage receiving the detected edges.
+     */
+    void processLuma(const cv::Mat& luma, QImage* img) override;
+
+    /*!
+     * \brief Retrieves the name of the middleware.
+     * \return "edge detector".
+     */
+    const char* name() const override { return "edge detector"; }
+
+    /*!
+     * \brief Sets the number of stripes used in Mode::Parallel.
+     * \param count Number of stripes, 0 to use one stripe per thread of the OpenCV thread pool.
+     */
+    void setStripeCount(int count) { stripeCount_ = count; }
 private:
     double thr1_ = 100.0; ///< First threshold for Canny edge detection.
     double thr2_ = 200.0; ///< Second threshold for Canny edge detection.
+    Mode mode_ = Mode::Debug; ///< Processing mode.
+    cv::Mat gray_;        ///< Grayscale scratch buffer (Mode::Production).
+    cv::Mat blurred_;     ///< Blurred scratch buffer (Mode::Production).
+    cv::Mat edges_;       ///< Edge map scratch buffer (Mode::Production).
+    int stripeCount_ = 0; ///< Number of stripes in Mode::Parallel, 0 for automatic.
+    std::vector<cv::Mat> stripes_; ///< Per-stripe blur buffers including the overlap rows (Mode::Parallel).
+
+    /*!
+     * \brief Applies Gaussian blur and Canny edge detection to a grayscale image.
+     * \param gray Single-channel 8-bit input image (not modified).
+     * \param img Pointer to the QImage receiving the detected edges as `Format_Grayscale8`.
+     */
+    void detectEdges(const cv::Mat& gray, QImage* img);
+
+    /*!
+     * \brief Computes the number of stripes for a frame.
+     * \param rows The frame height in rows.
+     * \return Number of stripes, at least 1.
+     */
+    int stripeCount(int rows) const;
+
+    /*!
+     * \brief Applies the 5x5 Gaussian blur stripe by stripe.
+     * \param gray Single-channel 8-bit input image.
+     * \param blurred Output image, same size as `gray`.
+     *
+     * Each stripe is blurred together with `EDGE_BLUR_RADIUS` rows of its neighbours and only its own rows are
+     * copied out, so every output pixel sees exactly the input of the serial blur.
+     */
+    void blurStripes(const cv::Mat& gray, cv::Mat& blurred);
 };
 
 #endif // TEDGEDETECTOR_H
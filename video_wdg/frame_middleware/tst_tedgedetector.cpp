@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <QImage>
 #include <QPainter>
+#include <cstring>
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 #include "tedgedetector.h"
@@ -101,6 +102,180 @@ TEST_F(TEdgeDetectorTest, EdgeDetectionOutput) {
     EXPECT_TRUE(hasEdges) << "Edges should be detected in the processed image";
 }
 
+// Обработка cv::Mat на месте, без смены буфера
+TEST_F(TEdgeDetectorTest, ProcessMatInPlace) {
+    QImage img(100, 100, QImage::Format_RGB32);
+    img.fill(Qt::white);
+    QPainter painter(&img);
+    painter.fillRect(40, 40, 20, 20, Qt::black);
+    painter.end();
+
+    cv::Mat view = IMatFrameMiddleware::matView(img);
+    const uchar* data = view.data;
+    detector->processMat(view);
+
+    EXPECT_EQ(view.data, data) << "Result must be written into the aliased buffer";
+    EXPECT_EQ(view.type(), CV_8UC4);
+    EXPECT_EQ(img.format(), QImage::Format_RGB32);
+    EXPECT_EQ(img.constBits(), data);
+
+    // Результат совпадает с обработкой через QImage
+    QImage reference(100, 100, QImage::Format_RGB32);
+    reference.fill(Qt::white);
+    QPainter refPainter(&reference);
+    refPainter.fillRect(40, 40, 20, 20, Qt::black);
+    refPainter.end();
+    detector->processFrame(&reference);
+    ASSERT_EQ(reference.size(), img.size());
+    for (int y = 0; y < img.height(); ++y) {
+        for (int x = 0; x < img.width(); ++x) {
+            ASSERT_EQ(qGray(img.pixel(x, y)), qGray(reference.pixel(x, y))) << "at " << x << "," << y;
+        }
+    }
+}
+
+namespace {
+// Синтетический кадр с контрастными фигурами
+QImage makeTestFrame(int width, int height) {
+    QImage img(width, height, QImage::Format_RGB32);
+    img.fill(Qt::gray);
+    QPainter painter(&img);
+    painter.setPen(Qt::NoPen);
+    const int stepX = width / 16;
+    const int stepY = height / 9;
+    for (int y = 0; y + stepY <= height; y += stepY) {
+        for (int x = 0; x + stepX <= width; x += stepX) {
+            painter.setBrush(((x / stepX + y / stepY) % 2) ? Qt::black : Qt::white);
+            painter.drawEllipse(x + stepX / 8, y + stepY / 8, stepX * 3 / 4, stepY * 3 / 4);
+        }
+    }
+    painter.end();
+    return img;
+}
+
+// Простейшая middleware на QImage: инвертирует пиксели
+class TInvertMiddleware : public IFrameMiddleware
+{
+public:
+    void processFrame(QImage* img) override { img->invertPixels(); }
+};
+
+// Проверка: внутри ROI ожидаемый результат, снаружи исходный кадр
+void expectRoiResult(const QImage& result, const QImage& source, const QImage& expectedRoi, const QRect& roi) {
+    ASSERT_EQ(result.size(), source.size());
+    for (int y = 0; y < source.height(); ++y) {
+        for (int x = 0; x < source.width(); ++x) {
+            const QRgb expected = roi.contains(x, y) ? expectedRoi.pixel(x - roi.x(), y - roi.y()) : source.pixel(x, y);
+            ASSERT_EQ(qRed(result.pixel(x, y)), qRed(expected)) << "at " << x << "," << y;
+            ASSERT_EQ(qGreen(result.pixel(x, y)), qGreen(expected)) << "at " << x << "," << y;
+            ASSERT_EQ(qBlue(result.pixel(x, y)), qBlue(expected)) << "at " << x << "," << y;
+        }
+    }
+}
+}
+
+// ROI на матричной middleware: обрабатывается только область, остальное не трогается
+TEST(TEdgeDetectorRoiTest, MatMiddlewareProcessesOnlyRoi) {
+    const QImage source = makeTestFrame(640, 480);
+    const QRect roi(100, 80, 200, 150);
+
+    TEdgeDetector detector(100, 200, TEdgeDetector::Mode::Production);
+    TFramePacketPtr packet = TFramePacketPtr::create();
+    packet->image = source.copy();
+    detector.processRoi(*packet, roi);
+
+    TEdgeDetector reference(100, 200, TEdgeDetector::Mode::Production);
+    QImage expected = source.copy(roi);
+    reference.processFrame(&expected);
+
+    expectRoiResult(packet->image, source, expected, roi);
+}
+
+// ROI на QImage middleware: реализация по умолчанию через копию области
+TEST(TEdgeDetectorRoiTest, ImageMiddlewareProcessesOnlyRoi) {
+    const QImage source = makeTestFrame(320, 240);
+    const QRect roi(10, 20, 50, 60);
+
+    TInvertMiddleware invert;
+    TFramePacketPtr packet = TFramePacketPtr::create();
+    packet->image = source.copy();
+    invert.processRoi(*packet, roi);
+
+    QImage expected = source.copy(roi);
+    expected.invertPixels();
+
+    expectRoiResult(packet->image, source, expected, roi);
+}
+
+// Режим Production дает тот же результат, что и Debug
+TEST(TEdgeDetectorProductionTest, MatchesDebugOutput) {
+    TEdgeDetector debug(100, 200, TEdgeDetector::Mode::Debug);
+    TEdgeDetector production(100, 200, TEdgeDetector::Mode::Production);
+    QImage source = makeTestFrame(320, 240);
+
+    QImage debugImg = source.copy();
+    debug.processFrame(&debugImg);
+    // Несколько кадров подряд: буферы переиспользуются
+    QImage productionImg;
+    for (int i = 0; i < 3; ++i) {
+        productionImg = source.copy();
+        production.processFrame(&productionImg);
+    }
+
+    ASSERT_EQ(debugImg.size(), productionImg.size());
+    EXPECT_EQ(productionImg.format(), QImage::Format_RGB32);
+    for (int y = 0; y < debugImg.height(); ++y) {
+        for (int x = 0; x < debugImg.width(); ++x) {
+            ASSERT_EQ(qGray(debugImg.pixel(x, y)), qGray(productionImg.pixel(x, y))) << "at " << x << "," << y;
+        }
+    }
+}
+
+// Режим Parallel совпадает с последовательным режимом бит в бит
+TEST(TEdgeDetectorParallelTest, MatchesSerialBitExact) {
+    // Нечетные размеры: границы полос не кратны высоте кадра
+    const QSize sizes[] = {QSize(1920, 1080), QSize(641, 479), QSize(160, 97)};
+    const int stripeCounts[] = {0, 2, 7};
+
+    for (const QSize& size : sizes) {
+        QImage source = makeTestFrame(size.width(), size.height());
+        cv::Mat sourceView = IMatFrameMiddleware::matView(source);
+        cv::Mat noise(sourceView.size(), CV_8UC4);
+        cv::theRNG().state = 12345;
+        cv::randu(noise, 0, 48);
+        sourceView += noise;
+
+        TEdgeDetector serial(100, 200, TEdgeDetector::Mode::Production);
+        QImage serialImg = source.copy();
+        cv::Mat serialView = IMatFrameMiddleware::matView(serialImg);
+        serial.processMat(serialView);
+
+        cv::Mat luma;
+        cv::cvtColor(sourceView, luma, cv::COLOR_BGRA2GRAY);
+        QImage serialLuma;
+        serial.processLuma(luma, &serialLuma);
+
+        for (int stripes : stripeCounts) {
+            TEdgeDetector parallel(100, 200, TEdgeDetector::Mode::Parallel);
+            parallel.setStripeCount(stripes);
+
+            QImage parallelImg = source.copy();
+            cv::Mat parallelView = IMatFrameMiddleware::matView(parallelImg);
+            parallel.processMat(parallelView);
+            EXPECT_EQ(cv::norm(serialView, parallelView, cv::NORM_INF), 0)
+                << size.width() << "x" << size.height() << ", stripes " << stripes;
+
+            QImage parallelLuma;
+            parallel.processLuma(luma, &parallelLuma);
+            ASSERT_EQ(serialLuma.size(), parallelLuma.size());
+            for (int y = 0; y < serialLuma.height(); ++y) {
+                ASSERT_EQ(std::memcmp(serialLuma.constScanLine(y), parallelLuma.constScanLine(y), serialLuma.width()), 0)
+                    << "row " << y << ", stripes " << stripes;
+            }
+        }
+    }
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,155 @@
+#include "tframepacket.h"
+#include <QSysInfo>
+
+#include "video_wdg/frame_providers/tvideoframeview.h"
+
+QImage &TFramePacket::ensureImage(int width, int height, QImage::Format format)
+{
+    if (image.width() != width || image.height() != height || image.format() != format) {
+        image = QImage(width, height, format);
+    }
+    return image;
+}
+
+QImage &TFramePacket::convertToImage()
+{
+    if (videoFrame.isValid()) {
+        bool converted = false;
+        {
+            TVideoFrameView view(videoFrame);
+            if (view.canConvertToColor()) {
+                QImage& dst = ensureImage(videoFrame.width(), videoFrame.height(), QImage::Format_RGB32);
+                cv::Mat mat(dst.height(), dst.width(), CV_8UC4, dst.bits(), dst.bytesPerLine());
+                converted = view.convertToColor(mat, QSysInfo::ByteOrder == QSysInfo::LittleEndian ? QtOcv::MCO_BGRA
+                                                                                                   : QtOcv::MCO_ARGB);
+            }
+        }
+        if (!converted) {
+            image = videoFrame.toImage();
+        }
+        videoFrame = QVideoFrame();
+    }
+    return image;
+}
+
+void TFramePacket::addRef()
+{
+    refs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TFramePacket::release()
+{
+    if (refs_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    if (!pool_) {
+        delete this;
+        return;
+    }
+    // The pool may be destroyed together with this packet when the local reference goes away.
+    std::shared_ptr<TFramePacketPool> pool = std::move(pool_);
+    pool->recycle(this);
+}
+
+TFramePacketPtr::TFramePacketPtr(const TFramePacketPtr &other) :
+    packet_(other.packet_)
+{
+    if (packet_) {
+        packet_->addRef();
+    }
+}
+
+TFramePacketPtr::TFramePacketPtr(TFramePacketPtr &&other) noexcept :
+    packet_(other.packet_)
+{
+    other.packet_ = nullptr;
+}
+
+TFramePacketPtr &TFramePacketPtr::operator=(const TFramePacketPtr &other)
+{
+    if (other.packet_) {
+        other.packet_->addRef();
+    }
+    reset();
+    packet_ = other.packet_;
+    return *this;
+}
+
+TFramePacketPtr &TFramePacketPtr::operator=(TFramePacketPtr &&other) noexcept
+{
+    if (this != &other) {
+        reset();
+        packet_ = other.packet_;
+        other.packet_ = nullptr;
+    }
+    return *this;
+}
+
+TFramePacketPtr::~TFramePacketPtr()
+{
+    reset();
+}
+
+TFramePacketPtr TFramePacketPtr::create()
+{
+    TFramePacket* packet = new TFramePacket;
+    packet->refs_ = 1;
+    packet->captureTime = TFramePacket::Clock::now();
+    packet->trace.clear();
+    return TFramePacketPtr(packet);
+}
+
+void TFramePacketPtr::reset()
+{
+    if (packet_) {
+        TFramePacket* packet = packet_;
+        packet_ = nullptr;
+        packet->release();
+    }
+}
+
+TFramePacketPool::TFramePacketPool(int sourceId) :
+    sourceId_(sourceId)
+{}
+
+TFramePacketPtr TFramePacketPool::acquire()
+{
+    TFramePacket* packet = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(poolmtx_);
+        if (free_.empty()) {
+            packets_.push_back(std::unique_ptr<TFramePacket>(new TFramePacket));
+            free_.reserve(packets_.size());
+            packet = packets_.back().get();
+        } else {
+            packet = free_.back();
+            free_.pop_back();
+        }
+    }
+    packet->pool_ = shared_from_this();
+    packet->refs_ = 1;
+    packet->captureTime = TFramePacket::Clock::now();
+    packet->trace.clear();
+    packet->sequence = nextSequence_++;
+    packet->sourceId = sourceId_;
+    return TFramePacketPtr(packet);
+}
+
+size_t TFramePacketPool::size() const
+{
+    std::lock_guard<std::mutex> lock(poolmtx_);
+    return packets_.size();
+}
+
+void TFramePacketPool::recycle(TFramePacket *packet)
+{
+    // Give the camera buffer back right away, keep the image buffer for reuse.
+    packet->videoFrame = QVideoFrame();
+    if (packet->isPreview) {
+        // Providers write full-resolution frames into image, keep that buffer there.
+        packet->image.swap(packet->fullImage);
+        packet->isPreview = false;
+    }
+    std::lock_guard<std::mutex> lock(poolmtx_);
+    free_.push_back(packet);
+}
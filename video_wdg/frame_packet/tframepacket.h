@@ -0,0 +1,203 @@
+/** @file
+ *
+ * TVideoWdg - SimpleMeasurementByVideoTool
+ * By Ilia.belou <ilia.belou@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef TFRAMEPACKET_H
+#define TFRAMEPACKET_H
+
+#include <QImage>
+#include <QVideoFrame>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "tframetrace.h"
+
+class TFramePacketPool;
+
+/*!
+ * \class TFramePacket
+ * \brief A video frame with its capture metadata, exchanged between providers, middleware and display.
+ *
+ * The `TFramePacket` class carries a frame either as a displayable `QImage` or as the native `QVideoFrame` of the
+ * camera, together with its capture timestamp, sequence number and source id. Packets are reference counted through
+ * `TFramePacketPtr` and are normally obtained from a `TFramePacketPool`: when the last reference is released the
+ * packet goes back to its pool and keeps its image buffer, so a stream with a constant frame size reuses the same
+ * buffers and does not allocate per frame. For display at a reduced size the frame can be replaced by a downsampled
+ * preview; the full-resolution frame is then kept in `fullImage`. Every stage that handles the packet leaves a mark in
+ * its `trace`, so the latency of a frame can be broken down from capture to presentation.
+ */
+class TFramePacket
+{
+public:
+    using Clock = std::chrono::steady_clock;   ///< Clock used for frame timestamps.
+
+    QImage image;                               ///< Frame in a displayable format.
+    QVideoFrame videoFrame;                     ///< Native frame awaiting conversion to image, invalid if image is up to date.
+    Clock::time_point captureTime{};            ///< Time the frame was captured.
+    uint64_t sequence = 0;                      ///< Sequence number of the frame within its source.
+    int sourceId = -1;                          ///< Id of the provider that captured the frame.
+    QImage fullImage;                           ///< Full-resolution frame while image holds a preview.
+    bool isPreview = false;                     ///< True if image is a downsampled preview of fullImage.
+    TFrameTrace trace;                          ///< End times of the stages the frame went through since capture.
+
+    ~TFramePacket() = default;
+    TFramePacket(const TFramePacket&) = delete;
+    TFramePacket& operator=(const TFramePacket&) = delete;
+
+    /*!
+     * \brief Prepares the image buffer for a frame of the given geometry.
+     * \param width The frame width in pixels.
+     * \param height The frame height in pixels.
+     * \param format The frame image format.
+     * \return Reference to the image, whose buffer can be written in place.
+     *
+     * Reuses the current buffer if the geometry matches, otherwise allocates a new one.
+     */
+    QImage& ensureImage(int width, int height, QImage::Format format);
+
+    /*!
+     * \brief Converts the native frame to image, if needed.
+     * \return Reference to the up to date image.
+     *
+     * BT.601 limited range YUV and 32-bit RGB frames are converted in one pass into the reused image buffer
+     * (`Format_RGB32`); other colour spaces and ranges, e.g. BT.709 or full range, and other formats go through
+     * `QVideoFrame::toImage()`, which follows the surface format.
+     */
+    QImage& convertToImage();
+
+    /*!
+     * \brief Retrieves the full-resolution size of the frame.
+     * \return Size of fullImage for a preview, of image otherwise.
+     */
+    QSize frameSize() const { return isPreview ? fullImage.size() : image.size(); }
+
+private:
+    friend class TFramePacketPtr;
+    friend class TFramePacketPool;
+
+    TFramePacket() = default;
+
+    /*!
+     * \brief Adds a reference to the packet.
+     */
+    void addRef();
+
+    /*!
+     * \brief Releases a reference, returning the packet to its pool (or deleting it) when it was the last one.
+     */
+    void release();
+
+    std::atomic<int> refs_{0};                  ///< Reference count.
+    std::shared_ptr<TFramePacketPool> pool_;    ///< Pool the packet returns to, empty while the packet is pooled.
+};
+
+/*!
+ * \class TFramePacketPtr
+ * \brief Shared handle to a TFramePacket.
+ *
+ * Copying the handle adds a reference without allocating. The packet is recycled when the last handle is destroyed.
+ */
+class TFramePacketPtr
+{
+public:
+    /*!
+     * \brief Constructs an empty handle.
+     */
+    TFramePacketPtr() = default;
+    TFramePacketPtr(const TFramePacketPtr& other);
+    TFramePacketPtr(TFramePacketPtr&& other) noexcept;
+    TFramePacketPtr& operator=(const TFramePacketPtr& other);
+    TFramePacketPtr& operator=(TFramePacketPtr&& other) noexcept;
+    ~TFramePacketPtr();
+
+    /*!
+     * \brief Creates a packet that is not backed by a pool.
+     * \return Handle to the new packet.
+     */
+    static TFramePacketPtr create();
+
+    TFramePacket* get() const { return packet_; }
+    TFramePacket* operator->() const { return packet_; }
+    TFramePacket& operator*() const { return *packet_; }
+    explicit operator bool() const { return packet_ != nullptr; }
+
+    /*!
+     * \brief Retrieves the number of handles referencing the packet.
+     * \return The reference count, 0 for an empty handle. Only a hint while other threads hold handles.
+     */
+    int useCount() const { return packet_ ? packet_->refs_.load(std::memory_order_relaxed) : 0; }
+
+    /*!
+     * \brief Releases the referenced packet and empties the handle.
+     */
+    void reset();
+
+private:
+    friend class TFramePacketPool;
+
+    /*!
+     * \brief Constructs a handle adopting a reference that was already counted.
+     * \param packet The packet.
+     */
+    explicit TFramePacketPtr(TFramePacket* packet) : packet_(packet) {}
+
+    TFramePacket* packet_ = nullptr;            ///< Referenced packet.
+};
+
+/*!
+ * \class TFramePacketPool
+ * \brief Pool of reusable frame packets for a single source.
+ *
+ * The `TFramePacketPool` class hands out packets stamped with the source id, the next sequence number and the current
+ * time. Packets that come back keep their image buffers. The pool grows on demand, so after warm-up it holds as many
+ * packets as are in flight at once and acquiring one does not allocate. It must be owned by a `std::shared_ptr`;
+ * packets in flight keep their pool alive.
+ */
+class TFramePacketPool : public std::enable_shared_from_this<TFramePacketPool>
+{
+public:
+    /*!
+     * \brief Constructs a TFramePacketPool instance.
+     * \param sourceId The id stamped on every packet of the pool.
+     */
+    explicit TFramePacketPool(int sourceId);
+
+    TFramePacketPool(const TFramePacketPool&) = delete;
+    TFramePacketPool& operator=(const TFramePacketPool&) = delete;
+
+    /*!
+     * \brief Acquires a packet for a newly captured frame.
+     * \return Handle to a packet stamped with the source id, the next sequence number and the capture time.
+     */
+    TFramePacketPtr acquire();
+
+    /*!
+     * \brief Retrieves the number of packets owned by the pool.
+     * \return Number of packets, both free and in flight.
+     */
+    size_t size() const;
+
+private:
+    friend class TFramePacket;
+
+    /*!
+     * \brief Returns a released packet to the free list.
+     * \param packet The packet to recycle.
+     */
+    void recycle(TFramePacket* packet);
+
+    int sourceId_;                                          ///< Source id stamped on packets.
+    std::atomic<uint64_t> nextSequence_{0};                 ///< Sequence number of the next packet.
+    mutable std::mutex poolmtx_;                            ///< Mutex protecting the packet lists.
+    std::vector<std::unique_ptr<TFramePacket> > packets_;   ///< All packets owned by the pool.
+    std::vector<TFramePacket*> free_;                       ///< Packets available for reuse.
+};
+
+#endif // TFRAMEPACKET_H
@@ -0,0 +1,79 @@
+/** @file
+ *
+ * TVideoWdg - SimpleMeasurementByVideoTool
+ * By Ilia.belou <ilia.belou@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef TFRAMETRACE_H
+#define TFRAMETRACE_H
+
+#include <array>
+#include <chrono>
+
+constexpr int FRAME_TRACE_MAX_MARKS = 16; ///< Maximum number of stage marks recorded per frame.
+
+/*!
+ * \class TFrameTrace
+ * \brief Timestamps of the processing stages a frame went through.
+ *
+ * The `TFrameTrace` class records a mark at the end of every stage of a frame, from capture to presentation. A stage
+ * lasts from the previous mark, or from the capture time for the first one, to its own mark. Marks are kept in a fixed
+ * array of `FRAME_TRACE_MAX_MARKS` entries, so tracing never allocates; further marks are ignored. Stage names are not
+ * copied and must stay valid for the lifetime of the program, string literals are expected.
+ */
+class TFrameTrace
+{
+public:
+    using Clock = std::chrono::steady_clock;   ///< Clock used for stage timestamps.
+
+    /*!
+     * \brief End of a processing stage.
+     */
+    struct Mark {
+        const char* stage;                      ///< Name of the stage.
+        Clock::time_point time;                 ///< Time the stage ended.
+    };
+
+    /*!
+     * \brief Records the end of a stage at the current time.
+     * \param stage The name of the stage.
+     */
+    void mark(const char* stage) { mark(stage, Clock::now()); }
+
+    /*!
+     * \brief Records the end of a stage.
+     * \param stage The name of the stage.
+     * \param time The time the stage ended.
+     */
+    void mark(const char* stage, Clock::time_point time) {
+        if (count_ < FRAME_TRACE_MAX_MARKS) {
+            marks_[count_++] = Mark{stage, time};
+        }
+    }
+
+    /*!
+     * \brief Removes all marks.
+     */
+    void clear() { count_ = 0; }
+
+    /*!
+     * \brief Retrieves the number of marks.
+     * \return Number of recorded marks.
+     */
+    int size() const { return count_; }
+
+    /*!
+     * \brief Retrieves a mark.
+     * \param idx The index of the mark, in recording order.
+     * \return Reference to the mark.
+     */
+    const Mark& at(int idx) const { return marks_[idx]; }
+
+private:
+    std::array<Mark, FRAME_TRACE_MAX_MARKS> marks_{};  ///< Recorded marks.
+    int count_ = 0;                                     ///< Number of recorded marks.
+};
+
+#endif // TFRAMETRACE_H
@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+#include <QVideoFrameFormat>
+#include "tframepacket.h"
+
+namespace {
+constexpr int WIDTH = 16;
+constexpr int HEIGHT = 8;
+
+// Кадр NV12 одного цвета с заданным цветовым пространством и диапазоном
+QVideoFrame makeNv12Frame(uchar y, QVideoFrameFormat::ColorSpace space, QVideoFrameFormat::ColorRange range) {
+    QVideoFrameFormat format(QSize(WIDTH, HEIGHT), QVideoFrameFormat::Format_NV12);
+    format.setColorSpace(space);
+    format.setColorRange(range);
+    QVideoFrame frame(format);
+    if (!frame.map(QVideoFrame::WriteOnly)) {
+        return QVideoFrame();
+    }
+    for (int row = 0; row < HEIGHT; ++row) {
+        std::memset(frame.bits(0) + row * frame.bytesPerLine(0), y, WIDTH);
+    }
+    for (int row = 0; row < HEIGHT / 2; ++row) {
+        std::memset(frame.bits(1) + row * frame.bytesPerLine(1), 128, WIDTH);
+    }
+    frame.unmap();
+    return frame;
+}
+}
+
+// Копирование добавляет ссылку, перемещение передает ее
+TEST(TFramePacketTest, CopyAndMoveRefCounts) {
+    TFramePacketPtr a = TFramePacketPtr::create();
+    EXPECT_EQ(a.useCount(), 1);
+    {
+        TFramePacketPtr b = a;
+        EXPECT_EQ(a.useCount(), 2);
+        TFramePacketPtr c;
+        c = b;
+        EXPECT_EQ(a.useCount(), 3);
+        TFramePacketPtr d = std::move(c);
+        EXPECT_FALSE(c);
+        EXPECT_EQ(c.useCount(), 0);
+        EXPECT_EQ(d.get(), a.get());
+        EXPECT_EQ(a.useCount(), 3);
+        TFramePacketPtr e;
+        e = std::move(d);
+        EXPECT_FALSE(d);
+        EXPECT_EQ(a.useCount(), 3);
+        // Присваивание самому себе не меняет счетчик
+        e = *&e;
+        EXPECT_EQ(a.useCount(), 3);
+    }
+    EXPECT_EQ(a.useCount(), 1);
+    a.reset();
+    EXPECT_FALSE(a);
+}
+
+// Номера кадров идут подряд, на каждом пакете номер источника пула
+TEST(TFramePacketTest, SequenceNumbering) {
+    auto pool = std::make_shared<TFramePacketPool>(7);
+    for (uint64_t i = 0; i < 5; ++i) {
+        TFramePacketPtr packet = pool->acquire();
+        EXPECT_EQ(packet->sequence, i);
+        EXPECT_EQ(packet->sourceId, 7);
+    }
+    // Пакеты освобождались сразу, пулу хватило одного
+    EXPECT_EQ(pool->size(), 1u);
+}
+
+// Последняя ссылка возвращает пакет в пул, буфер изображения сохраняется
+TEST(TFramePacketTest, RecyclesKeepingImageBuffer) {
+    auto pool = std::make_shared<TFramePacketPool>(0);
+    TFramePacketPtr packet = pool->acquire();
+    TFramePacket* raw = packet.get();
+    const uchar* bits = packet->ensureImage(64, 48, QImage::Format_RGB32).bits();
+    TFramePacketPtr copy = packet;
+    packet.reset();
+    // Пока есть ссылка, пакет не возвращается в пул
+    TFramePacketPtr other = pool->acquire();
+    EXPECT_NE(other.get(), raw);
+    EXPECT_EQ(pool->size(), 2u);
+    other.reset();
+    copy.reset();
+
+    TFramePacketPtr first = pool->acquire();
+    TFramePacketPtr second = pool->acquire();
+    EXPECT_EQ(pool->size(), 2u);
+    TFramePacketPtr& reused = first.get() == raw ? first : second;
+    ASSERT_EQ(reused.get(), raw);
+    EXPECT_EQ(reused->image.constBits(), bits);
+    EXPECT_EQ(reused->ensureImage(64, 48, QImage::Format_RGB32).constBits(), bits);
+}
+
+// Пакет с превью возвращает в image буфер полного разрешения
+TEST(TFramePacketTest, RecycleRestoresFullImage) {
+    auto pool = std::make_shared<TFramePacketPool>(0);
+    TFramePacketPtr packet = pool->acquire();
+    const uchar* fullBits = packet->ensureImage(64, 48, QImage::Format_RGB32).constBits();
+    packet->image.swap(packet->fullImage);
+    packet->isPreview = true;
+    packet->ensureImage(32, 24, QImage::Format_RGB32);
+    packet.reset();
+
+    packet = pool->acquire();
+    EXPECT_FALSE(packet->isPreview);
+    EXPECT_EQ(packet->image.size(), QSize(64, 48));
+    EXPECT_EQ(packet->image.constBits(), fullBits);
+}
+
+// Пул жив, пока есть выданные пакеты, и освобождается вместе с последним
+TEST(TFramePacketTest, PoolOutlivesPackets) {
+    auto pool = std::make_shared<TFramePacketPool>(0);
+    std::weak_ptr<TFramePacketPool> weak = pool;
+    TFramePacketPtr a = pool->acquire();
+    TFramePacketPtr b = pool->acquire();
+    pool.reset();
+    EXPECT_FALSE(weak.expired());
+    a.reset();
+    EXPECT_FALSE(weak.expired());
+    b->ensureImage(16, 16, QImage::Format_RGB32).fill(Qt::black);
+    b.reset();
+    EXPECT_TRUE(weak.expired());
+}
+
+// Одновременное освобождение с двух потоков возвращает пакет в пул ровно один раз
+TEST(TFramePacketTest, ConcurrentRelease) {
+    constexpr int ITERATIONS = 20000;
+    auto pool = std::make_shared<TFramePacketPool>(0);
+    TFramePacketPtr slots[2];
+    std::atomic<int> round{0};
+    std::atomic<int> done{0};
+
+    auto releaser = [&](int index) {
+        for (int i = 1; i <= ITERATIONS; ++i) {
+            while (round.load(std::memory_order_acquire) < i) {
+                std::this_thread::yield();
+            }
+            slots[index].reset();
+            done.fetch_add(1, std::memory_order_acq_rel);
+        }
+    };
+    std::thread first(releaser, 0);
+    std::thread second(releaser, 1);
+    for (int i = 1; i <= ITERATIONS; ++i) {
+        slots[0] = pool->acquire();
+        slots[1] = slots[0];
+        round.store(i, std::memory_order_release);
+        while (done.load(std::memory_order_acquire) < 2 * i) {
+            std::this_thread::yield();
+        }
+    }
+    first.join();
+    second.join();
+
+    // Пакет, возвращенный дважды, выдавался бы двум владельцам сразу
+    const size_t count = pool->size() + 2;
+    std::vector<TFramePacketPtr> packets;
+    std::set<TFramePacket*> distinct;
+    for (size_t i = 0; i < count; ++i) {
+        packets.push_back(pool->acquire());
+        distinct.insert(packets.back().get());
+    }
+    EXPECT_EQ(distinct.size(), count);
+    EXPECT_EQ(pool->size(), count);
+    for (const auto& packet : packets) {
+        EXPECT_EQ(packet.useCount(), 1);
+    }
+}
+
+// Байт X кадра BGRX не определен, в изображении Format_RGB32 альфа всегда 0xFF
+TEST(TFramePacketTest, ConvertsBgrxWithOpaqueAlpha) {
+    QVideoFrame frame(QVideoFrameFormat(QSize(WIDTH, HEIGHT), QVideoFrameFormat::Format_BGRX8888));
+    ASSERT_TRUE(frame.map(QVideoFrame::WriteOnly));
+    for (int row = 0; row < HEIGHT; ++row) {
+        uchar* line = frame.bits(0) + row * frame.bytesPerLine(0);
+        for (int x = 0; x < WIDTH; ++x) {
+            line[4 * x + 0] = 10;
+            line[4 * x + 1] = 20;
+            line[4 * x + 2] = 30;
+            line[4 * x + 3] = 0;
+        }
+    }
+    frame.unmap();
+
+    TFramePacketPtr packet = TFramePacketPtr::create();
+    packet->videoFrame = frame;
+    const QImage& image = packet->convertToImage();
+    ASSERT_EQ(image.format(), QImage::Format_RGB32);
+    EXPECT_EQ(image.pixel(3, 3), qRgba(30, 20, 10, 255));
+}
+
+// Быстрое преобразование только для BT.601 с ограниченным диапазоном, остальное через QVideoFrame::toImage()
+TEST(TFramePacketTest, ConvertsYuvByDeclaredColorSpace) {
+    // Y = 235 - белый в ограниченном диапазоне, в полном диапазоне это светло-серый
+    QVideoFrame limited = makeNv12Frame(235, QVideoFrameFormat::ColorSpace_Undefined,
+                                        QVideoFrameFormat::ColorRange_Unknown);
+    QVideoFrame full = makeNv12Frame(235, QVideoFrameFormat::ColorSpace_BT709, QVideoFrameFormat::ColorRange_Full);
+    ASSERT_TRUE(limited.isValid());
+    ASSERT_TRUE(full.isValid());
+    if (full.toImage().isNull()) {
+        GTEST_SKIP() << "QVideoFrame::toImage() is not available";
+    }
+
+    TFramePacketPtr packet = TFramePacketPtr::create();
+    packet->videoFrame = limited;
+    EXPECT_NEAR(qGray(packet->convertToImage().pixel(WIDTH / 2, HEIGHT / 2)), 255, 2);
+    packet->videoFrame = full;
+    EXPECT_NEAR(qGray(packet->convertToImage().pixel(WIDTH / 2, HEIGHT / 2)), 235, 3);
+}
@@ -0,0 +1,120 @@
+#include "tframebudget.h"
+
+#include <algorithm>
+
+TFrameBudget::TFrameBudget(double budgetMs) :
+    budgetMs_(std::max(1.0, budgetMs))
+{
+    probeFrames_.fill(FRAME_BUDGET_PROBE_FRAMES);
+}
+
+void TFrameBudget::setBudget(double budgetMs)
+{
+    budgetMs_ = std::max(1.0, budgetMs);
+}
+
+bool TFrameBudget::admitFrame(size_t pendingFrames) const
+{
+    return level_ < Level::SkipFrames || pendingFrames == 0;
+}
+
+bool TFrameBudget::addFrameTime(double frameMs)
+{
+    if (hasAverage_) {
+        averageMs_ += FRAME_BUDGET_SMOOTHING * (frameMs - averageMs_);
+    } else {
+        averageMs_ = frameMs;
+        hasAverage_ = true;
+    }
+
+    const size_t index = static_cast<size_t>(level_);
+    ++levelFrames_;
+    if (levelFrames_ == FRAME_BUDGET_DEGRADE_FRAMES && degradedFromMs_ >= 0.0) {
+        // The average has settled on the new level: what it saves is the cost of restoring the level below.
+        savingMs_[index] = std::max(0.0, degradedFromMs_ - averageMs_);
+        degradedFromMs_ = -1.0;
+    }
+    if (levelFrames_ == FRAME_BUDGET_RECOVER_FRAMES && recovered_) {
+        // The restored level holds, the next restore of the level above need not wait long.
+        probeFrames_[index + 1] = FRAME_BUDGET_PROBE_FRAMES;
+    }
+
+    const double allowed = allowance(level_);
+    if (averageMs_ > allowed) {
+        ++overBudgetFrames_;
+        underBudgetFrames_ = 0;
+    } else if (averageMs_ < allowed * FRAME_BUDGET_RECOVER_RATIO) {
+        ++underBudgetFrames_;
+        overBudgetFrames_ = 0;
+    } else {
+        overBudgetFrames_ = 0;
+        underBudgetFrames_ = 0;
+    }
+
+    if (overBudgetFrames_ >= FRAME_BUDGET_DEGRADE_FRAMES && level_ != Level::BypassOptional) {
+        if (recovered_ && levelFrames_ < FRAME_BUDGET_RECOVER_FRAMES) {
+            // The last restore did not hold: wait longer before the next one.
+            probeFrames_[index + 1] = std::min(probeFrames_[index + 1] * 2, FRAME_BUDGET_PROBE_MAX_FRAMES);
+        }
+        const double degradedFromMs = averageMs_;
+        setLevel(static_cast<Level>(index + 1));
+        degradedFromMs_ = degradedFromMs;
+        return true;
+    }
+    if (underBudgetFrames_ >= FRAME_BUDGET_RECOVER_FRAMES && level_ != Level::Full) {
+        const Level lower = static_cast<Level>(index - 1);
+        const bool fits = averageMs_ + savingMs_[index] < allowance(lower) * FRAME_BUDGET_RESTORE_RATIO;
+        if (fits || underBudgetFrames_ >= probeFrames_[index]) {
+            setLevel(lower);
+            recovered_ = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TFrameBudget::reset()
+{
+    averageMs_ = 0.0;
+    hasAverage_ = false;
+    level_ = Level::Full;
+    overBudgetFrames_ = 0;
+    underBudgetFrames_ = 0;
+    levelFrames_ = 0;
+    recovered_ = false;
+    degradedFromMs_ = -1.0;
+    savingMs_.fill(0.0);
+    probeFrames_.fill(FRAME_BUDGET_PROBE_FRAMES);
+}
+
+const char *TFrameBudget::levelName(Level level)
+{
+    switch (level) {
+    case Level::Full:
+        return "Full quality";
+    case Level::SkipFrames:
+        return "Skipping frames";
+    case Level::LowResolution:
+        return "Half resolution";
+    case Level::BypassOptional:
+        return "Optional stages bypassed";
+    }
+    return "";
+}
+
+double TFrameBudget::allowance(Level level) const
+{
+    return level >= Level::SkipFrames ? budgetMs_ * 2 : budgetMs_;
+}
+
+void TFrameBudget::setLevel(Level level)
+{
+    // Measure the new level from scratch.
+    level_ = level;
+    overBudgetFrames_ = 0;
+    underBudgetFrames_ = 0;
+    levelFrames_ = 0;
+    recovered_ = false;
+    degradedFromMs_ = -1.0;
+    hasAverage_ = false;
+}
@@ -0,0 +1,157 @@
+/** @file
+ *
+ * TVideoWdg - SimpleMeasurementByVideoTool
+ * By Ilia.belou <ilia.belou@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef TFRAMEBUDGET_H
+#define TFRAMEBUDGET_H
+
+#include <array>
+#include <cstddef>
+
+constexpr double FRAME_BUDGET_DEFAULT_MS = 33.0;    ///< Default processing time budget per frame in milliseconds.
+constexpr double FRAME_BUDGET_SMOOTHING = 0.2;      ///< Weight of the newest frame in the smoothed frame time.
+constexpr int FRAME_BUDGET_DEGRADE_FRAMES = 5;      ///< Consecutive frames over budget before degrading a level.
+constexpr int FRAME_BUDGET_RECOVER_FRAMES = 30;     ///< Consecutive frames well under budget before recovering a level.
+constexpr double FRAME_BUDGET_RECOVER_RATIO = 0.25; ///< Fraction of the allowance a frame must stay under to recover.
+constexpr double FRAME_BUDGET_RESTORE_RATIO = 0.8;  ///< Fraction of the allowance of the lower level the frame time
+                                                    ///< predicted for it must stay under to recover.
+constexpr int FRAME_BUDGET_PROBE_FRAMES = 4 * FRAME_BUDGET_RECOVER_FRAMES; ///< Frames well under budget after which a
+                                                    ///< level is restored although its predicted time does not fit.
+constexpr int FRAME_BUDGET_PROBE_MAX_FRAMES = 16 * FRAME_BUDGET_PROBE_FRAMES; ///< Longest wait before such a restore.
+
+/*!
+ * \class TFrameBudget
+ * \brief Per-frame time budget deciding how much processing the frames get.
+ *
+ * The `TFrameBudget` class keeps a smoothed processing time of recent frames and compares it with a time budget. When
+ * the smoothed time stays over the allowance for `FRAME_BUDGET_DEGRADE_FRAMES` frames, the degradation level is raised
+ * by one; when it stays under `FRAME_BUDGET_RECOVER_RATIO` of the allowance for `FRAME_BUDGET_RECOVER_FRAMES` frames,
+ * the level is lowered by one. Levels are cumulative: each one keeps the measures of the previous levels. From
+ * Level::SkipFrames on a frame is skipped whenever a newer one is already waiting, so the allowance per processed frame
+ * is twice the budget.
+ *
+ * Recovering a level brings back the cost its measures saved, which the frame time at the lower level no longer shows.
+ * Without hysteresis a level that saves much (e.g. bypassing an expensive optional stage) would be restored, overrun
+ * the budget and be entered again every few dozen frames. So a few frames after each degradation the saving of the new
+ * level is measured, and the level is only recovered once the smoothed time plus that saving stays under
+ * `FRAME_BUDGET_RESTORE_RATIO` of the allowance of the lower level. As the saving may be outdated, a level still gets
+ * restored after `FRAME_BUDGET_PROBE_FRAMES` frames well under budget; each such restore that is followed by a
+ * degradation within `FRAME_BUDGET_RECOVER_FRAMES` frames doubles the wait, up to `FRAME_BUDGET_PROBE_MAX_FRAMES`.
+ *
+ * The class is not thread-safe; it is meant to be used by the processing thread only.
+ */
+class TFrameBudget
+{
+public:
+    /*!
+     * \brief Enumeration for degradation levels.
+     */
+    enum class Level : unsigned int {
+        Full,           ///< Every frame is processed at full quality.
+        SkipFrames,     ///< Frames superseded by a newer queued frame are skipped.
+        LowResolution,  ///< Frames are also processed at half resolution.
+        BypassOptional  ///< Optional processing stages are also bypassed.
+    };
+
+    /*!
+     * \brief Constructs a TFrameBudget instance.
+     * \param budgetMs The processing time budget per frame in milliseconds.
+     */
+    explicit TFrameBudget(double budgetMs = FRAME_BUDGET_DEFAULT_MS);
+
+    /*!
+     * \brief Sets the processing time budget.
+     * \param budgetMs The budget per frame in milliseconds (minimum 1).
+     */
+    void setBudget(double budgetMs);
+
+    /*!
+     * \brief Retrieves the processing time budget.
+     * \return The budget per frame in milliseconds.
+     */
+    double getBudget() const { return budgetMs_; }
+
+    /*!
+     * \brief Decides whether a frame is processed.
+     * \param pendingFrames The number of newer frames already waiting for processing.
+     * \return False if the frame must be skipped in favour of a newer one.
+     */
+    bool admitFrame(size_t pendingFrames) const;
+
+    /*!
+     * \brief Records the processing time of a frame.
+     * \param frameMs The time spent on the frame in milliseconds.
+     * \return True if the degradation level changed.
+     */
+    bool addFrameTime(double frameMs);
+
+    /*!
+     * \brief Retrieves the current degradation level.
+     * \return The level.
+     */
+    Level getLevel() const { return level_; }
+
+    /*!
+     * \brief Retrieves the smoothed processing time per frame.
+     * \return The time in milliseconds.
+     */
+    double getAverageTime() const { return averageMs_; }
+
+    /*!
+     * \brief Checks if frames must be processed at reduced resolution.
+     * \return True from Level::LowResolution on.
+     */
+    bool reduceResolution() const { return level_ >= Level::LowResolution; }
+
+    /*!
+     * \brief Checks if optional stages must be bypassed.
+     * \return True at Level::BypassOptional.
+     */
+    bool bypassOptional() const { return level_ >= Level::BypassOptional; }
+
+    /*!
+     * \brief Resets the level and the statistics.
+     */
+    void reset();
+
+    /*!
+     * \brief Retrieves a display name of a degradation level.
+     * \param level The level.
+     * \return The name.
+     */
+    static const char* levelName(Level level);
+
+private:
+    static constexpr size_t LEVEL_COUNT = static_cast<size_t>(Level::BypassOptional) + 1; ///< Number of levels.
+
+    double budgetMs_;                   ///< Budget per frame in milliseconds.
+    double averageMs_ = 0.0;            ///< Smoothed processing time per frame in milliseconds.
+    bool hasAverage_ = false;           ///< Flag indicating if averageMs_ holds a sample.
+    Level level_ = Level::Full;         ///< Current degradation level.
+    int overBudgetFrames_ = 0;          ///< Consecutive frames over the allowance.
+    int underBudgetFrames_ = 0;         ///< Consecutive frames well under the allowance.
+    int levelFrames_ = 0;               ///< Frames measured since the level changed.
+    bool recovered_ = false;            ///< Whether the level was entered by a recovery.
+    double degradedFromMs_ = -1.0;      ///< Smoothed time before the last degradation until its saving is measured.
+    std::array<double, LEVEL_COUNT> savingMs_{};    ///< Time per frame each level saved over the level below it.
+    std::array<int, LEVEL_COUNT> probeFrames_{};    ///< Frames well under budget before each level is restored anyway.
+
+    /*!
+     * \brief Computes the time allowed per processed frame at a level.
+     * \param level The level.
+     * \return The allowance in milliseconds.
+     */
+    double allowance(Level level) const;
+
+    /*!
+     * \brief Changes the level and restarts the measurement.
+     * \param level The new level.
+     */
+    void setLevel(Level level);
+};
+
+#endif // TFRAMEBUDGET_H
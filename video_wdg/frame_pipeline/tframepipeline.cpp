@@ -0,0 +1,252 @@
+#include "tframepipeline.h"
+#include "video_wdg/frame_providers/tvideoframeview.h"
+
+#include <chrono>
+#include <opencv2/imgproc.hpp>
+
+TFramePipeline::TFramePipeline(QObject *parent)
+    : QObject{parent}
+{}
+
+TFramePipeline::~TFramePipeline()
+{
+    stop();
+}
+
+void TFramePipeline::start()
+{
+    if (isRunning_) return;
+    isRunning_ = true;
+    workerThread_ = QThread::create([this]() { run(); });
+    workerThread_->start();
+}
+
+void TFramePipeline::stop()
+{
+    if (!isRunning_) return;
+    {
+        std::lock_guard<std::mutex> lock(queuemtx_);
+        isRunning_ = false;
+        for (auto& packet : queue_) {
+            packet.reset();
+        }
+        queueSize_ = 0;
+    }
+    queueCond_.notify_all();
+    if (workerThread_) {
+        workerThread_->wait();
+        delete workerThread_;
+        workerThread_ = nullptr;
+    }
+}
+
+void TFramePipeline::submit(TFramePacketPtr packet)
+{
+    if (!packet) return;
+    {
+        std::lock_guard<std::mutex> lock(queuemtx_);
+        if (queueSize_ == queue_.size()) {
+            // Worker is behind: drop the oldest frame instead of waiting.
+            queue_[queueHead_] = std::move(packet);
+            queueHead_ = (queueHead_ + 1) % queue_.size();
+            ++droppedFrames_;
+        } else {
+            queue_[(queueHead_ + queueSize_) % queue_.size()] = std::move(packet);
+            ++queueSize_;
+        }
+    }
+    queueCond_.notify_one();
+}
+
+TFramePacketPtr TFramePipeline::getFrame()
+{
+    output_.consume();
+    return output_.front();
+}
+
+void TFramePipeline::addMiddleware(IFrameMiddleware *middleware)
+{
+    std::lock_guard<std::mutex> lock(middlewaremtx_);
+    fmiddlewares_.push_back(std::shared_ptr<IFrameMiddleware>(middleware));
+}
+
+void TFramePipeline::setRoi(const QRect &roi)
+{
+    std::lock_guard<std::mutex> lock(settingsmtx_);
+    roi_ = roi.normalized();
+}
+
+QRect TFramePipeline::getRoi() const
+{
+    std::lock_guard<std::mutex> lock(settingsmtx_);
+    return roi_;
+}
+
+void TFramePipeline::setPreviewSize(const QSize &size)
+{
+    std::lock_guard<std::mutex> lock(settingsmtx_);
+    previewSize_ = size;
+}
+
+QSize TFramePipeline::getPreviewSize() const
+{
+    std::lock_guard<std::mutex> lock(settingsmtx_);
+    return previewSize_;
+}
+
+void TFramePipeline::setFrameBudget(double budgetMs)
+{
+    std::lock_guard<std::mutex> lock(settingsmtx_);
+    frameBudgetMs_ = budgetMs;
+}
+
+double TFramePipeline::getFrameBudget() const
+{
+    std::lock_guard<std::mutex> lock(settingsmtx_);
+    return frameBudgetMs_;
+}
+
+void TFramePipeline::run()
+{
+    while (true) {
+        TFramePacketPtr packet;
+        size_t pendingFrames = 0;
+        {
+            std::unique_lock<std::mutex> lock(queuemtx_);
+            queueCond_.wait(lock, [this]() { return !isRunning_ || queueSize_ > 0; });
+            if (!isRunning_) return;
+            packet = std::move(queue_[queueHead_]);
+            queueHead_ = (queueHead_ + 1) % queue_.size();
+            --queueSize_;
+            pendingFrames = queueSize_;
+        }
+        packet->trace.mark("queue");
+        budget_.setBudget(getFrameBudget());
+        if (!budget_.admitFrame(pendingFrames)) {
+            ++droppedFrames_;
+            continue;
+        }
+        const auto startTime = std::chrono::steady_clock::now();
+
+        QRect roi = getRoi();
+        QSize previewSize = getPreviewSize();
+        if (budget_.reduceResolution()) {
+            const QSize frameSize = packet->videoFrame.isValid() ? packet->videoFrame.size() : packet->image.size();
+            previewSize = (previewSize.isEmpty() ? frameSize : previewSize) / 2;
+        }
+        if (!previewSize.isEmpty()) {
+            makePreview(*packet, previewSize);
+            packet->trace.mark("preview");
+        }
+        if (packet->isPreview && !roi.isEmpty()) {
+            // The region is given in full-resolution pixels.
+            const double sx = double(packet->image.width()) / packet->fullImage.width();
+            const double sy = double(packet->image.height()) / packet->fullImage.height();
+            roi = QRectF(roi.x() * sx, roi.y() * sy, roi.width() * sx, roi.height() * sy).toAlignedRect();
+        }
+        {
+            // Only copy the chain under the lock: adding or removing middleware must not wait for a whole frame.
+            std::lock_guard<std::mutex> lock(middlewaremtx_);
+            chain_ = fmiddlewares_;
+        }
+        const bool bypassOptional = budget_.bypassOptional();
+        for (const auto& mw : chain_) {
+            if (bypassOptional && mw->isOptional()) {
+                continue;
+            }
+            processMiddleware(mw.get(), *packet, roi);
+            packet->trace.mark(mw->name());
+        }
+        // Release middleware removed during the frame now rather than on the next one.
+        chain_.clear();
+        // Hand over a displayable frame, the GUI thread does no conversion.
+        packet->convertToImage();
+        packet->trace.mark("convert");
+        const double frameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        if (budget_.addFrameTime(frameMs)) {
+            degradationLevel_ = static_cast<unsigned int>(budget_.getLevel());
+            emit degradationLevelChanged(static_cast<int>(budget_.getLevel()));
+        }
+        output_.back() = std::move(packet);
+        bool dropped = output_.publish();
+        output_.back().reset();
+        if (dropped) {
+            ++droppedFrames_;
+        } else {
+            emit frameProcessed();
+        }
+    }
+}
+
+void TFramePipeline::processMiddleware(IFrameMiddleware *middleware, TFramePacket &packet, const QRect &roi)
+{
+    if (!roi.isEmpty()) {
+        const QRect frameRect(QPoint(0, 0), packet.videoFrame.isValid() ? packet.videoFrame.size() : packet.image.size());
+        const QRect region = roi.intersected(frameRect);
+        if (region.isEmpty()) {
+            // Region lies outside of this frame: nothing to process.
+            return;
+        }
+        if (region != frameRect) {
+            middleware->processRoi(packet, region);
+            return;
+        }
+    }
+    if (middleware->acceptsLuma() && packet.videoFrame.isValid()) {
+        // Native luma path: no RGB conversion of the camera frame at all.
+        bool processed = false;
+        {
+            TVideoFrameView view(packet.videoFrame);
+            cv::Mat luma = view.luma();
+            if (!luma.empty()) {
+                middleware->processLuma(luma, &packet.image);
+                processed = true;
+            }
+        }
+        if (processed) {
+            packet.videoFrame = QVideoFrame();
+            return;
+        }
+    }
+    middleware->processPacket(packet);
+}
+
+void TFramePipeline::makePreview(TFramePacket &packet, const QSize &size)
+{
+    const QImage& full = packet.convertToImage();
+    if (full.isNull()) {
+        return;
+    }
+    const QSize target = full.size().scaled(size, Qt::KeepAspectRatio);
+    if (target.isEmpty() || (target.width() >= full.width() && target.height() >= full.height())) {
+        return;
+    }
+    int type = 0;
+    switch (full.format()) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+    case QImage::Format_RGBX8888:
+    case QImage::Format_RGBA8888:
+    case QImage::Format_RGBA8888_Premultiplied:
+        type = CV_8UC4;
+        break;
+    case QImage::Format_RGB888:
+    case QImage::Format_BGR888:
+        type = CV_8UC3;
+        break;
+    case QImage::Format_Grayscale8:
+        type = CV_8UC1;
+        break;
+    default:
+        return;
+    }
+    // The previous preview buffer of this packet, if any, is reused for the new one.
+    packet.image.swap(packet.fullImage);
+    packet.isPreview = true;
+    const QImage& src = packet.fullImage;
+    QImage& dst = packet.ensureImage(target.width(), target.height(), src.format());
+    cv::Mat srcMat(src.height(), src.width(), type, const_cast<uchar*>(src.constBits()), src.bytesPerLine());
+    cv::Mat dstMat(dst.height(), dst.width(), type, dst.bits(), dst.bytesPerLine());
+    cv::resize(srcMat, dstMat, dstMat.size(), 0, 0, cv::INTER_AREA);
+}
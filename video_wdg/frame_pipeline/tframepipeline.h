@@ -0,0 +1,258 @@
+/** @file
+ *
+ * TVideoWdg - SimpleMeasurementByVideoTool
+ * By Ilia.belou <ilia.belou@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef TFRAMEPIPELINE_H
+#define TFRAMEPIPELINE_H
+
+#include <QObject>
+#include <QRect>
+#include <QSize>
+#include <QThread>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "video_wdg/frame_packet/tframepacket.h"
+#include "video_wdg/frame_middleware/iframemiddleware.h"
+#include "video_wdg/frame_providers/ttriplebuffer.h"
+#include "tframebudget.h"
+
+constexpr int FRAME_PIPELINE_QUEUE_SIZE = 2; ///< Capacity of the pipeline input queue in frames.
+
+/*!
+ * \class TFramePipeline
+ * \brief Worker stage running the middleware chain off the GUI thread.
+ *
+ * The `TFramePipeline` class owns the chain of `IFrameMiddleware` processors and runs it on a dedicated worker thread.
+ * Frames are submitted into a bounded input queue of `FRAME_PIPELINE_QUEUE_SIZE` packets; when the worker falls behind
+ * the oldest queued frame is dropped, so submitting never blocks. Finished frames are handed to the consumer through a
+ * lock-free triple buffer and announced with the `frameProcessed` signal. Middleware can be added and removed while
+ * the pipeline is running; the change takes effect on the next frame. The worker runs a snapshot of the chain taken at
+ * the start of each frame, so a change never waits for a frame being processed; a middleware removed meanwhile is
+ * destroyed on the worker thread once that frame is done. When a region of interest is set the chain only
+ * processes that rectangle of each frame and the rest of the frame passes through untouched. When a preview size is
+ * set, larger frames are downsampled once to that size before the chain, so middleware and display only handle the
+ * pixels that are actually shown; the full-resolution frame stays in the packet.
+ *
+ * The time spent on each frame is checked against a `TFrameBudget`. When the chain keeps overrunning the budget the
+ * pipeline degrades step by step: it skips frames that a newer queued frame supersedes, then processes frames at half
+ * resolution, then bypasses optional middleware. It recovers the same way once there is enough headroom, and reports
+ * every change with the `degradationLevelChanged` signal.
+ *
+ * Each frame gets a trace mark when it leaves the queue, after the preview, after every middleware (named by
+ * `IFrameMiddleware::name()`) and after the final conversion to image.
+ */
+class TFramePipeline : public QObject
+{
+    Q_OBJECT
+public:
+    /*!
+     * \brief Constructs a TFramePipeline instance.
+     * \param parent The parent QObject (default is nullptr).
+     */
+    explicit TFramePipeline(QObject* parent = nullptr);
+
+    /*!
+     * \brief Destructor.
+     *
+     * Stops the worker thread.
+     */
+    ~TFramePipeline();
+
+    /*!
+     * \brief Starts the worker thread.
+     */
+    void start();
+
+    /*!
+     * \brief Stops the worker thread, discarding queued frames.
+     */
+    void stop();
+
+    /*!
+     * \brief Submits a frame for processing.
+     * \param packet The packet holding the frame.
+     *
+     * Never blocks. If the input queue is full the oldest queued frame is dropped.
+     */
+    void submit(TFramePacketPtr packet);
+
+    /*!
+     * \brief Checks if a processed frame is ready.
+     * \return True if a frame was processed since the last call to getFrame().
+     */
+    bool isReady() const {
+        return output_.hasNew();
+    }
+
+    /*!
+     * \brief Retrieves the latest processed frame.
+     * \return Handle to the packet, empty if no frame was processed yet.
+     *
+     * Must be called from a single consumer thread.
+     */
+    TFramePacketPtr getFrame();
+
+    /*!
+     * \brief Retrieves the number of frames dropped by the pipeline.
+     * \return Count of frames dropped from the input queue or replaced before retrieval.
+     */
+    uint64_t getDroppedFrames() const {
+        return droppedFrames_;
+    }
+
+    /*!
+     * \brief Adds a middleware processor to the end of the chain.
+     * \param middleware The middleware to add. The pipeline takes ownership.
+     */
+    void addMiddleware(IFrameMiddleware* middleware);
+
+    /*!
+     * \brief Restricts middleware processing to a region of interest.
+     * \param roi The region in frame pixels, or an empty rectangle to process whole frames.
+     *
+     * The region is clipped to each frame. Takes effect on the next frame.
+     */
+    void setRoi(const QRect& roi);
+
+    /*!
+     * \brief Retrieves the region of interest.
+     * \return The region in frame pixels, empty if whole frames are processed.
+     */
+    QRect getRoi() const;
+
+    /*!
+     * \brief Sets the size frames are downsampled to before processing.
+     * \param size The largest preview size, or an empty size to process frames at full resolution.
+     *
+     * Frames are scaled keeping their aspect ratio and are never upscaled. Takes effect on the next frame.
+     */
+    void setPreviewSize(const QSize& size);
+
+    /*!
+     * \brief Retrieves the preview size.
+     * \return The largest preview size, empty if frames are processed at full resolution.
+     */
+    QSize getPreviewSize() const;
+
+    /*!
+     * \brief Sets the processing time budget per frame.
+     * \param budgetMs The budget in milliseconds.
+     */
+    void setFrameBudget(double budgetMs);
+
+    /*!
+     * \brief Retrieves the processing time budget per frame.
+     * \return The budget in milliseconds.
+     */
+    double getFrameBudget() const;
+
+    /*!
+     * \brief Retrieves the current degradation level.
+     * \return The level set by the frame budget.
+     */
+    TFrameBudget::Level getDegradationLevel() const {
+        return static_cast<TFrameBudget::Level>(degradationLevel_.load());
+    }
+
+    /*!
+     * \brief Removes all middleware processors of a specific type.
+     * \tparam T The type of middleware to remove.
+     */
+    template<typename T>
+    void removeMiddlewareByType() {
+        std::lock_guard<std::mutex> lock(middlewaremtx_);
+        for (auto it = fmiddlewares_.end(); it != fmiddlewares_.begin();) {
+            --it;
+            if (dynamic_cast<T*>(it->get()) != nullptr) {
+                it = fmiddlewares_.erase(it);
+            }
+        }
+    }
+
+    /*!
+     * \brief Checks if a middleware processor of a specific type exists.
+     * \tparam T The type of middleware to check for.
+     * \return True if the middleware exists, false otherwise.
+     */
+    template<typename T>
+    bool findMiddlewareByType() {
+        std::lock_guard<std::mutex> lock(middlewaremtx_);
+        for (const auto& middleware : fmiddlewares_) {
+            if (dynamic_cast<T*>(middleware.get()) != nullptr) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+signals:
+    /*!
+     * \brief Emitted from the worker thread when a processed frame is ready.
+     *
+     * Not emitted again while a processed frame is still waiting to be retrieved.
+     */
+    void frameProcessed();
+
+    /*!
+     * \brief Emitted from the worker thread when the degradation level changes.
+     * \param level The new level, a value of TFrameBudget::Level.
+     */
+    void degradationLevelChanged(int level);
+
+private:
+    /*!
+     * \brief Executes the processing loop on the worker thread.
+     */
+    void run();
+
+    /*!
+     * \brief Runs one middleware processor on a frame.
+     * \param middleware The middleware.
+     * \param packet The packet holding the frame.
+     * \param roi The region of interest, empty for the whole frame.
+     *
+     * Calls processRoi() if the region covers only part of the frame. Otherwise feeds the native luma of camera frames
+     * to middleware that accepts it, or calls processPacket().
+     */
+    static void processMiddleware(IFrameMiddleware* middleware, TFramePacket& packet, const QRect& roi);
+
+    /*!
+     * \brief Replaces the frame of a packet by a downsampled preview.
+     * \param packet The packet holding the frame.
+     * \param size The largest preview size.
+     *
+     * Keeps the full-resolution frame in `fullImage`. Does nothing if the frame already fits or its format is not
+     * supported.
+     */
+    static void makePreview(TFramePacket& packet, const QSize& size);
+
+    QThread* workerThread_ = nullptr;                                   ///< Worker thread running the chain.
+    std::atomic<bool> isRunning_{false};                                ///< Flag indicating if the pipeline is running.
+    std::atomic<uint64_t> droppedFrames_{0};                            ///< Number of dropped frames.
+    std::mutex queuemtx_;                                               ///< Mutex protecting the input queue.
+    std::condition_variable queueCond_;                                 ///< Signals frames in the input queue.
+    std::array<TFramePacketPtr, FRAME_PIPELINE_QUEUE_SIZE> queue_;      ///< Ring buffer of queued frames.
+    size_t queueHead_ = 0;                                              ///< Index of the oldest queued frame.
+    size_t queueSize_ = 0;                                              ///< Number of queued frames.
+    std::mutex middlewaremtx_;                                          ///< Mutex protecting the middleware chain.
+    std::vector<std::shared_ptr<IFrameMiddleware> > fmiddlewares_;      ///< List of middleware processors for frames.
+    std::vector<std::shared_ptr<IFrameMiddleware> > chain_;             ///< Snapshot of the chain, used by the worker only.
+    mutable std::mutex settingsmtx_;                                    ///< Mutex protecting the processing settings.
+    QRect roi_;                                                         ///< Region of interest, empty for whole frames.
+    QSize previewSize_;                                                 ///< Preview size, empty for full resolution.
+    double frameBudgetMs_ = FRAME_BUDGET_DEFAULT_MS;                    ///< Processing time budget per frame.
+    TFrameBudget budget_;                                               ///< Load shedding state, used by the worker only.
+    std::atomic<unsigned int> degradationLevel_{0};                     ///< Current degradation level.
+    TTripleBuffer<TFramePacketPtr> output_;                             ///< Lock-free handoff of processed frames.
+};
+
+#endif // TFRAMEPIPELINE_H
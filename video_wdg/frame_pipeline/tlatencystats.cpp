@@ -0,0 +1,154 @@
+#include "tlatencystats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+// Writes a JSON string literal.
+void writeJsonString(std::ostream& out, const char* str)
+{
+    out << '"';
+    for (const char* c = str; *c != '\0'; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out << '\\' << *c;
+        } else if (static_cast<unsigned char>(*c) >= 0x20) {
+            out << *c;
+        }
+    }
+    out << '"';
+}
+
+// Writes one async trace event.
+void writeEvent(std::ostream& out, const char* name, char phase, int sourceId, uint64_t sequence, double ts)
+{
+    out << "{\"name\":";
+    writeJsonString(out, name);
+    out << ",\"cat\":\"frame\",\"ph\":\"" << phase << "\",\"id\":\"" << sourceId << ':' << sequence
+        << "\",\"pid\":" << sourceId << ",\"tid\":0,\"ts\":" << ts << '}';
+}
+}
+
+TLatencyStats::TLatencyStats(size_t window, size_t traceFrames) :
+    window_(std::max<size_t>(1, window)),
+    records_(traceFrames)
+{
+    stage(LATENCY_TOTAL_STAGE);
+    scratch_.reserve(window_);
+}
+
+void TLatencyStats::addTrace(const TFrameTrace &trace, TFrameTrace::Clock::time_point captureTime, uint64_t sequence, int sourceId)
+{
+    if (trace.size() == 0) {
+        return;
+    }
+    TFrameTrace::Clock::time_point begin = captureTime;
+    for (int i = 0; i < trace.size(); ++i) {
+        const TFrameTrace::Mark& mark = trace.at(i);
+        addSample(stage(mark.stage), std::chrono::duration<double, std::milli>(mark.time - begin).count());
+        begin = mark.time;
+    }
+    addSample(stages_.front(), std::chrono::duration<double, std::milli>(begin - captureTime).count());
+
+    if (records_.empty()) {
+        return;
+    }
+    Record& record = records_[nextRecord_];
+    record.trace = trace;
+    record.captureTime = captureTime;
+    record.sequence = sequence;
+    record.sourceId = sourceId;
+    nextRecord_ = (nextRecord_ + 1) % records_.size();
+    traceCount_ = std::min(traceCount_ + 1, records_.size());
+}
+
+double TLatencyStats::percentile(size_t stage, double p) const
+{
+    const std::vector<double>& samples = stages_[stage].samples;
+    if (samples.empty()) {
+        return 0.0;
+    }
+    scratch_.assign(samples.begin(), samples.end());
+    const double rank = std::ceil(std::clamp(p, 0.0, 100.0) / 100.0 * scratch_.size());
+    const size_t idx = rank < 1.0 ? 0 : static_cast<size_t>(rank) - 1;
+    std::nth_element(scratch_.begin(), scratch_.begin() + idx, scratch_.end());
+    return scratch_[idx];
+}
+
+bool TLatencyStats::writeChromeTrace(std::ostream &out) const
+{
+    // Oldest kept frame first; timestamps in microseconds from its capture.
+    const size_t first = (nextRecord_ + records_.size() - traceCount_) % std::max<size_t>(1, records_.size());
+    TFrameTrace::Clock::time_point origin{};
+    if (traceCount_ > 0) {
+        origin = records_[first].captureTime;
+    }
+    auto micros = [origin](TFrameTrace::Clock::time_point time) {
+        return std::chrono::duration<double, std::micro>(time - origin).count();
+    };
+
+    const std::ios::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out.setf(std::ios::fixed, std::ios::floatfield);
+    out.precision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool firstEvent = true;
+    auto separate = [&out, &firstEvent]() {
+        if (!firstEvent) {
+            out << ",\n";
+        }
+        firstEvent = false;
+    };
+    for (size_t n = 0; n < traceCount_; ++n) {
+        const Record& record = records_[(first + n) % records_.size()];
+        const TFrameTrace& trace = record.trace;
+        const TFrameTrace::Clock::time_point end = trace.at(trace.size() - 1).time;
+        separate();
+        writeEvent(out, LATENCY_TOTAL_STAGE, 'b', record.sourceId, record.sequence, micros(record.captureTime));
+        TFrameTrace::Clock::time_point begin = record.captureTime;
+        for (int i = 0; i < trace.size(); ++i) {
+            const TFrameTrace::Mark& mark = trace.at(i);
+            separate();
+            writeEvent(out, mark.stage, 'b', record.sourceId, record.sequence, micros(begin));
+            separate();
+            writeEvent(out, mark.stage, 'e', record.sourceId, record.sequence, micros(mark.time));
+            begin = mark.time;
+        }
+        separate();
+        writeEvent(out, LATENCY_TOTAL_STAGE, 'e', record.sourceId, record.sequence, micros(end));
+    }
+    out << "]}\n";
+    out.flags(flags);
+    out.precision(precision);
+    return static_cast<bool>(out);
+}
+
+void TLatencyStats::reset()
+{
+    stages_.clear();
+    stage(LATENCY_TOTAL_STAGE);
+    nextRecord_ = 0;
+    traceCount_ = 0;
+}
+
+TLatencyStats::Stage &TLatencyStats::stage(const char *name)
+{
+    for (Stage& s : stages_) {
+        if (std::strcmp(s.name.c_str(), name) == 0) {
+            return s;
+        }
+    }
+    stages_.push_back(Stage{name, {}, 0});
+    stages_.back().samples.reserve(window_);
+    return stages_.back();
+}
+
+void TLatencyStats::addSample(Stage &stage, double ms)
+{
+    if (stage.samples.size() < window_) {
+        stage.samples.push_back(ms);
+        return;
+    }
+    stage.samples[stage.next] = ms;
+    stage.next = (stage.next + 1) % window_;
+}
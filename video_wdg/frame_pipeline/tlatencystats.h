@@ -0,0 +1,142 @@
+/** @file
+ *
+ * TVideoWdg - SimpleMeasurementByVideoTool
+ * By Ilia.belou <ilia.belou@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef TLATENCYSTATS_H
+#define TLATENCYSTATS_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "video_wdg/frame_packet/tframetrace.h"
+
+constexpr size_t LATENCY_WINDOW_FRAMES = 300;       ///< Number of recent frames the percentiles are computed over.
+constexpr size_t LATENCY_TRACE_FRAMES = 1800;       ///< Number of recent frames kept for the trace dump.
+constexpr const char* LATENCY_TOTAL_STAGE = "total";///< Name of the capture to last mark latency.
+
+/*!
+ * \class TLatencyStats
+ * \brief Rolling latency percentiles of the frame processing stages.
+ *
+ * The `TLatencyStats` class collects the `TFrameTrace` of presented frames. For every stage it keeps the durations of
+ * the last `LATENCY_WINDOW_FRAMES` frames and reports their percentiles; stage 0 is always `LATENCY_TOTAL_STAGE`, the
+ * latency from capture to the last mark. The last `LATENCY_TRACE_FRAMES` traces are kept as well and can be written as
+ * a Chrome trace (the JSON format read by chrome://tracing and Perfetto), one async track per frame with a slice per
+ * stage. All buffers are allocated up front, so adding a trace does not allocate once every stage has been seen.
+ *
+ * The class is not thread-safe; it is meant to be used by the presenting thread only.
+ */
+class TLatencyStats
+{
+public:
+    /*!
+     * \brief Constructs a TLatencyStats instance.
+     * \param window The number of recent frames the percentiles are computed over (minimum 1).
+     * \param traceFrames The number of recent frames kept for the trace dump.
+     */
+    explicit TLatencyStats(size_t window = LATENCY_WINDOW_FRAMES, size_t traceFrames = LATENCY_TRACE_FRAMES);
+
+    /*!
+     * \brief Adds the trace of a frame.
+     * \param trace The stage marks of the frame.
+     * \param captureTime The time the frame was captured, start of its first stage.
+     * \param sequence The sequence number of the frame.
+     * \param sourceId The id of the source of the frame.
+     */
+    void addTrace(const TFrameTrace& trace, TFrameTrace::Clock::time_point captureTime, uint64_t sequence, int sourceId);
+
+    /*!
+     * \brief Retrieves the number of stages seen so far.
+     * \return Number of stages, including the total.
+     */
+    size_t stageCount() const { return stages_.size(); }
+
+    /*!
+     * \brief Retrieves the name of a stage.
+     * \param stage The index of the stage.
+     * \return The name.
+     */
+    const std::string& stageName(size_t stage) const { return stages_[stage].name; }
+
+    /*!
+     * \brief Retrieves the number of samples of a stage in the window.
+     * \param stage The index of the stage.
+     * \return Number of samples.
+     */
+    size_t sampleCount(size_t stage) const { return stages_[stage].samples.size(); }
+
+    /*!
+     * \brief Computes a percentile of the stage durations in the window.
+     * \param stage The index of the stage.
+     * \param p The percentile, from 0 to 100.
+     * \return The duration in milliseconds (nearest rank), 0 if the stage has no samples.
+     */
+    double percentile(size_t stage, double p) const;
+
+    /*!
+     * \brief Retrieves the number of frames kept for the trace dump.
+     * \return Number of frames.
+     */
+    size_t traceCount() const { return traceCount_; }
+
+    /*!
+     * \brief Writes the kept frames as a Chrome trace.
+     * \param out The stream receiving the JSON document.
+     * \return True if the document was written successfully.
+     */
+    bool writeChromeTrace(std::ostream& out) const;
+
+    /*!
+     * \brief Removes all samples and kept frames.
+     */
+    void reset();
+
+private:
+    /*!
+     * \brief Durations of one stage over the window.
+     */
+    struct Stage {
+        std::string name;               ///< Name of the stage.
+        std::vector<double> samples;    ///< Ring buffer of durations in milliseconds.
+        size_t next = 0;                ///< Index of the slot the next duration goes to once the window is full.
+    };
+
+    /*!
+     * \brief Trace of a frame kept for the dump.
+     */
+    struct Record {
+        TFrameTrace trace;                              ///< Stage marks.
+        TFrameTrace::Clock::time_point captureTime{};   ///< Capture time.
+        uint64_t sequence = 0;                          ///< Sequence number.
+        int sourceId = -1;                              ///< Source id.
+    };
+
+    /*!
+     * \brief Finds a stage by name, adding it if it was not seen yet.
+     * \param name The name of the stage.
+     * \return Reference to the stage.
+     */
+    Stage& stage(const char* name);
+
+    /*!
+     * \brief Adds a duration to a stage.
+     * \param stage The stage.
+     * \param ms The duration in milliseconds.
+     */
+    void addSample(Stage& stage, double ms);
+
+    size_t window_;                     ///< Number of frames the percentiles are computed over.
+    std::vector<Stage> stages_;         ///< Stages in order of appearance, the total first.
+    std::vector<Record> records_;       ///< Ring buffer of frames kept for the dump.
+    size_t nextRecord_ = 0;             ///< Index of the slot the next frame goes to.
+    size_t traceCount_ = 0;             ///< Number of frames kept.
+    mutable std::vector<double> scratch_; ///< Work buffer for percentile selection.
+};
+
+#endif // TLATENCYSTATS_H
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "tframebudget.h"
+
+namespace {
+// Подает одинаковое время обработки на несколько кадров
+void feed(TFrameBudget& budget, double frameMs, int frames) {
+    for (int i = 0; i < frames; ++i) {
+        budget.addFrameTime(frameMs);
+    }
+}
+
+// Подает одинаковое время обработки, пока не сменится уровень; возвращает число кадров или -1
+int feedUntilChange(TFrameBudget& budget, double frameMs, int maxFrames) {
+    for (int i = 1; i <= maxFrames; ++i) {
+        if (budget.addFrameTime(frameMs)) {
+            return i;
+        }
+    }
+    return -1;
+}
+}
+
+// В пределах бюджета деградации нет
+TEST(TFrameBudgetTest, StaysFullWithinBudget) {
+    TFrameBudget budget(20.0);
+    feed(budget, 15.0, 100);
+    EXPECT_EQ(budget.getLevel(), TFrameBudget::Level::Full);
+    EXPECT_TRUE(budget.admitFrame(0));
+    EXPECT_TRUE(budget.admitFrame(2));
+    EXPECT_FALSE(budget.reduceResolution());
+    EXPECT_FALSE(budget.bypassOptional());
+}
+
+// Превышение бюджета повышает уровень после нескольких кадров, а не сразу
+TEST(TFrameBudgetTest, DegradesAfterSustainedOverrun) {
+    TFrameBudget budget(20.0);
+    for (int i = 0; i < FRAME_BUDGET_DEGRADE_FRAMES - 1; ++i) {
+        EXPECT_FALSE(budget.addFrameTime(50.0));
+    }
+    EXPECT_EQ(budget.getLevel(), TFrameBudget::Level::Full);
+    EXPECT_TRUE(budget.addFrameTime(50.0));
+    EXPECT_EQ(budget.getLevel(), TFrameBudget::Level::SkipFrames);
+}
+
+// Пропуск кадров: пропускается только кадр, за которым в очереди уже ждет более новый
+TEST(TFrameBudgetTest, SkipsOnlyUnderQueuePressure) {
+    TFrameBudget budget(20.0);
+    feed(budget, 50.0, FRAME_BUDGET_DEGRADE_FRAMES);
+    ASSERT_EQ(budget.getLevel(), TFrameBudget::Level::SkipFrames);
+    EXPECT_TRUE(budget.admitFrame(0));
+    EXPECT_FALSE(budget.admitFrame(1));
+    EXPECT_FALSE(budget.admitFrame(2));
+}
+
+// Уровни накапливаются и не выходят за последний
+TEST(TFrameBudgetTest, DegradesUpToBypass) {
+    TFrameBudget budget(20.0);
+    feed(budget, 1000.0, FRAME_BUDGET_DEGRADE_FRAMES * 10);
+    EXPECT_EQ(budget.getLevel(), TFrameBudget::Level::BypassOptional);
+    EXPECT_TRUE(budget.reduceResolution());
+    EXPECT_TRUE(budget.bypassOptional());
+}
+
+// При пропуске кадров допустимое время на кадр удваивается
+TEST(TFrameBudgetTest, SkippingDoublesAllowance) {
+    TFrameBudget budget(20.0);
+    feed(budget, 30.0, FRAME_BUDGET_DEGRADE_FRAMES);
+    ASSERT_EQ(budget.getLevel(), TFrameBudget::Level::SkipFrames);
+    feed(budget, 30.0, 100);
+    EXPECT_EQ(budget.getLevel(), TFrameBudget::Level::SkipFrames);
+}
+
+// Восстановление по одному уровню после длительной работы с запасом
+TEST(TFrameBudgetTest, RecoversOneLevelAtATime) {
+    TFrameBudget budget(20.0);
+    feed(budget, 30.0, FRAME_BUDGET_DEGRADE_FRAMES);
+    ASSERT_EQ(budget.getLevel(), TFrameBudget::Level::SkipFrames);
+    // Пропуск кадров не уменьшает время кадра, его восстановление ничего не стоит
+    feed(budget, 30.0, FRAME_BUDGET_DEGRADE_FRAMES);
+    ASSERT_GT(feedUntilChange(budget, 60.0, 100), 0);
+    ASSERT_EQ(budget.getLevel(), TFrameBudget::Level::LowResolution);
+    // Половинное разрешение экономит немного
+    feed(budget, 35.0, FRAME_BUDGET_DEGRADE_FRAMES);
+
+    const int frames = feedUntilChange(budget, 1.0, FRAME_BUDGET_PROBE_FRAMES - 1);
+    EXPECT_GE(frames, FRAME_BUDGET_RECOVER_FRAMES);
+    EXPECT_EQ(budget.getLevel(), TFrameBudget::Level::SkipFrames);
+    feed(budget, 1.0, FRAME_BUDGET_RECOVER_FRAMES - 1);
+    EXPECT_EQ(budget.getLevel(), TFrameBudget::Level::SkipFrames);
+    budget.addFrameTime(1.0);
+    EXPECT_EQ(budget.getLevel(), TFrameBudget::Level::Full);
+}
+
+// Уровень, который экономит больше, чем помещается в бюджет нижнего уровня, восстанавливается только пробно
+TEST(TFrameBudgetTest, RestoresExpensiveLevelOnlyByProbe) {
+    TFrameBudget budget(20.0);
+    feed(budget, 1000.0, FRAME_BUDGET_DEGRADE_FRAMES * 2);
+    ASSERT_EQ(budget.getLevel(), TFrameBudget::Level::LowResolution);
+    // Половинное разрешение сэкономило почти все время кадра
+    feed(budget, 1.0, FRAME_BUDGET_PROBE_FRAMES - 1);
+    EXPECT_EQ(budget.getLevel(), TFrameBudget::Level::LowResolution);
+    budget.addFrameTime(1.0);
+    EXPECT_EQ(budget.getLevel(), TFrameBudget::Level::SkipFrames);
+}
+
+// Время кадра зависит от уровня: дорогая необязательная стадия не включается и не выключается каждые несколько
+// десятков кадров, уровень устанавливается
+TEST(TFrameBudgetTest, SettlesWhenRestoringOverruns) {
+    constexpr double BUDGET_MS = 33.0;
+    constexpr double BASE_MS = 4.0;       // Обязательные стадии
+    constexpr double OPTIONAL_MS = 80.0;  // Необязательная стадия при половинном разрешении
+    constexpr int FRAMES = 3000;
+    auto frameTime = [&](TFrameBudget::Level level) {
+        if (level == TFrameBudget::Level::BypassOptional) {
+            return BASE_MS;
+        }
+        return level == TFrameBudget::Level::LowResolution ? BASE_MS + OPTIONAL_MS : BASE_MS + 4 * OPTIONAL_MS;
+    };
+
+    TFrameBudget budget(BUDGET_MS);
+    std::vector<int> changes;
+    for (int i = 0; i < FRAMES; ++i) {
+        if (budget.addFrameTime(frameTime(budget.getLevel()))) {
+            changes.push_back(i);
+        }
+    }
+    EXPECT_EQ(budget.getLevel(), TFrameBudget::Level::BypassOptional);
+    // Без гистерезиса уровень менялся бы дважды за каждые FRAME_BUDGET_RECOVER_FRAMES + FRAME_BUDGET_DEGRADE_FRAMES
+    // кадров, с ним пробные восстановления случаются все реже
+    EXPECT_LE(changes.size(), 12u);
+    for (size_t i = 5; i + 2 < changes.size(); i += 2) {
+        EXPECT_GT(changes[i + 2] - changes[i], changes[i] - changes[i - 2]);
+    }
+    const int lastChange = changes.empty() ? 0 : changes.back();
+    EXPECT_GT(FRAMES - lastChange, FRAME_BUDGET_PROBE_FRAMES);
+}
+
+// Сброс возвращает полное качество
+TEST(TFrameBudgetTest, Reset) {
+    TFrameBudget budget(20.0);
+    feed(budget, 1000.0, FRAME_BUDGET_DEGRADE_FRAMES);
+    budget.reset();
+    EXPECT_EQ(budget.getLevel(), TFrameBudget::Level::Full);
+    EXPECT_TRUE(budget.admitFrame(1));
+}
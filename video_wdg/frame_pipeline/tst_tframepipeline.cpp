@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "tframepipeline.h"
+
+namespace {
+// Медленное промежуточное звено: запоминает номера кадров и держит каждый кадр, пока его не отпустят
+class GateMiddleware : public IFrameMiddleware
+{
+public:
+    void processFrame(QImage* img) override { Q_UNUSED(img); }
+
+    void processPacket(TFramePacket& packet) override {
+        std::unique_lock<std::mutex> lock(mtx_);
+        sequences_.push_back(packet.sequence);
+        cond_.notify_all();
+        cond_.wait(lock, [this]() { return open_; });
+    }
+
+    // Пропускает текущий и все следующие кадры
+    void open() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        open_ = true;
+        cond_.notify_all();
+    }
+
+    // Ждет, пока звено не получит count кадров
+    bool waitFrames(size_t count) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        return cond_.wait_for(lock, std::chrono::seconds(5), [&]() { return sequences_.size() >= count; });
+    }
+
+    std::vector<uint64_t> sequences() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return sequences_;
+    }
+
+private:
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    bool open_ = false;
+    std::vector<uint64_t> sequences_;
+};
+
+TFramePacketPtr makePacket(uint64_t sequence) {
+    TFramePacketPtr packet = TFramePacketPtr::create();
+    packet->ensureImage(16, 16, QImage::Format_RGB32).fill(Qt::gray);
+    packet->sequence = sequence;
+    return packet;
+}
+
+// Ждет выполнения условия не дольше timeout
+template <typename Predicate>
+bool waitFor(Predicate predicate, std::chrono::milliseconds timeout = std::chrono::milliseconds(5000))
+{
+    const auto end = std::chrono::steady_clock::now() + timeout;
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() > end) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Конвейер с медленным звеном и бюджетом, который не вмешивается в обработку
+struct GatedPipeline {
+    TFramePipeline pipeline;
+    GateMiddleware* gate = new GateMiddleware;
+
+    GatedPipeline() {
+        pipeline.setFrameBudget(1e6);
+        pipeline.addMiddleware(gate);
+        pipeline.start();
+    }
+};
+}
+
+// Переполненная очередь отбрасывает самый старый кадр, submit() не блокируется
+TEST(TFramePipelineTest, DropsOldestWhenQueueIsFull) {
+    GatedPipeline p;
+    p.pipeline.submit(makePacket(0));
+    ASSERT_TRUE(p.gate->waitFrames(1));
+    // Кадр 0 в обработке, очередь вмещает FRAME_PIPELINE_QUEUE_SIZE кадров
+    for (uint64_t i = 1; i <= FRAME_PIPELINE_QUEUE_SIZE + 1; ++i) {
+        p.pipeline.submit(makePacket(i));
+    }
+    EXPECT_EQ(p.pipeline.getDroppedFrames(), 1u);
+
+    p.gate->open();
+    // Каждый готовый кадр, кроме последнего, заменен более новым до того, как его забрали
+    ASSERT_TRUE(waitFor([&]() { return p.pipeline.getDroppedFrames() == 1 + FRAME_PIPELINE_QUEUE_SIZE; }));
+    std::vector<uint64_t> expected = {0};
+    for (uint64_t i = 2; i <= FRAME_PIPELINE_QUEUE_SIZE + 1; ++i) {
+        expected.push_back(i);
+    }
+    EXPECT_EQ(p.gate->sequences(), expected);
+    TFramePacketPtr packet = p.pipeline.getFrame();
+    ASSERT_TRUE(packet);
+    EXPECT_EQ(packet->sequence, FRAME_PIPELINE_QUEUE_SIZE + 1u);
+}
+
+// Выходной тройной буфер отдает последний кадр и уведомляет только о первом из незабранных
+TEST(TFramePipelineTest, OutputKeepsLatestFrame) {
+    GatedPipeline p;
+    p.gate->open();
+    std::atomic<int> notifications{0};
+    QObject::connect(&p.pipeline, &TFramePipeline::frameProcessed, [&]() { ++notifications; });
+
+    p.pipeline.submit(makePacket(0));
+    ASSERT_TRUE(waitFor([&]() { return p.pipeline.isReady(); }));
+    p.pipeline.submit(makePacket(1));
+    ASSERT_TRUE(p.gate->waitFrames(2));
+    ASSERT_TRUE(waitFor([&]() { return p.pipeline.getDroppedFrames() == 1; }));
+    EXPECT_EQ(notifications, 1);
+
+    TFramePacketPtr packet = p.pipeline.getFrame();
+    ASSERT_TRUE(packet);
+    EXPECT_EQ(packet->sequence, 1u);
+    EXPECT_FALSE(p.pipeline.isReady());
+    // Без нового кадра getFrame() снова отдает последний
+    EXPECT_EQ(p.pipeline.getFrame()->sequence, 1u);
+
+    p.pipeline.submit(makePacket(2));
+    ASSERT_TRUE(waitFor([&]() { return p.pipeline.isReady(); }));
+    EXPECT_EQ(notifications, 2);
+    EXPECT_EQ(p.pipeline.getFrame()->sequence, 2u);
+}
+
+// stop() с кадрами в очереди отбрасывает их и не ждет их обработки; конвейер можно запустить снова
+TEST(TFramePipelineTest, StopDiscardsPendingFrames) {
+    GatedPipeline p;
+    p.pipeline.submit(makePacket(0));
+    ASSERT_TRUE(p.gate->waitFrames(1));
+    p.pipeline.submit(makePacket(1));
+    p.pipeline.submit(makePacket(2));
+
+    std::thread releaser([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        p.gate->open();
+    });
+    p.pipeline.stop();
+    releaser.join();
+    const std::vector<uint64_t> expected = {0};
+    EXPECT_EQ(p.gate->sequences(), expected);
+
+    p.pipeline.start();
+    p.pipeline.submit(makePacket(3));
+    ASSERT_TRUE(p.gate->waitFrames(2));
+    EXPECT_EQ(p.gate->sequences().back(), 3u);
+}
+
+// Изменение цепочки не ждет кадра, который обрабатывается в этот момент
+TEST(TFramePipelineTest, ChainChangeDoesNotWaitForFrame) {
+    GatedPipeline p;
+    p.pipeline.submit(makePacket(0));
+    ASSERT_TRUE(p.gate->waitFrames(1));
+
+    auto change = std::async(std::launch::async, [&]() {
+        p.pipeline.addMiddleware(new GateMiddleware);
+        p.pipeline.removeMiddlewareByType<GateMiddleware>();
+    });
+    const bool done = change.wait_for(std::chrono::seconds(1)) == std::future_status::ready;
+    p.gate->open();
+    change.wait();
+    EXPECT_TRUE(done);
+    // Удаленное звено живо, пока кадр не обработан
+    ASSERT_TRUE(waitFor([&]() { return p.pipeline.isReady(); }));
+    EXPECT_FALSE(p.pipeline.findMiddlewareByType<GateMiddleware>());
+}
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "tlatencystats.h"
+
+namespace {
+using Clock = TFrameTrace::Clock;
+using std::chrono::milliseconds;
+
+// Строит трассу из длительностей этапов в миллисекундах
+TFrameTrace makeTrace(Clock::time_point capture, std::initializer_list<std::pair<const char*, int> > stages) {
+    TFrameTrace trace;
+    Clock::time_point time = capture;
+    for (const auto& stage : stages) {
+        time += milliseconds(stage.second);
+        trace.mark(stage.first, time);
+    }
+    return trace;
+}
+
+// Ищет этап по имени
+size_t findStage(const TLatencyStats& stats, const std::string& name) {
+    for (size_t i = 0; i < stats.stageCount(); ++i) {
+        if (stats.stageName(i) == name) {
+            return i;
+        }
+    }
+    return stats.stageCount();
+}
+}
+
+// Этапы считаются от предыдущей отметки, общая задержка - от захвата до последней отметки
+TEST(TLatencyStatsTest, SplitsStagesBetweenMarks) {
+    TLatencyStats stats;
+    const Clock::time_point capture = Clock::now();
+    stats.addTrace(makeTrace(capture, {{"queue", 3}, {"filter", 10}, {"present", 2}}), capture, 0, 0);
+
+    ASSERT_EQ(stats.stageCount(), 4u);
+    EXPECT_EQ(stats.stageName(0), LATENCY_TOTAL_STAGE);
+    EXPECT_DOUBLE_EQ(stats.percentile(0, 50), 15.0);
+    EXPECT_DOUBLE_EQ(stats.percentile(findStage(stats, "queue"), 50), 3.0);
+    EXPECT_DOUBLE_EQ(stats.percentile(findStage(stats, "filter"), 50), 10.0);
+    EXPECT_DOUBLE_EQ(stats.percentile(findStage(stats, "present"), 50), 2.0);
+}
+
+// Перцентили по ближайшему рангу
+TEST(TLatencyStatsTest, ComputesPercentiles) {
+    TLatencyStats stats;
+    const Clock::time_point capture = Clock::now();
+    for (int ms = 100; ms >= 1; --ms) {
+        stats.addTrace(makeTrace(capture, {{"filter", ms}}), capture, 0, 0);
+    }
+    const size_t filter = findStage(stats, "filter");
+    EXPECT_DOUBLE_EQ(stats.percentile(filter, 50), 50.0);
+    EXPECT_DOUBLE_EQ(stats.percentile(filter, 95), 95.0);
+    EXPECT_DOUBLE_EQ(stats.percentile(filter, 99), 99.0);
+    EXPECT_DOUBLE_EQ(stats.percentile(filter, 0), 1.0);
+    EXPECT_DOUBLE_EQ(stats.percentile(filter, 100), 100.0);
+}
+
+// В окне остаются только последние кадры
+TEST(TLatencyStatsTest, KeepsRollingWindow) {
+    TLatencyStats stats(10, 0);
+    const Clock::time_point capture = Clock::now();
+    for (int i = 0; i < 50; ++i) {
+        stats.addTrace(makeTrace(capture, {{"filter", 100}}), capture, i, 0);
+    }
+    for (int i = 0; i < 10; ++i) {
+        stats.addTrace(makeTrace(capture, {{"filter", 5}}), capture, i, 0);
+    }
+    const size_t filter = findStage(stats, "filter");
+    EXPECT_EQ(stats.sampleCount(filter), 10u);
+    EXPECT_DOUBLE_EQ(stats.percentile(filter, 99), 5.0);
+    EXPECT_EQ(stats.traceCount(), 0u);
+}
+
+// Этап без отметок в части кадров учитывается только там, где он был
+TEST(TLatencyStatsTest, CountsOptionalStagesSeparately) {
+    TLatencyStats stats;
+    const Clock::time_point capture = Clock::now();
+    stats.addTrace(makeTrace(capture, {{"filter", 4}, {"present", 1}}), capture, 0, 0);
+    stats.addTrace(makeTrace(capture, {{"present", 1}}), capture, 1, 0);
+    EXPECT_EQ(stats.sampleCount(findStage(stats, "filter")), 1u);
+    EXPECT_EQ(stats.sampleCount(findStage(stats, "present")), 2u);
+    EXPECT_EQ(stats.sampleCount(0), 2u);
+}
+
+// Пустая трасса не учитывается, без отметок нет и этапов
+TEST(TLatencyStatsTest, IgnoresEmptyTrace) {
+    TLatencyStats stats;
+    stats.addTrace(TFrameTrace(), Clock::now(), 0, 0);
+    EXPECT_EQ(stats.stageCount(), 1u);
+    EXPECT_EQ(stats.sampleCount(0), 0u);
+    EXPECT_DOUBLE_EQ(stats.percentile(0, 50), 0.0);
+    EXPECT_EQ(stats.traceCount(), 0u);
+}
+
+// Трасса ограничена FRAME_TRACE_MAX_MARKS отметками
+TEST(TLatencyStatsTest, TraceIsBounded) {
+    TFrameTrace trace;
+    for (int i = 0; i < FRAME_TRACE_MAX_MARKS + 5; ++i) {
+        trace.mark("stage");
+    }
+    EXPECT_EQ(trace.size(), FRAME_TRACE_MAX_MARKS);
+    trace.clear();
+    EXPECT_EQ(trace.size(), 0);
+}
+
+// Chrome trace: вложенные async-события на кадр, хранятся последние кадры
+TEST(TLatencyStatsTest, WritesChromeTrace) {
+    TLatencyStats stats(LATENCY_WINDOW_FRAMES, 2);
+    const Clock::time_point capture = Clock::now();
+    for (uint64_t seq = 0; seq < 3; ++seq) {
+        const Clock::time_point frameCapture = capture + milliseconds(40 * seq);
+        stats.addTrace(makeTrace(frameCapture, {{"queue", 1}, {"fil\"ter", 2}}), frameCapture, seq, 7);
+    }
+    EXPECT_EQ(stats.traceCount(), 2u);
+
+    std::ostringstream out;
+    ASSERT_TRUE(stats.writeChromeTrace(out));
+    const std::string json = out.str();
+    EXPECT_EQ(json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0u);
+    EXPECT_EQ(json.find("\"id\":\"7:0\""), std::string::npos);
+    EXPECT_NE(json.find("\"id\":\"7:1\""), std::string::npos);
+    EXPECT_NE(json.find("\"id\":\"7:2\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"fil\\\"ter\""), std::string::npos);
+    EXPECT_NE(json.find("\"pid\":7"), std::string::npos);
+    // Первый сохраненный кадр начинается с нуля, второй - через 40 мс
+    EXPECT_NE(json.find("\"name\":\"total\",\"cat\":\"frame\",\"ph\":\"b\",\"id\":\"7:1\",\"pid\":7,\"tid\":0,\"ts\":0.000}"),
+              std::string::npos);
+    EXPECT_NE(json.find("\"ph\":\"b\",\"id\":\"7:2\",\"pid\":7,\"tid\":0,\"ts\":40000.000}"), std::string::npos);
+    EXPECT_NE(json.find("\"ph\":\"e\",\"id\":\"7:2\",\"pid\":7,\"tid\":0,\"ts\":43000.000}"), std::string::npos);
+    EXPECT_EQ(json.substr(json.size() - 3), "]}\n");
+}
@@ -11,20 +11,50 @@
 
 #include <QImage>
 #include <QList>
-#include <mutex>
+#include <atomic>
 #include <QObject>
 #include <QThread>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "tcaptureexecutor.h"
+#include "ttriplebuffer.h"
+#include "video_wdg/frame_packet/tframepacket.h"
+
+constexpr int CAPTURE_IDLE_PERIOD = 10;    ///< Longest sleep in milliseconds between checks for a stop on a provider thread.
+
+/*!
+ * \brief Capture statistics of a frame provider.
+ */
+struct TCaptureStats {
+    int sourceId = -1;              ///< Id of the provider.
+    double fps = 0.0;               ///< Frames published per second over the last `CAPTURE_STATS_PERIOD`.
+    double lagMs = 0.0;             ///< Mean delay between the due time of a capture step and its start, 0 on an own thread.
+    uint64_t frames = 0;            ///< Frames published since construction.
+    uint64_t dropped = 0;           ///< Frames overwritten before retrieval.
+    unsigned int queueDepth = 0;    ///< Published frames waiting for the consumer, at most 1 with the triple buffer.
+};
 
 /*!
  * \class IFrameProvider
  * \brief Abstract interface for providing video frames from various sources.
  *
  * The `IFrameProvider` class is a pure virtual interface that defines the contract for classes that provide video frames,
- * such as from USB cameras or RTSP streams. It manages frame acquisition in a separate thread, ensuring thread-safe access
- * to frames via a mutex-protected `QImage`. Derived classes must implement methods for device management, format selection,
+ * such as from USB cameras or RTSP streams. It manages frame acquisition in a separate thread and hands frames to the
+ * consumer as `TFramePacket`s through a lock-free triple buffer: the capture thread never blocks and the consumer always
+ * gets the latest complete frame. Packets come from a per-provider `TFramePacketPool`, which stamps them with the
+ * capture time, a sequence number and the provider's source id, and recycles their buffers. The `frameAvailable` signal notifies the
+ * consumer when a frame is published. Derived classes must implement methods for device management, format selection,
  * and frame capture. The class supports starting and stopping frame acquisition, with readiness notifications via a callback.
+ *
+ * Polling sources implement openSource() and captureFrame(), one bounded step that reads or renders a frame and returns
+ * when the next step is due. Such a provider runs on a shared `TCaptureExecutor` if one is set with setExecutor(), so
+ * many sources share a fixed pool of threads, and otherwise on a thread of its own. Sources driven by their own event
+ * loop (e.g. Qt Multimedia) override run() instead and always get a thread of their own.
  */
-class IFrameProvider : public QObject
+class IFrameProvider : public QObject, protected TCaptureTask
 {
     Q_OBJECT
 public:
@@ -32,7 +62,11 @@ public:
      * \brief Constructs an IFrameProvider instance.
      * \param parent The parent QObject (default is nullptr).
      */
-    explicit IFrameProvider(QObject* parent = nullptr) : QObject(parent) {}
+    explicit IFrameProvider(QObject* parent = nullptr) :
+        QObject(parent),
+        sourceId_(nextSourceId_++),
+        pool_(std::make_shared<TFramePacketPool>(sourceId_))
+    {}
 
     /*!
      * \brief Destructor.
@@ -85,10 +119,10 @@ public:
 
     /*!
      * \brief Checks if a new frame is ready.
-     * \return Reference to the atomic boolean indicating frame readiness.
+     * \return True if a frame was published since the last call to getFrame().
      */
-    const std::atomic<bool>& isReady() const {
-        return frameReady_;
+    bool isReady() const {
+        return frames_.hasNew();
     }
 
     /*!
@@ -99,28 +133,92 @@ public:
         return isRunning_;
     }
 
+    /*!
+     * \brief Retrieves the number of frames dropped by the provider.
+     * \return Count of frames that were overwritten by a newer frame before being retrieved.
+     */
+    uint64_t getDroppedFrames() const {
+        return droppedFrames_;
+    }
+
+    /*!
+     * \brief Retrieves the capture statistics of the provider.
+     * \return The frame rate, scheduling lag, frame and drop counts and the depth of the handoff to the consumer.
+     *
+     * On its own thread the frame rate is measured since the previous call; call it from a single thread.
+     */
+    TCaptureStats getCaptureStats() {
+        TCaptureStats stats;
+        stats.sourceId = sourceId_;
+        stats.frames = publishedFrames_;
+        stats.dropped = droppedFrames_;
+        stats.queueDepth = frames_.hasNew() ? 1 : 0;
+        TCaptureExecutor::Stats taskStats;
+        if (executor_ && executor_->stats(this, &taskStats)) {
+            stats.fps = taskStats.fps;
+            stats.lagMs = taskStats.lagMs;
+            return stats;
+        }
+        const TCaptureStep::Clock::time_point now = TCaptureStep::Clock::now();
+        const double elapsed = std::chrono::duration<double>(now - statsTime_).count();
+        if (statsTime_ != TCaptureStep::Clock::time_point{} && elapsed > 0.0) {
+            stats.fps = (stats.frames - statsFrames_) / elapsed;
+        }
+        statsTime_ = now;
+        statsFrames_ = stats.frames;
+        return stats;
+    }
+
+    /*!
+     * \brief Sets the executor running the capture steps.
+     * \param executor The shared executor, nullptr to capture on a thread of the provider's own.
+     *
+     * Takes effect on the next start(); ignored while the provider is running. The executor must outlive the provider
+     * or its stop(). Providers that override run() are not step based and must keep the default, nullptr.
+     */
+    void setExecutor(TCaptureExecutor* executor) {
+        if (!isRunning_) {
+            executor_ = executor;
+        }
+    }
+
+    /*!
+     * \brief Retrieves the id of the provider.
+     * \return The id stamped as sourceId on every frame packet of the provider.
+     */
+    int getSourceId() const {
+        return sourceId_;
+    }
+
     /*!
      * \brief Retrieves the latest video frame.
-     * \return Reference to the QImage containing the frame.
+     * \return Handle to the TFramePacket containing the frame, empty if no frame was published yet.
      *
-     * Provides thread-safe access to the current frame, resetting the readiness flag.
+     * Takes the latest published frame, if any, and resets the readiness flag. A camera frame may still be in its
+     * native format (see `TFramePacket::videoFrame`); call `TFramePacket::convertToImage()` when an image is needed.
+     * Must be called from a single consumer thread.
      */
-    const QImage& getFrame() {
-        std::lock_guard<std::mutex> lock(framemtx_);
-        frameReady_ = false;
-        return frame_;
+    TFramePacketPtr getFrame() {
+        frames_.consume();
+        return frames_.front();
     }
 
     /*!
      * \brief Starts frame acquisition.
      * \param ready Callback function to be called when the provider is ready.
      *
-     * Launches frame acquisition in a separate thread and invokes the ready callback when initialized.
+     * Schedules frame acquisition on the executor, or launches it in a separate thread, and invokes the ready callback
+     * when initialized.
      */
     void start(std::function<void()> ready) {
         if (isRunning_) return;
         ready_ = ready;
+        sourceOpen_ = false;
         isRunning_ = true;
+        if (executor_) {
+            executor_->add(this);
+            return;
+        }
         workerThread_ = new QThread(this);
         this->moveToThread(workerThread_);
         connect(workerThread_, &QThread::started, this, &IFrameProvider::run);
@@ -130,11 +228,15 @@ public:
     /*!
      * \brief Stops frame acquisition.
      *
-     * Terminates the worker thread and cleans up resources.
+     * Removes the provider from the executor, waiting for a running step, or terminates the worker thread and cleans up
+     * resources.
      */
     void stop() {
         if (isRunning_) {
             isRunning_ = false;
+            if (executor_) {
+                executor_->remove(this);
+            }
             if (workerThread_) {
                 workerThread_->quit();
                 workerThread_->wait();
@@ -144,20 +246,162 @@ public:
         }
     }
 
+signals:
+    /*!
+     * \brief Emitted from the capture thread when a new frame is published.
+     *
+     * Not emitted again while a published frame is still waiting to be retrieved, so a slow consumer is never
+     * flooded with queued notifications.
+     */
+    void frameAvailable();
+
 protected:
     /*!
-     * \brief Executes the frame acquisition loop.
+     * \brief Executes the frame acquisition loop on the provider's own thread.
      *
-     * Must be implemented by derived classes to define the frame capture process.
+     * Runs the capture steps until stop(), sleeping until each is due. Sources driven by their own event loop override
+     * it to set up the capture and return.
+     */
+    virtual void run() {
+        using Clock = TCaptureStep::Clock;
+        while (isRunning_) {
+            const TCaptureStep step = captureStep();
+            // Sleep in slices, so a stop or a wakeCapture() does not wait for a distant or parked step.
+            while (isRunning_ && !wakeRequested_.exchange(false) && Clock::now() < step.due) {
+                std::this_thread::sleep_until(std::min(step.due, Clock::now() + std::chrono::milliseconds(CAPTURE_IDLE_PERIOD)));
+            }
+        }
+    }
+
+    /*!
+     * \brief Opens the source before the first capture step.
+     * \return True on success; on failure the provider stays idle until stopped.
      */
-    virtual void run() = 0;
+    virtual bool openSource() {
+        return true;
+    }
+
+    /*!
+     * \brief Performs one capture step.
+     * \return When the next step is due and whether a frame was published.
+     *
+     * Should not block longer than a few frame intervals, it holds a thread shared with other sources and stop() waits
+     * for it. Sources whose reads may stall, e.g. on a network, must bound them with a timeout.
+     */
+    virtual TCaptureStep captureFrame() {
+        return TCaptureStep::parked();
+    }
+
+    /*!
+     * \brief Makes the next capture step due immediately.
+     *
+     * Called from any thread after a request the capture should act on without waiting, e.g. a seek.
+     */
+    void wakeCapture() {
+        if (executor_) {
+            executor_->wake(this);
+        } else {
+            wakeRequested_ = true;
+        }
+    }
+
+    /*!
+     * \brief Restarts frame pacing from now.
+     *
+     * Called by the capture on opening the source or after a seek, so the next paceNext() does not count from a stale
+     * deadline.
+     */
+    void restartPacing() {
+        deadline_ = TCaptureStep::Clock::now();
+    }
+
+    /*!
+     * \brief Schedules the next capture step one frame interval after the previous deadline.
+     * \param fps Frame rate to pace at, 0 or less to capture as fast as possible.
+     * \param frame Whether the current step published a frame.
+     * \return The deadline of the next step, now if unthrottled or running late.
+     *
+     * Stepping from the deadline rather than from now keeps the rate from drifting with the per-frame cost. A step
+     * that runs late does not burst to catch up. After a rate change from another thread call wakeCapture(), so the
+     * capture does not wait out an interval of the old rate.
+     */
+    TCaptureStep paceNext(double fps, bool frame) {
+        using Clock = TCaptureStep::Clock;
+        const Clock::time_point now = Clock::now();
+        if (fps <= 0.0) {
+            deadline_ = now;
+            return TCaptureStep::at(now, frame);
+        }
+        deadline_ += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps));
+        if (deadline_ < now) {
+            deadline_ = now;
+        }
+        return TCaptureStep::at(deadline_, frame);
+    }
+
+    /*!
+     * \brief Acquires a packet for a newly captured frame.
+     * \return Handle to a pooled packet stamped with the current time, the next sequence number and the source id.
+     *
+     * The packet image usually holds an older frame of the same stream, so `TFramePacket::ensureImage()` can reuse its
+     * buffer.
+     */
+    TFramePacketPtr acquirePacket() {
+        return pool_->acquire();
+    }
+
+    /*!
+     * \brief Publishes a captured frame to the consumer.
+     * \param packet The packet holding the frame.
+     *
+     * Never blocks. If the previously published frame was not retrieved yet it is replaced and counted as dropped,
+     * otherwise frameAvailable() is emitted. Marks the end of the "capture" stage in the packet trace.
+     */
+    void publishFrame(TFramePacketPtr packet) {
+        packet->trace.mark("capture");
+        frames_.back() = std::move(packet);
+        bool dropped = frames_.publish();
+        // Recycle the stale packet we got back right away.
+        frames_.back().reset();
+        ++publishedFrames_;
+        if (dropped) {
+            ++droppedFrames_;
+        } else {
+            emit frameAvailable();
+        }
+    }
 
     QThread* workerThread_ = nullptr;                ///< Worker thread for frame acquisition.
+    TCaptureExecutor* executor_ = nullptr;          ///< Shared executor running the capture steps, if any.
+    std::atomic<bool> wakeRequested_{false};        ///< Flag cutting the sleep of the provider's own thread short.
+    bool sourceOpen_ = false;                       ///< Whether openSource() succeeded since start().
+    std::atomic<uint64_t> publishedFrames_{0};      ///< Number of frames published.
+    TCaptureStep::Clock::time_point statsTime_{};   ///< Time of the previous getCaptureStats() on an own thread.
+    uint64_t statsFrames_ = 0;                      ///< Frames published at the previous getCaptureStats().
+    TCaptureStep::Clock::time_point deadline_{};    ///< Due time of the next paced step, capture thread only.
     std::atomic<bool> isRunning_{false};            ///< Flag indicating if the provider is running.
-    std::atomic<bool> frameReady_{false};           ///< Flag indicating if a new frame is ready.
-    std::mutex framemtx_;                           ///< Mutex for thread-safe frame access.
-    QImage frame_;                                  ///< Current video frame.
+    std::atomic<uint64_t> droppedFrames_{0};        ///< Number of frames overwritten before retrieval.
+    int sourceId_;                                  ///< Id of the provider.
+    std::shared_ptr<TFramePacketPool> pool_;        ///< Pool of frame packets of the provider.
+    TTripleBuffer<TFramePacketPtr> frames_;         ///< Lock-free handoff of frames between capture and consumer threads.
+    static inline std::atomic<int> nextSourceId_{0}; ///< Id of the next constructed provider.
     std::function<void()> ready_;                   ///< Callback invoked when the provider is ready.
+
+private:
+    /*!
+     * \brief Opens the source on the first step, then captures.
+     * \return The result of captureFrame(), parked if the source failed to open.
+     */
+    TCaptureStep captureStep() final {
+        if (!sourceOpen_) {
+            if (!openSource()) {
+                return TCaptureStep::parked();
+            }
+            sourceOpen_ = true;
+            ready_();
+        }
+        return captureFrame();
+    }
 };
 
 #endif // IFRAMEPROVIDER_H
@@ -0,0 +1,181 @@
+#include "tcaptureexecutor.h"
+#include <algorithm>
+
+TCaptureExecutor::TCaptureExecutor(unsigned int threads)
+{
+    if (threads == 0) {
+        threads = defaultThreadCount();
+    }
+    workers_.reserve(threads);
+    for (unsigned int i = 0; i < threads; ++i) {
+        workers_.emplace_back([this]() { work(); });
+    }
+}
+
+TCaptureExecutor::~TCaptureExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stopping_ = true;
+    }
+    workCond_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void TCaptureExecutor::add(TCaptureTask *task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!task || find(task) != entries_.end()) {
+            return;
+        }
+        auto entry = std::make_unique<Entry>();
+        entry->task = task;
+        entry->due = Clock::now();
+        entry->ticket = nextTicket_++;
+        entry->windowStart = entry->due;
+        entries_.push_back(std::move(entry));
+    }
+    workCond_.notify_one();
+}
+
+void TCaptureExecutor::remove(TCaptureTask *task)
+{
+    std::unique_lock<std::mutex> lock(mtx_);
+    auto it = find(task);
+    if (it == entries_.end()) {
+        return;
+    }
+    Entry* entry = it->get();
+    // Without the flag an always due task could be picked again before this thread wakes up.
+    entry->removing = true;
+    idleCond_.wait(lock, [entry]() { return !entry->running; });
+    // The vector may have changed while waiting.
+    entries_.erase(find(task));
+}
+
+void TCaptureExecutor::wake(TCaptureTask *task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto it = find(task);
+        if (it == entries_.end()) {
+            return;
+        }
+        if ((*it)->running) {
+            (*it)->woken = true;
+        } else {
+            (*it)->due = std::min((*it)->due, Clock::now());
+        }
+    }
+    workCond_.notify_one();
+}
+
+size_t TCaptureExecutor::taskCount() const
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    return entries_.size();
+}
+
+size_t TCaptureExecutor::readyCount() const
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    const Clock::time_point now = Clock::now();
+    return static_cast<size_t>(std::count_if(entries_.begin(), entries_.end(), [now](const auto& entry) {
+        return !entry->running && !entry->removing && entry->due <= now;
+    }));
+}
+
+bool TCaptureExecutor::stats(const TCaptureTask *task, Stats *stats) const
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = find(task);
+    if (it == entries_.end()) {
+        return false;
+    }
+    const Entry& entry = **it;
+    *stats = entry.stats;
+    // A stalled or parked task closes no window: report the running one once it is overdue.
+    const double elapsed = std::chrono::duration<double>(Clock::now() - entry.windowStart).count();
+    if (elapsed * 1000.0 >= 2.0 * CAPTURE_STATS_PERIOD) {
+        stats->fps = entry.windowFrames / elapsed;
+        stats->lagMs = entry.windowSteps > 0 ? entry.windowLagMs / entry.windowSteps : 0.0;
+    }
+    return true;
+}
+
+unsigned int TCaptureExecutor::defaultThreadCount()
+{
+    return std::max(CAPTURE_EXECUTOR_MIN_THREADS, std::thread::hardware_concurrency());
+}
+
+void TCaptureExecutor::work()
+{
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (!stopping_) {
+        const Clock::time_point now = Clock::now();
+        Entry* next = nullptr;
+        Clock::time_point wakeup = Clock::time_point::max();
+        for (const auto& entry : entries_) {
+            if (entry->running || entry->removing) {
+                continue;
+            }
+            if (entry->due <= now) {
+                if (!next || entry->ticket < next->ticket) {
+                    next = entry.get();
+                }
+            } else {
+                wakeup = std::min(wakeup, entry->due);
+            }
+        }
+        if (!next) {
+            if (wakeup == Clock::time_point::max()) {
+                workCond_.wait(lock);
+            } else {
+                workCond_.wait_until(lock, wakeup);
+            }
+            continue;
+        }
+
+        next->running = true;
+        const double lagMs = std::chrono::duration<double, std::milli>(now - next->due).count();
+        lock.unlock();
+        const TCaptureStep step = next->task->captureStep();
+        lock.lock();
+
+        // remove() waits for running to clear, so the entry is still alive here.
+        next->running = false;
+        next->due = next->woken ? std::min(step.due, Clock::now()) : step.due;
+        next->woken = false;
+        next->ticket = nextTicket_++;
+        ++next->stats.steps;
+        ++next->windowSteps;
+        next->windowLagMs += lagMs;
+        if (step.frame) {
+            ++next->stats.frames;
+            ++next->windowFrames;
+        }
+        const Clock::time_point end = Clock::now();
+        const double elapsed = std::chrono::duration<double>(end - next->windowStart).count();
+        if (elapsed * 1000.0 >= CAPTURE_STATS_PERIOD) {
+            next->stats.fps = next->windowFrames / elapsed;
+            next->stats.lagMs = next->windowLagMs / next->windowSteps;
+            next->windowStart = end;
+            next->windowFrames = 0;
+            next->windowSteps = 0;
+            next->windowLagMs = 0.0;
+        }
+        idleCond_.notify_all();
+        // Another worker may sleep past the new due time of this task.
+        if (next->due != Clock::time_point::max()) {
+            workCond_.notify_one();
+        }
+    }
+}
+
+std::vector<std::unique_ptr<TCaptureExecutor::Entry> >::const_iterator TCaptureExecutor::find(const TCaptureTask *task) const
+{
+    return std::find_if(entries_.begin(), entries_.end(), [task](const auto& entry) { return entry->task == task; });
+}
@@ -0,0 +1,203 @@
+/** @file
+ *
+ * TVideoWdg - SimpleMeasurementByVideoTool
+ * By Ilia.belou <ilia.belou@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef TCAPTUREEXECUTOR_H
+#define TCAPTUREEXECUTOR_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+constexpr unsigned int CAPTURE_EXECUTOR_MIN_THREADS = 2;   ///< Fewest worker threads of a default sized executor.
+constexpr int CAPTURE_STATS_PERIOD = 1000;                 ///< Window in milliseconds the capture statistics cover.
+
+/*!
+ * \brief Result of one capture step.
+ */
+struct TCaptureStep {
+    using Clock = std::chrono::steady_clock;    ///< Clock used for scheduling.
+
+    Clock::time_point due = Clock::time_point::max(); ///< Earliest time of the next step, max() parks the task.
+    bool frame = false;                         ///< Whether the step published a frame.
+
+    /*!
+     * \brief Makes a step result.
+     * \param due Earliest time of the next step.
+     * \param frame Whether the step published a frame.
+     * \return The step result.
+     */
+    static TCaptureStep at(Clock::time_point due, bool frame) { return TCaptureStep{due, frame}; }
+
+    /*!
+     * \brief Makes a step result that parks the task until TCaptureExecutor::wake().
+     * \return The step result.
+     */
+    static TCaptureStep parked() { return TCaptureStep{}; }
+};
+
+/*!
+ * \class TCaptureTask
+ * \brief Abstract unit of capture work run by a `TCaptureExecutor`.
+ */
+class TCaptureTask
+{
+public:
+    virtual ~TCaptureTask() = default;
+
+    /*!
+     * \brief Performs one bounded step of capture work, usually reading or rendering one frame.
+     * \return When the task wants to run again and whether a frame was published.
+     *
+     * Never runs on two threads at once, but successive steps may run on different threads.
+     */
+    virtual TCaptureStep captureStep() = 0;
+};
+
+/*!
+ * \class TCaptureExecutor
+ * \brief Fixed pool of worker threads shared by many capture tasks.
+ *
+ * The `TCaptureExecutor` class runs the steps of any number of `TCaptureTask`s on a fixed number of threads, so adding a
+ * source no longer costs a thread that mostly sleeps. A task is due once the time returned by its last step has passed.
+ * Each idle worker takes the due task that has waited longest since its last step (round robin), so a task that is
+ * always due cannot starve the others, and sleeps until the earliest due time when no task is due. The scheduler scans
+ * all tasks under one mutex, which is cheap for the tens of sources a machine can decode.
+ *
+ * Per task the executor measures the rate of published frames and the scheduling lag (how late a step started after its
+ * due time), both over the last `CAPTURE_STATS_PERIOD`. A lag that keeps growing means the pool is too small.
+ */
+class TCaptureExecutor
+{
+public:
+    using Clock = TCaptureStep::Clock;          ///< Clock used for scheduling.
+
+    /*!
+     * \brief Capture statistics of a task.
+     */
+    struct Stats {
+        double fps = 0.0;       ///< Frames published per second over the last window.
+        double lagMs = 0.0;     ///< Mean delay between the due time and the start of the steps of the last window.
+        uint64_t frames = 0;    ///< Frames published since the task was added.
+        uint64_t steps = 0;     ///< Steps run since the task was added.
+    };
+
+    /*!
+     * \brief Constructs a TCaptureExecutor instance and starts its workers.
+     * \param threads The number of worker threads, 0 for defaultThreadCount().
+     */
+    explicit TCaptureExecutor(unsigned int threads = 0);
+
+    /*!
+     * \brief Destructor.
+     *
+     * Waits for running steps to finish and joins the workers. Tasks still added are not run again.
+     */
+    ~TCaptureExecutor();
+
+    TCaptureExecutor(const TCaptureExecutor&) = delete;
+    TCaptureExecutor& operator=(const TCaptureExecutor&) = delete;
+
+    /*!
+     * \brief Retrieves the number of worker threads.
+     * \return Number of threads.
+     */
+    unsigned int threadCount() const { return static_cast<unsigned int>(workers_.size()); }
+
+    /*!
+     * \brief Adds a task, due immediately.
+     * \param task The task; must stay valid until remove() returns. Adding a task twice has no effect.
+     */
+    void add(TCaptureTask* task);
+
+    /*!
+     * \brief Removes a task.
+     * \param task The task.
+     *
+     * Blocks until a running step of the task has finished; the task is not run again afterwards. Must not be called
+     * from a step of the task itself.
+     */
+    void remove(TCaptureTask* task);
+
+    /*!
+     * \brief Makes a task due immediately.
+     * \param task The task, e.g. after a request that should not wait for its next scheduled step.
+     *
+     * If a step of the task is running, the task is due again as soon as the step finishes, whatever the step returns.
+     */
+    void wake(TCaptureTask* task);
+
+    /*!
+     * \brief Retrieves the number of tasks.
+     * \return Number of tasks added and not removed.
+     */
+    size_t taskCount() const;
+
+    /*!
+     * \brief Retrieves the number of tasks waiting for a worker.
+     * \return Number of tasks that are due but not running.
+     */
+    size_t readyCount() const;
+
+    /*!
+     * \brief Retrieves the capture statistics of a task.
+     * \param task The task.
+     * \param stats Receives the statistics.
+     * \return True if the task is added.
+     */
+    bool stats(const TCaptureTask* task, Stats* stats) const;
+
+    /*!
+     * \brief Computes the default number of worker threads.
+     * \return The number of hardware threads, at least `CAPTURE_EXECUTOR_MIN_THREADS`.
+     */
+    static unsigned int defaultThreadCount();
+
+private:
+    /*!
+     * \brief Scheduling state and statistics of a task.
+     */
+    struct Entry {
+        TCaptureTask* task = nullptr;           ///< The task.
+        Clock::time_point due{};                ///< Earliest time of the next step.
+        uint64_t ticket = 0;                    ///< Order of the last step, lower runs first among due tasks.
+        bool running = false;                   ///< Whether a worker runs a step of the task.
+        bool removing = false;                  ///< Whether remove() waits for the task, which is not run again.
+        bool woken = false;                     ///< Whether wake() was called during the running step.
+        Stats stats;                            ///< Statistics of the last complete window and totals.
+        Clock::time_point windowStart{};        ///< Start of the current window.
+        uint64_t windowFrames = 0;              ///< Frames published in the current window.
+        uint64_t windowSteps = 0;               ///< Steps run in the current window.
+        double windowLagMs = 0.0;               ///< Sum of the lag of the steps of the current window.
+    };
+
+    /*!
+     * \brief Executes the scheduling loop of a worker.
+     */
+    void work();
+
+    /*!
+     * \brief Finds the entry of a task.
+     * \param task The task.
+     * \return Iterator to the entry, entries_.end() if the task is not added.
+     */
+    std::vector<std::unique_ptr<Entry> >::const_iterator find(const TCaptureTask* task) const;
+
+    mutable std::mutex mtx_;                    ///< Mutex protecting the entries and the stop flag.
+    std::condition_variable workCond_;          ///< Signals workers that a task may have become due.
+    std::condition_variable idleCond_;          ///< Signals remove() that a step has finished.
+    std::vector<std::unique_ptr<Entry> > entries_; ///< Tasks in order of addition.
+    uint64_t nextTicket_ = 0;                   ///< Ticket of the next finished step.
+    bool stopping_ = false;                     ///< Flag telling the workers to exit.
+    std::vector<std::thread> workers_;          ///< Worker threads.
+};
+
+#endif // TCAPTUREEXECUTOR_H
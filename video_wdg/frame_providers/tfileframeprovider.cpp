@@ -0,0 +1,256 @@
+#include "tfileframeprovider.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "video_wdg/cv_to_qt_image/cvmatandqimage.h"
+
+TFileFrameProvider::TFileFrameProvider(QObject *parent)
+    : IFrameProvider{parent}
+{}
+
+TFileFrameProvider::~TFileFrameProvider()
+{
+    stop();
+}
+
+QList<std::string> TFileFrameProvider::getDeviceDesc()
+{
+    return QList<std::string> {path_};
+}
+
+void TFileFrameProvider::setDeviceByDesc(std::string desc)
+{
+
+}
+
+QList<std::string> TFileFrameProvider::getCurrentDeviceAvaliableFormats()
+{
+    if (width_ == 0) {
+        return QList<std::string>();
+    }
+    return QList<std::string>{QString("%1,%2").arg(width_.load()).arg(height_.load()).toStdString()};
+}
+
+void TFileFrameProvider::setCurrentDeviceFormatByIdx(int idx)
+{
+
+}
+
+void TFileFrameProvider::setUrl(std::string url)
+{
+    path_ = url;
+}
+
+void TFileFrameProvider::setFrameRate(double fps)
+{
+    frameRate_ = fps;
+    wakeCapture();
+}
+
+void TFileFrameProvider::setLooping(bool loop)
+{
+    looping_ = loop;
+    if (loop) {
+        wakeCapture();
+    }
+}
+
+void TFileFrameProvider::seek(int64_t frame)
+{
+    seekRequest_ = std::max<int64_t>(frame, 0);
+    wakeCapture();
+}
+
+bool TFileFrameProvider::openSource()
+{
+    if (!openFile()) {
+        qDebug() << "Failed to open file:" << path_;
+        return false;
+    }
+    position_ = 0;
+    restartPacing();
+    return true;
+}
+
+bool TFileFrameProvider::openFile()
+{
+    rawData_ = nullptr;
+    rawFile_.close();
+    capture_.reset();
+
+    rawFile_.setFileName(QString::fromStdString(path_));
+    if (rawFile_.open(QIODevice::ReadOnly)) {
+        char magic[sizeof(RAW_DUMP_MAGIC)] = {};
+        if (rawFile_.peek(magic, sizeof(magic)) == sizeof(magic)
+                && std::memcmp(magic, RAW_DUMP_MAGIC, sizeof(magic)) == 0) {
+            rawData_ = rawFile_.map(0, rawFile_.size());
+            if (!rawData_ || !readRawDumpHeader(rawData_, static_cast<size_t>(rawFile_.size()), &rawHeader_)) {
+                qDebug() << "Invalid raw frame dump:" << path_;
+                rawData_ = nullptr;
+                rawFile_.close();
+                return false;
+            }
+            rawFrameSize_ = rawFrameSize(rawHeader_);
+            nativeRate_ = rawHeader_.fps;
+            frameCount_ = static_cast<int64_t>(rawHeader_.frameCount);
+            width_ = static_cast<int>(rawHeader_.width);
+            height_ = static_cast<int>(rawHeader_.height);
+            return true;
+        }
+        rawFile_.close();
+    }
+
+    capture_.reset(new cv::VideoCapture(path_));
+    if (!capture_->isOpened()) {
+        capture_.reset();
+        return false;
+    }
+    nativeRate_ = capture_->get(cv::CAP_PROP_FPS);
+    frameCount_ = std::max<int64_t>(0, static_cast<int64_t>(capture_->get(cv::CAP_PROP_FRAME_COUNT)));
+    width_ = static_cast<int>(capture_->get(cv::CAP_PROP_FRAME_WIDTH));
+    height_ = static_cast<int>(capture_->get(cv::CAP_PROP_FRAME_HEIGHT));
+    return true;
+}
+
+TCaptureStep TFileFrameProvider::captureFrame()
+{
+    using Clock = TCaptureStep::Clock;
+    const int64_t target = seekRequest_.exchange(-1);
+    if (target >= 0) {
+        const int64_t count = frameCount_;
+        const int64_t frame = count > 0 ? std::min(target, count - 1) : target;
+        if (!capture_) {
+            position_ = frame;
+        } else {
+            const int64_t reached = seekVideo(frame);
+            if (reached >= 0) {
+                if (reached < frame) {
+                    // The file ended before the frame: the container overstated the count.
+                    frameCount_ = reached;
+                }
+                position_ = reached;
+            }
+        }
+        restartPacing();
+    }
+
+    if (!playFrame()) {
+        int64_t none = -1;
+        if (looping_ && position_ > 0 && seekRequest_.compare_exchange_strong(none, 0)) {
+            return TCaptureStep::at(Clock::now(), false);
+        }
+        // End of the file: sleep until a seek or looping wakes the capture.
+        return TCaptureStep::parked();
+    }
+
+    double fps = frameRate_;
+    if (fps < 0.0) {
+        fps = nativeRate_;
+    }
+    return paceNext(fps, true);
+}
+
+bool TFileFrameProvider::playFrame()
+{
+    const int64_t frame = position_;
+    if (rawData_) {
+        if (frame >= frameCount_) {
+            return false;
+        }
+        // Copy out of the mapping: middleware writes into the packet image.
+        TFramePacketPtr packet = acquirePacket();
+        QImage& image = packet->ensureImage(width_, height_, QImage::Format_RGB32);
+        convertRawFrame(rawData_ + RAW_DUMP_HEADER_SIZE + static_cast<size_t>(frame) * rawFrameSize_, image);
+        position_ = frame + 1;
+        publishFrame(std::move(packet));
+        return true;
+    }
+
+    if (!capture_->isOpened()) {
+        // A failed reopen says nothing about the length of the file.
+        return false;
+    }
+    if (!capture_->read(videoFrame_) || videoFrame_.empty()) {
+        // The container may report a wrong count, the end of the stream is authoritative.
+        frameCount_ = frame;
+        return false;
+    }
+    if (videoFrame_.type() != CV_8UC1 && videoFrame_.type() != CV_8UC3 && videoFrame_.type() != CV_8UC4) {
+        qDebug() << "Unsupported video frame type:" << videoFrame_.type();
+        return false;
+    }
+    position_ = frame + 1;
+    if (frameCount_ < frame + 1) {
+        frameCount_ = frame + 1;
+    }
+
+    TFramePacketPtr packet = acquirePacket();
+    QImage& image = packet->ensureImage(videoFrame_.cols, videoFrame_.rows, QImage::Format_RGB32);
+    cv::Mat outputMat(image.height(), image.width(), CV_8UC4, image.bits(), image.bytesPerLine());
+    if (videoFrame_.type() == CV_8UC3) {
+        cv::cvtColor(videoFrame_, outputMat, cv::COLOR_BGR2BGRA);
+    } else if (videoFrame_.type() == CV_8UC1) {
+        cv::cvtColor(videoFrame_, outputMat, cv::COLOR_GRAY2BGRA);
+    } else {
+        videoFrame_.copyTo(outputMat);
+    }
+    publishFrame(std::move(packet));
+    return true;
+}
+
+void TFileFrameProvider::convertRawFrame(const uchar *data, QImage &image) const
+{
+    const int width = static_cast<int>(rawHeader_.width);
+    const int height = static_cast<int>(rawHeader_.height);
+    const size_t step = rawHeader_.bytesPerLine;
+    uchar* src = const_cast<uchar*>(data);
+    cv::Mat outputMat(image.height(), image.width(), CV_8UC4, image.bits(), image.bytesPerLine());
+
+    QtOcv::YuvImage yuv = {QtOcv::YUV_NV12, width, height, {data, nullptr, nullptr}, {step, 0, 0}};
+    const size_t ySize = step * static_cast<size_t>(height);
+    switch (static_cast<TRawPixelFormat>(rawHeader_.format)) {
+    case TRawPixelFormat::BGRA32:
+        cv::Mat(height, width, CV_8UC4, src, step).copyTo(outputMat);
+        return;
+    case TRawPixelFormat::Gray8:
+        cv::cvtColor(cv::Mat(height, width, CV_8UC1, src, step), outputMat, cv::COLOR_GRAY2BGRA);
+        return;
+    case TRawPixelFormat::BGR24:
+        cv::cvtColor(cv::Mat(height, width, CV_8UC3, src, step), outputMat, cv::COLOR_BGR2BGRA);
+        return;
+    case TRawPixelFormat::NV12:
+        yuv.planes[1] = data + ySize;
+        yuv.steps[1] = step;
+        break;
+    case TRawPixelFormat::I420:
+        yuv.format = QtOcv::YUV_I420;
+        yuv.planes[1] = data + ySize;
+        yuv.planes[2] = data + ySize + ySize / 4;
+        yuv.steps[1] = yuv.steps[2] = step / 2;
+        break;
+    case TRawPixelFormat::YUYV:
+        yuv.format = QtOcv::YUV_YUYV;
+        break;
+    }
+    QtOcv::yuv2Mat(yuv, outputMat, CV_8UC4, QtOcv::MCO_BGRA);
+}
+
+int64_t TFileFrameProvider::seekVideo(int64_t frame)
+{
+    if (capture_->set(cv::CAP_PROP_POS_FRAMES, static_cast<double>(frame))
+            && static_cast<int64_t>(capture_->get(cv::CAP_PROP_POS_FRAMES)) == frame) {
+        return frame;
+    }
+    // The backend cannot seek exactly: decode from the start up to the frame.
+    if (!capture_->open(path_)) {
+        qDebug() << "Failed to reopen file:" << path_;
+        return -1;
+    }
+    for (int64_t i = 0; i < frame; ++i) {
+        if (!capture_->grab()) {
+            return i;
+        }
+    }
+    return frame;
+}
@@ -0,0 +1,186 @@
+/** @file
+ *
+ * TVideoWdg - SimpleMeasurementByVideoTool
+ * By Ilia.belou <ilia.belou@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef TFILEFRAMEPROVIDER_H
+#define TFILEFRAMEPROVIDER_H
+
+#include <QFile>
+#include <QObject>
+#include <QDebug>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+#include "iframeprovider.h"
+#include "trawdump.h"
+
+constexpr double FILE_RATE_NATIVE = -1.0;      ///< Play at the frame rate recorded in the file.
+constexpr double FILE_RATE_UNTHROTTLED = 0.0;  ///< Play as fast as frames can be read.
+
+/*!
+ * \class TFileFrameProvider
+ * \brief Frame provider replaying video files and raw frame dumps.
+ *
+ * The `TFileFrameProvider` class implements the `IFrameProvider` interface for recorded footage, so that benchmarks
+ * and regression tests see the same frames on every run. A file starting with `RAW_DUMP_MAGIC` is a raw frame dump
+ * (see `TRawDumpHeader`): it is memory-mapped and each frame is copied or converted straight from the mapping into the
+ * pooled packet buffer, with no decoding. Any other file is decoded with OpenCV's `VideoCapture`.
+ *
+ * Frames are played one capture step at a time at the recorded frame rate, at a fixed rate or unthrottled, optionally
+ * in a loop; at the end of the file the provider sleeps until a seek. seek() positions the playback on an exact frame
+ * index; it may be called from any thread and takes effect before the next frame. Frames are published as
+ * `QImage::Format_RGB32`.
+ */
+class TFileFrameProvider : public IFrameProvider
+{
+    Q_OBJECT
+public:
+    /*!
+     * \brief Constructs a TFileFrameProvider instance.
+     * \param parent The parent QObject (default is nullptr).
+     */
+    explicit TFileFrameProvider(QObject *parent = nullptr);
+
+    /*!
+     * \brief Destructor.
+     *
+     * Stops the provider before the file is unmapped.
+     */
+    ~TFileFrameProvider();
+
+    /*!
+     * \brief Retrieves the description of the file source.
+     * \return A list containing the file path.
+     */
+    QList<std::string> getDeviceDesc() override;
+
+    /*!
+     * \brief Sets the active device by description.
+     * \param desc The device description (currently unused).
+     *
+     * This implementation does not use the description, as file sources are defined by path.
+     */
+    void setDeviceByDesc(std::string desc) override;
+
+    /*!
+     * \brief Retrieves the available formats of the file.
+     * \return A list containing the frame size (width,height), empty until the file is opened.
+     */
+    QList<std::string> getCurrentDeviceAvaliableFormats() override;
+
+    /*!
+     * \brief Sets the video format by index.
+     * \param idx The format index (currently unused).
+     *
+     * This implementation does not support format changes for files.
+     */
+    void setCurrentDeviceFormatByIdx(int idx) override;
+
+    /*!
+     * \brief Sets the path of the file to play.
+     * \param url The file path.
+     *
+     * Takes effect on the next start of the provider.
+     */
+    void setUrl(std::string url) override;
+
+    /*!
+     * \brief Sets the playback rate.
+     * \param fps Frames per second, `FILE_RATE_NATIVE` for the rate recorded in the file or `FILE_RATE_UNTHROTTLED`.
+     *
+     * A file without a recorded rate is played unthrottled at `FILE_RATE_NATIVE`.
+     */
+    void setFrameRate(double fps);
+
+    /*!
+     * \brief Enables or disables looping.
+     * \param loop If true, playback restarts at the first frame after the last one, also if it already ended.
+     */
+    void setLooping(bool loop);
+
+    /*!
+     * \brief Moves the playback to a frame.
+     * \param frame Index of the next frame to publish, clamped to the frames of the file.
+     */
+    void seek(int64_t frame);
+
+    /*!
+     * \brief Retrieves the number of frames of the file.
+     * \return Frame count, 0 until the file is opened. For video files it is the count reported by the container,
+     * corrected once the end of the file is reached.
+     */
+    int64_t frameCount() const { return frameCount_; }
+
+    /*!
+     * \brief Retrieves the playback position.
+     * \return Index of the next frame to publish.
+     */
+    int64_t position() const { return position_; }
+
+protected:
+    /*!
+     * \brief Opens the file and rewinds the playback.
+     * \return True if the file can be played.
+     */
+    bool openSource() override;
+
+    /*!
+     * \brief Applies a pending seek and publishes the next frame.
+     * \return The deadline of the next frame, so the rate does not drift with the per-frame cost; parked at the end of
+     * the file.
+     */
+    TCaptureStep captureFrame() override;
+
+private:
+    /*!
+     * \brief Opens the file as a raw dump or, failing that, as a video.
+     * \return True if the file can be played.
+     */
+    bool openFile();
+
+    /*!
+     * \brief Reads the frame at the playback position into a packet and publishes it.
+     * \return True if a frame was published, false at the end of the file.
+     */
+    bool playFrame();
+
+    /*!
+     * \brief Converts a frame of the raw dump into the packet image.
+     * \param data Start of the frame in the mapping.
+     * \param image The packet image, `Format_RGB32` of the frame size.
+     */
+    void convertRawFrame(const uchar* data, QImage& image) const;
+
+    /*!
+     * \brief Positions the video decoder on an exact frame.
+     * \param frame Index of the next frame to decode.
+     * \return Index of the next frame the decoder delivers: frame, or the number of frames of the file if it ends
+     * before, -1 if the decoder could not be reopened.
+     *
+     * Falls back to decoding from the start if the backend only seeks to key frames.
+     */
+    int64_t seekVideo(int64_t frame);
+
+    std::string path_{};                                    ///< Path of the file.
+    QFile rawFile_;                                         ///< Raw dump file, open while mapped.
+    const uchar* rawData_ = nullptr;                        ///< Mapping of the raw dump.
+    TRawDumpHeader rawHeader_{};                            ///< Header of the raw dump.
+    size_t rawFrameSize_ = 0;                               ///< Size of a raw frame in bytes.
+    std::unique_ptr<cv::VideoCapture> capture_ = nullptr;   ///< Decoder of a video file.
+    cv::Mat videoFrame_;                                    ///< Decoded frame, reused between reads.
+    double nativeRate_ = 0.0;                               ///< Frame rate recorded in the file, 0 if unknown.
+    std::atomic<double> frameRate_{FILE_RATE_NATIVE};       ///< Requested playback rate.
+    std::atomic<bool> looping_{false};                      ///< Flag indicating if playback loops.
+    std::atomic<int64_t> seekRequest_{-1};                  ///< Pending seek target, -1 if none.
+    std::atomic<int64_t> frameCount_{0};                    ///< Number of frames of the file.
+    std::atomic<int64_t> position_{0};                      ///< Index of the next frame to publish.
+    std::atomic<int> width_{0};                             ///< Frame width.
+    std::atomic<int> height_{0};                            ///< Frame height.
+};
+
+#endif // TFILEFRAMEPROVIDER_H
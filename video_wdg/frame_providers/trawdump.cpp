@@ -0,0 +1,132 @@
+#include "trawdump.h"
+#include <cstring>
+
+namespace {
+// Minimum bytes per row of the first plane.
+uint64_t minBytesPerLine(TRawPixelFormat format, uint64_t width)
+{
+    switch (format) {
+    case TRawPixelFormat::BGRA32:
+        return width * 4;
+    case TRawPixelFormat::BGR24:
+        return width * 3;
+    case TRawPixelFormat::YUYV:
+        return width * 2;
+    case TRawPixelFormat::Gray8:
+    case TRawPixelFormat::NV12:
+    case TRawPixelFormat::I420:
+        break;
+    }
+    return width;
+}
+}
+
+TRawDumpHeader makeRawDumpHeader(TRawPixelFormat format, unsigned int width, unsigned int height, double fps)
+{
+    TRawDumpHeader header{};
+    std::memcpy(header.magic, RAW_DUMP_MAGIC, sizeof(header.magic));
+    header.version = RAW_DUMP_VERSION;
+    header.format = static_cast<uint32_t>(format);
+    header.width = width;
+    header.height = height;
+    header.bytesPerLine = static_cast<uint32_t>(minBytesPerLine(format, width));
+    header.fps = fps;
+    return header;
+}
+
+bool isValidRawDumpHeader(const TRawDumpHeader &header)
+{
+    if (std::memcmp(header.magic, RAW_DUMP_MAGIC, sizeof(header.magic)) != 0 || header.version != RAW_DUMP_VERSION) {
+        return false;
+    }
+    if (header.format > static_cast<uint32_t>(TRawPixelFormat::YUYV) || header.width == 0 || header.height == 0) {
+        return false;
+    }
+    const TRawPixelFormat format = static_cast<TRawPixelFormat>(header.format);
+    if (header.bytesPerLine < minBytesPerLine(format, header.width)) {
+        return false;
+    }
+    switch (format) {
+    case TRawPixelFormat::NV12:
+    case TRawPixelFormat::I420:
+        return header.width % 2 == 0 && header.height % 2 == 0 && header.bytesPerLine % 2 == 0;
+    case TRawPixelFormat::YUYV:
+        return header.width % 2 == 0;
+    default:
+        return true;
+    }
+}
+
+size_t rawFrameSize(const TRawDumpHeader &header)
+{
+    if (!isValidRawDumpHeader(header)) {
+        return 0;
+    }
+    const size_t planeSize = static_cast<size_t>(header.bytesPerLine) * header.height;
+    switch (static_cast<TRawPixelFormat>(header.format)) {
+    case TRawPixelFormat::NV12:
+    case TRawPixelFormat::I420:
+        // Both chroma layouts take half the size of the Y plane.
+        return planeSize + planeSize / 2;
+    default:
+        return planeSize;
+    }
+}
+
+bool readRawDumpHeader(const void *data, size_t size, TRawDumpHeader *header)
+{
+    if (!data || size < RAW_DUMP_HEADER_SIZE) {
+        return false;
+    }
+    std::memcpy(header, data, RAW_DUMP_HEADER_SIZE);
+    const size_t frameSize = rawFrameSize(*header);
+    if (frameSize == 0) {
+        return false;
+    }
+    const uint64_t available = (size - RAW_DUMP_HEADER_SIZE) / frameSize;
+    if (header->frameCount > available) {
+        header->frameCount = available;
+    }
+    return true;
+}
+
+TRawDumpWriter::~TRawDumpWriter()
+{
+    close();
+}
+
+bool TRawDumpWriter::open(const std::string &path, const TRawDumpHeader &header)
+{
+    close();
+    frameSize_ = rawFrameSize(header);
+    if (frameSize_ == 0) {
+        return false;
+    }
+    header_ = header;
+    header_.frameCount = 0;
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_.write(reinterpret_cast<const char*>(&header_), sizeof(header_))) {
+        file_.close();
+        return false;
+    }
+    return true;
+}
+
+bool TRawDumpWriter::writeFrame(const uint8_t *data)
+{
+    if (!file_.is_open() || !file_.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(frameSize_))) {
+        return false;
+    }
+    ++header_.frameCount;
+    return true;
+}
+
+void TRawDumpWriter::close()
+{
+    if (!file_.is_open()) {
+        return;
+    }
+    file_.seekp(0);
+    file_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    file_.close();
+}
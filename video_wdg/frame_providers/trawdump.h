@@ -0,0 +1,145 @@
+/** @file
+ *
+ * TVideoWdg - SimpleMeasurementByVideoTool
+ * By Ilia.belou <ilia.belou@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef TRAWDUMP_H
+#define TRAWDUMP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+constexpr char RAW_DUMP_MAGIC[8] = {'V', 'S', 'M', 'T', 'R', 'A', 'W', '\0'}; ///< First bytes of a raw frame dump.
+constexpr unsigned int RAW_DUMP_VERSION = 1;                                    ///< Version of the dump layout.
+constexpr size_t RAW_DUMP_HEADER_SIZE = 64;                                     ///< Offset of the first frame in the file.
+
+/*!
+ * \brief Pixel formats of a raw frame dump.
+ */
+enum class TRawPixelFormat : uint32_t {
+    BGRA32, ///< 4 bytes per pixel, B G R A (`QImage::Format_RGB32` on little endian systems).
+    Gray8,  ///< 1 byte per pixel.
+    BGR24,  ///< 3 bytes per pixel, B G R (`cv::Mat` of `CV_8UC3`).
+    NV12,   ///< Y plane followed by the interleaved U V plane, both of bytesPerLine.
+    I420,   ///< Y plane followed by the U and V planes of bytesPerLine / 2.
+    YUYV    ///< Packed Y0 U Y1 V, 2 bytes per pixel.
+};
+
+/*!
+ * \brief Header of a raw frame dump.
+ *
+ * A dump is this header followed by `frameCount` frames of rawFrameSize() bytes each, starting at
+ * `RAW_DUMP_HEADER_SIZE`. Rows of a frame are `bytesPerLine` apart. All fields are in the byte order of the machine
+ * that wrote the dump (little endian on all supported platforms).
+ */
+struct TRawDumpHeader {
+    char magic[8];          ///< RAW_DUMP_MAGIC.
+    uint32_t version;       ///< RAW_DUMP_VERSION.
+    uint32_t format;        ///< Pixel format, a TRawPixelFormat value.
+    uint32_t width;         ///< Frame width in pixels.
+    uint32_t height;        ///< Frame height in pixels.
+    uint32_t bytesPerLine;  ///< Bytes per row of the first plane.
+    uint32_t reserved;      ///< Zero.
+    uint64_t frameCount;    ///< Number of frames in the dump.
+    double fps;             ///< Recorded frame rate, 0 if unknown.
+    uint8_t padding[16];    ///< Zero.
+};
+
+static_assert(sizeof(TRawDumpHeader) == RAW_DUMP_HEADER_SIZE, "TRawDumpHeader must fill the header exactly");
+
+/*!
+ * \brief Creates the header of a dump with tightly packed rows.
+ * \param format The pixel format of the frames.
+ * \param width The frame width in pixels.
+ * \param height The frame height in pixels.
+ * \param fps The recorded frame rate, 0 if unknown.
+ * \return The header, with a frame count of 0.
+ */
+TRawDumpHeader makeRawDumpHeader(TRawPixelFormat format, unsigned int width, unsigned int height, double fps);
+
+/*!
+ * \brief Computes the size of one frame of a dump.
+ * \param header The header of the dump.
+ * \return Size of a frame in bytes, 0 if the header is invalid.
+ */
+size_t rawFrameSize(const TRawDumpHeader& header);
+
+/*!
+ * \brief Checks the header of a dump.
+ * \param header The header to check.
+ * \return True if the magic, version and geometry are valid for the pixel format.
+ *
+ * YUV formats need an even width, and 4:2:0 formats an even height and bytesPerLine.
+ */
+bool isValidRawDumpHeader(const TRawDumpHeader& header);
+
+/*!
+ * \brief Reads the header from the start of a dump.
+ * \param data The dump contents, e.g. the memory-mapped file.
+ * \param size The size of the dump in bytes.
+ * \param header Receives the header. Its frame count is limited to the frames actually present, so a dump whose
+ * writer did not finish can still be played.
+ * \return True if a valid header was read.
+ */
+bool readRawDumpHeader(const void* data, size_t size, TRawDumpHeader* header);
+
+/*!
+ * \class TRawDumpWriter
+ * \brief Writes frames to a raw frame dump.
+ *
+ * The frame count in the header is kept up to date on close(), which the destructor calls.
+ */
+class TRawDumpWriter
+{
+public:
+    /*!
+     * \brief Destructor.
+     *
+     * Closes the dump.
+     */
+    ~TRawDumpWriter();
+
+    /*!
+     * \brief Creates a dump.
+     * \param path The path of the file, replaced if it exists.
+     * \param header The header of the dump, see makeRawDumpHeader(). Its frame count is ignored.
+     * \return True if the header is valid and was written.
+     */
+    bool open(const std::string& path, const TRawDumpHeader& header);
+
+    /*!
+     * \brief Appends a frame.
+     * \param data The frame in the layout of the dump, rawFrameSize() bytes.
+     * \return True if the frame was written.
+     */
+    bool writeFrame(const uint8_t* data);
+
+    /*!
+     * \brief Writes the frame count to the header and closes the file.
+     */
+    void close();
+
+    /*!
+     * \brief Checks if a dump is open.
+     * \return True between a successful open() and close().
+     */
+    bool isOpen() const { return file_.is_open(); }
+
+    /*!
+     * \brief Retrieves the number of frames written.
+     * \return Number of frames appended since open().
+     */
+    uint64_t frameCount() const { return header_.frameCount; }
+
+private:
+    std::ofstream file_;        ///< Dump file.
+    TRawDumpHeader header_{};   ///< Header of the dump, frameCount counts the frames written.
+    size_t frameSize_ = 0;      ///< Size of a frame in bytes.
+};
+
+#endif // TRAWDUMP_H
@@ -4,6 +4,11 @@ TRTCPFrameProvider::TRTCPFrameProvider(QObject *parent)
     : IFrameProvider{parent}
 {}
 
+TRTCPFrameProvider::~TRTCPFrameProvider()
+{
+    stop();
+}
+
 QList<std::string> TRTCPFrameProvider::getDeviceDesc()
 {
     return QList<std::string> {url_};
@@ -31,66 +36,79 @@ void TRTCPFrameProvider::setUrl(std::string url)
     url_ = url;
 }
 
-void TRTCPFrameProvider::run()
+void TRTCPFrameProvider::setCaptureMode(CaptureMode mode)
 {
-    startRtspCapture();
+    captureMode_ = mode;
 }
 
-void TRTCPFrameProvider::startRtspCapture()
+bool TRTCPFrameProvider::openSource()
 {
-    rtspCapture_.reset(new cv::VideoCapture(url_, cv::CAP_FFMPEG));
+    rtspCapture_.reset(new cv::VideoCapture(url_, cv::CAP_FFMPEG, {cv::CAP_PROP_OPEN_TIMEOUT_MSEC, RTSP_OPEN_TIMEOUT,
+                                                                   cv::CAP_PROP_READ_TIMEOUT_MSEC, RTSP_READ_TIMEOUT}));
     if (!rtspCapture_->isOpened()) {
         qDebug() << "Failed to open RTSP stream:" << url_;
-        return;
+        return false;
     }
-
-    rtspTimer_.reset(new QTimer(this));
-    connect(rtspTimer_.get(), &QTimer::timeout, this,&TRTCPFrameProvider::processRtspFrame,Qt::UniqueConnection);
-    rtspTimer_->start(33);
-    ready_();
+    const double fps = rtspCapture_->get(cv::CAP_PROP_FPS);
+    frameInterval_ = fps > 0.0
+        ? std::chrono::duration_cast<TCaptureStep::Clock::duration>(std::chrono::duration<double>(1.0 / fps))
+        : std::chrono::duration_cast<TCaptureStep::Clock::duration>(std::chrono::milliseconds(RTSP_TIMER_PERIOD));
+    retryPeriod_ = RTSP_READ_RETRY_PERIOD;
+    return true;
 }
 
-void TRTCPFrameProvider::stopRtspCapture()
+TCaptureStep TRTCPFrameProvider::captureFrame()
 {
-    if (rtspTimer_.get() != nullptr) {
-        rtspTimer_->stop();
+    using Clock = TCaptureStep::Clock;
+    const Clock::time_point begin = Clock::now();
+    if (!grabFrame()) {
+        const int retryPeriod = retryPeriod_;
+        retryPeriod_ = std::min(retryPeriod_ * 2, RTSP_READ_RETRY_MAX);
+        return TCaptureStep::at(Clock::now() + std::chrono::milliseconds(retryPeriod), false);
     }
+    retryPeriod_ = RTSP_READ_RETRY_PERIOD;
+    if (captureMode_ == CaptureMode::Timer) {
+        return TCaptureStep::at(begin + std::chrono::milliseconds(RTSP_TIMER_PERIOD), true);
+    }
+    const Clock::time_point end = Clock::now();
+    if (std::chrono::duration<double, std::milli>(end - begin).count() < RTSP_BUFFERED_READ) {
+        // The frame was already waiting: read the backlog right away.
+        return TCaptureStep::at(end, true);
+    }
+    return TCaptureStep::at(end + std::chrono::duration_cast<Clock::duration>(frameInterval_ * RTSP_PACING_FACTOR), true);
 }
 
-void TRTCPFrameProvider::processRtspFrame()
+bool TRTCPFrameProvider::grabFrame()
 {
     if (!rtspCapture_ || !rtspCapture_->isOpened()) {
         qDebug() << "RTSP capture not opened";
-        //stopRtspCapture();
-        return;
+        return false;
     }
 
-    cv::Mat frame;
-    if (!rtspCapture_->read(frame)) {
+    if (!rtspCapture_->read(rtspFrame_)) {
         qDebug() << "Failed to read RTSP frame";
-        return;
+        return false;
     }
 
-    if (frame.empty()) {
+    if (rtspFrame_.empty()) {
         qDebug() << "Empty RTSP frame";
-        return;
+        return false;
     }
 
-    cv::Mat processed;
-    if (frame.type() == CV_8UC3) {
-        cv::cvtColor(frame, processed, cv::COLOR_BGR2BGRA);
-    } else if (frame.type() == CV_8UC4) {
-        processed = frame.clone();
-    } else {
-        qDebug() << "Unsupported RTSP frame type:" << frame.type();
-        return;
+    if (rtspFrame_.type() != CV_8UC3 && rtspFrame_.type() != CV_8UC4) {
+        qDebug() << "Unsupported RTSP frame type:" << rtspFrame_.type();
+        return false;
     }
 
-    QImage outputImage((const uchar*)processed.data, processed.cols, processed.rows, processed.step, QImage::Format_RGB32);
-    outputImage = outputImage.copy();
-    {
-        std::lock_guard<std::mutex> lock(framemtx_);
-        frame_ = outputImage;
-        frameReady_ = true;
+    // Convert straight into the pooled packet buffer, no intermediate buffers.
+    TFramePacketPtr packet = acquirePacket();
+    QImage& outputImage = packet->ensureImage(rtspFrame_.cols, rtspFrame_.rows, QImage::Format_RGB32);
+    cv::Mat outputMat(outputImage.height(), outputImage.width(), CV_8UC4, outputImage.bits(), outputImage.bytesPerLine());
+    if (rtspFrame_.type() == CV_8UC3) {
+        cv::cvtColor(rtspFrame_, outputMat, cv::COLOR_BGR2BGRA);
+    } else {
+        rtspFrame_.copyTo(outputMat);
     }
+    publishFrame(std::move(packet));
+    return true;
 }
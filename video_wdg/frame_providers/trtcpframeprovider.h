@@ -10,7 +10,6 @@
 #define TRTCPFRAMEPROVIDER_H
 
 #include <QObject>
-#include <QTimer>
 #include <QDebug>
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
@@ -18,18 +17,46 @@
 
 #include "iframeprovider.h"
 
+constexpr int RTSP_TIMER_PERIOD = 33;       ///< Frame read period in milliseconds for the timer capture mode, and the
+                                            ///< assumed frame interval of streams that report no frame rate.
+constexpr int RTSP_READ_RETRY_PERIOD = 10;  ///< Delay in milliseconds before the first retry of a failed read.
+constexpr int RTSP_READ_RETRY_MAX = 1000;   ///< Longest delay in milliseconds between retries of consecutive failed reads.
+constexpr int RTSP_OPEN_TIMEOUT = 1000;     ///< Time in milliseconds to wait for the stream to open.
+constexpr int RTSP_READ_TIMEOUT = 3 * RTSP_TIMER_PERIOD; ///< Time in milliseconds to wait for a frame of an open stream.
+constexpr double RTSP_BUFFERED_READ = 2.0;  ///< Read time in milliseconds below which the frame was already buffered.
+constexpr double RTSP_PACING_FACTOR = 0.75; ///< Fraction of the frame interval to wait after a frame before the next read.
+
 /*!
  * \class TRTCPFrameProvider
  * \brief Frame provider for RTSP video streams using OpenCV.
  *
  * The `TRTCPFrameProvider` class implements the `IFrameProvider` interface to capture video frames from RTSP streams
- * using OpenCV's `VideoCapture`. It supports configuring the stream URL and periodically processes frames using a timer.
- * The class converts captured frames to a compatible format (`QImage::Format_RGB32`) and provides thread-safe access to them.
+ * using OpenCV's `VideoCapture`. It supports configuring the stream URL and two capture modes: continuous capture
+ * (default), which reads each frame as soon as the decoder delivers it and always keeps only the newest frame, and the
+ * legacy timer mode, which reads one frame per `RTSP_TIMER_PERIOD`. The class converts captured frames to a compatible format (`QImage::Format_RGB32`) and provides thread-safe access to them.
+ *
+ * A read blocks until the stream delivers a frame, which would tie up a shared capture thread for most of every frame
+ * interval. In continuous mode the next read is therefore scheduled `RTSP_PACING_FACTOR` of a frame interval after a
+ * frame arrived, so it blocks only briefly; a read that returns at once means frames are buffered and the next read is
+ * due immediately, so the provider catches up instead of adding latency.
+ *
+ * A dead or stalled stream must not hold a shared thread for FFmpeg's default timeout of about 30 s, nor make stop()
+ * wait that long, so opening gives up after `RTSP_OPEN_TIMEOUT` and a read after `RTSP_READ_TIMEOUT`. Consecutive
+ * failed reads are retried at doubling intervals up to `RTSP_READ_RETRY_MAX`, so a stream that went away costs its
+ * thread only a small fraction of the time.
  */
 class TRTCPFrameProvider : public IFrameProvider
 {
     Q_OBJECT
 public:
+    /*!
+     * \brief Enumeration for capture modes.
+     */
+    enum class CaptureMode : uint {
+        Continuous, ///< Read frames as soon as the decoder delivers them.
+        Timer       ///< Read one frame per RTSP_TIMER_PERIOD.
+    };
+
     /*!
      * \brief Constructs a TRTCPFrameProvider instance.
      * \param parent The parent QObject (default is nullptr).
@@ -39,9 +66,9 @@ public:
     /*!
      * \brief Destructor.
      *
-     * Inherits the base class destructor, which stops the provider.
+     * Stops the provider before the capture objects are destroyed.
      */
-    ~TRTCPFrameProvider() = default;
+    ~TRTCPFrameProvider();
 
     /*!
      * \brief Retrieves the description of the RTSP source.
@@ -77,30 +104,43 @@ public:
      */
     void setUrl(std::string url) override;
 
-protected:
-    void run() override;
-
-private slots:
     /*!
-     * \brief Starts the RTSP capture and timer.
+     * \brief Sets the capture mode.
+     * \param mode The capture mode to use.
+     *
+     * Takes effect on the next read.
      */
-    void startRtspCapture();
+    void setCaptureMode(CaptureMode mode);
 
+protected:
     /*!
-     * \brief Stops the RTSP capture and timer.
+     * \brief Opens the RTSP stream.
+     * \return True if the stream was opened.
      */
-    void stopRtspCapture();
+    bool openSource() override;
 
     /*!
-     * \brief Processes a single RTSP frame.
+     * \brief Reads and publishes one frame.
+     * \return The time of the next read according to the capture mode.
      *
-     * Captures a frame from the RTSP stream, converts it to the required format, and updates the frame buffer.
+     * Each decoded frame replaces the previous one, so the decoder buffer never builds up a backlog; frames replaced
+     * before being retrieved are counted as dropped.
      */
-    void processRtspFrame();
+    TCaptureStep captureFrame() override;
+
 private:
+    /*!
+     * \brief Reads and publishes a single RTSP frame.
+     * \return True if a frame was read and published, false otherwise.
+     */
+    bool grabFrame();
+
     std::unique_ptr<cv::VideoCapture> rtspCapture_= nullptr;   ///< OpenCV video capture for RTSP stream.
-    std::unique_ptr<QTimer> rtspTimer_ = nullptr;              ///< Timer for periodic frame processing.
     std::string url_{};                                        ///< URL of the RTSP stream.
+    std::atomic<CaptureMode> captureMode_{CaptureMode::Continuous}; ///< Active capture mode.
+    cv::Mat rtspFrame_;                                        ///< Decoded frame, reused between reads.
+    TCaptureStep::Clock::duration frameInterval_{};            ///< Frame interval reported by the stream.
+    int retryPeriod_ = RTSP_READ_RETRY_PERIOD;                 ///< Delay in milliseconds before the next retry of a failed read.
 
 };
 
@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "tcaptureexecutor.h"
+
+using Clock = TCaptureStep::Clock;
+
+// Задача, которая считает свои шаги и проверяет, что шаги не выполняются параллельно
+class CountingTask : public TCaptureTask
+{
+public:
+    explicit CountingTask(std::chrono::microseconds period = std::chrono::microseconds(0),
+                          std::chrono::microseconds work = std::chrono::microseconds(0))
+        : period_(period), work_(work) {}
+
+    TCaptureStep captureStep() override {
+        if (inside_.exchange(true)) {
+            overlapped_ = true;
+        }
+        if (work_.count() > 0) {
+            std::this_thread::sleep_for(work_);
+        }
+        ++steps_;
+        inside_ = false;
+        return TCaptureStep::at(Clock::now() + period_, true);
+    }
+
+    std::atomic<uint64_t> steps_{0};
+    std::atomic<bool> overlapped_{false};
+
+private:
+    std::atomic<bool> inside_{false};
+    std::chrono::microseconds period_;
+    std::chrono::microseconds work_;
+};
+
+// Задача, которая после первого шага паркуется до wake()
+class ParkingTask : public TCaptureTask
+{
+public:
+    TCaptureStep captureStep() override {
+        ++steps_;
+        return TCaptureStep::parked();
+    }
+
+    std::atomic<uint64_t> steps_{0};
+};
+
+// Ждёт выполнения условия не дольше timeout
+template <typename Predicate>
+bool waitFor(Predicate predicate, std::chrono::milliseconds timeout = std::chrono::milliseconds(2000))
+{
+    const Clock::time_point end = Clock::now() + timeout;
+    while (!predicate()) {
+        if (Clock::now() > end) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Размер пула задаётся явно, по умолчанию не меньше минимального
+TEST(TCaptureExecutorTest, ThreadCount) {
+    TCaptureExecutor executor(3);
+    EXPECT_EQ(executor.threadCount(), 3u);
+    TCaptureExecutor defaultExecutor;
+    EXPECT_EQ(defaultExecutor.threadCount(), TCaptureExecutor::defaultThreadCount());
+    EXPECT_GE(defaultExecutor.threadCount(), CAPTURE_EXECUTOR_MIN_THREADS);
+}
+
+// Шаги задачи выполняются, после remove() задача больше не запускается
+TEST(TCaptureExecutorTest, AddRemove) {
+    TCaptureExecutor executor(2);
+    CountingTask task(std::chrono::microseconds(1000));
+    executor.add(&task);
+    executor.add(&task);
+    EXPECT_EQ(executor.taskCount(), 1u);
+    ASSERT_TRUE(waitFor([&]() { return task.steps_ >= 5; }));
+    executor.remove(&task);
+    EXPECT_EQ(executor.taskCount(), 0u);
+    const uint64_t steps = task.steps_;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(task.steps_, steps);
+    TCaptureExecutor::Stats stats;
+    EXPECT_FALSE(executor.stats(&task, &stats));
+}
+
+// Шаги одной задачи не выполняются одновременно на нескольких потоках
+TEST(TCaptureExecutorTest, StepsDoNotOverlap) {
+    TCaptureExecutor executor(4);
+    CountingTask task(std::chrono::microseconds(0), std::chrono::microseconds(200));
+    executor.add(&task);
+    ASSERT_TRUE(waitFor([&]() { return task.steps_ >= 100; }));
+    executor.remove(&task);
+    EXPECT_FALSE(task.overlapped_);
+}
+
+// Задачи, которые всегда готовы, делят один поток поровну
+TEST(TCaptureExecutorTest, RoundRobin) {
+    TCaptureExecutor executor(1);
+    std::vector<std::unique_ptr<CountingTask> > tasks;
+    for (int i = 0; i < 4; ++i) {
+        tasks.push_back(std::make_unique<CountingTask>(std::chrono::microseconds(0), std::chrono::microseconds(100)));
+        executor.add(tasks.back().get());
+    }
+    ASSERT_TRUE(waitFor([&]() { return tasks[0]->steps_ >= 200; }));
+    for (auto& task : tasks) {
+        executor.remove(task.get());
+    }
+    uint64_t least = tasks[0]->steps_;
+    uint64_t most = least;
+    for (auto& task : tasks) {
+        least = std::min<uint64_t>(least, task->steps_);
+        most = std::max<uint64_t>(most, task->steps_);
+    }
+    // Каждая задача выполняется по очереди, разница не больше одного шага
+    EXPECT_LE(most - least, 1u);
+}
+
+// Периодическая задача не вытесняется задачами, которые всегда готовы
+TEST(TCaptureExecutorTest, PeriodicTaskIsNotStarved) {
+    TCaptureExecutor executor(1);
+    CountingTask busy1(std::chrono::microseconds(0), std::chrono::microseconds(200));
+    CountingTask busy2(std::chrono::microseconds(0), std::chrono::microseconds(200));
+    CountingTask periodic(std::chrono::microseconds(5000));
+    executor.add(&busy1);
+    executor.add(&busy2);
+    executor.add(&periodic);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    executor.remove(&busy1);
+    executor.remove(&busy2);
+    executor.remove(&periodic);
+    // Около 40 шагов за 200 мс, с запасом на загруженную машину
+    EXPECT_GE(periodic.steps_, 20u);
+    EXPECT_LE(periodic.steps_, 45u);
+}
+
+// Припаркованная задача ждёт wake()
+TEST(TCaptureExecutorTest, ParkAndWake) {
+    TCaptureExecutor executor(2);
+    ParkingTask task;
+    executor.add(&task);
+    ASSERT_TRUE(waitFor([&]() { return task.steps_ == 1; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(task.steps_, 1u);
+    EXPECT_EQ(executor.readyCount(), 0u);
+    executor.wake(&task);
+    ASSERT_TRUE(waitFor([&]() { return task.steps_ == 2; }));
+    executor.remove(&task);
+}
+
+// wake() во время шага не теряется, даже если шаг паркует задачу
+TEST(TCaptureExecutorTest, WakeDuringStep) {
+    // Задача паркуется, но на первом шаге её будят изнутри шага
+    class SelfWakingTask : public TCaptureTask
+    {
+    public:
+        TCaptureStep captureStep() override {
+            if (++steps_ == 1) {
+                executor_->wake(this);
+            }
+            return TCaptureStep::parked();
+        }
+
+        TCaptureExecutor* executor_ = nullptr;
+        std::atomic<uint64_t> steps_{0};
+    };
+
+    TCaptureExecutor executor(2);
+    SelfWakingTask task;
+    task.executor_ = &executor;
+    executor.add(&task);
+    ASSERT_TRUE(waitFor([&]() { return task.steps_ == 2; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(task.steps_, 2u);
+    executor.remove(&task);
+}
+
+// Статистика отражает частоту кадров задачи
+TEST(TCaptureExecutorTest, Stats) {
+    TCaptureExecutor executor(2);
+    CountingTask task(std::chrono::microseconds(10000));
+    executor.add(&task);
+    std::this_thread::sleep_for(std::chrono::milliseconds(CAPTURE_STATS_PERIOD + 300));
+    TCaptureExecutor::Stats stats;
+    ASSERT_TRUE(executor.stats(&task, &stats));
+    executor.remove(&task);
+    // Шаг раз в 10 мс даёт немного меньше 100 кадров в секунду
+    EXPECT_GT(stats.fps, 60.0);
+    EXPECT_LT(stats.fps, 101.0);
+    EXPECT_EQ(stats.frames, stats.steps);
+    EXPECT_GE(stats.frames, 60u);
+    EXPECT_GE(stats.lagMs, 0.0);
+}
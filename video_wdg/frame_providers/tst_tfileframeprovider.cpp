@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+#include <opencv2/videoio.hpp>
+#include "tfileframeprovider.h"
+
+namespace {
+constexpr int WIDTH = 64;
+constexpr int HEIGHT = 48;
+constexpr int REAL_FRAMES = 10;     // Кадров в файле на самом деле
+constexpr int CLAIMED_FRAMES = 20;  // Кадров, записанных в заголовок
+
+std::string tempPath(const char* name) {
+    return testing::TempDir() + name;
+}
+
+// Яркость кадра i
+uchar frameLevel(int i) {
+    return static_cast<uchar>(20 + 20 * i);
+}
+
+// Ждёт выполнения условия не дольше timeout
+template <typename Predicate>
+bool waitFor(Predicate predicate, std::chrono::milliseconds timeout = std::chrono::milliseconds(5000))
+{
+    const auto end = std::chrono::steady_clock::now() + timeout;
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() > end) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Сырой дамп из REAL_FRAMES кадров Gray8, в заголовке указано CLAIMED_FRAMES
+std::string writeShortRawDump() {
+    const std::string path = tempPath("tst_tfileframeprovider.raw");
+    TRawDumpWriter writer;
+    EXPECT_TRUE(writer.open(path, makeRawDumpHeader(TRawPixelFormat::Gray8, WIDTH, HEIGHT, 30.0)));
+    std::vector<uint8_t> frame(WIDTH * HEIGHT);
+    for (int i = 0; i < REAL_FRAMES; ++i) {
+        std::fill(frame.begin(), frame.end(), frameLevel(i));
+        EXPECT_TRUE(writer.writeFrame(frame.data()));
+    }
+    writer.close();
+    // Завышаем число кадров в заголовке, как это делают некоторые контейнеры
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    TRawDumpHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    header.frameCount = CLAIMED_FRAMES;
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return path;
+}
+
+// AVI из CLAIMED_FRAMES кадров MJPEG, обрезанный после REAL_FRAMES кадров: заголовок завышает число кадров,
+// а индекса в конце файла нет, поэтому точная перемотка невозможна
+std::string writeTruncatedVideo() {
+    const std::string path = tempPath("tst_tfileframeprovider.avi");
+    {
+        cv::VideoWriter writer(path, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), 30.0, cv::Size(WIDTH, HEIGHT));
+        if (!writer.isOpened()) {
+            return std::string();
+        }
+        for (int i = 0; i < CLAIMED_FRAMES; ++i) {
+            writer.write(cv::Mat(HEIGHT, WIDTH, CV_8UC3, cv::Scalar::all(frameLevel(i % REAL_FRAMES))));
+        }
+    }
+    std::ifstream in(path, std::ios::binary);
+    std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    // Ищем начало кадра REAL_FRAMES среди блоков списка movi
+    const char movi[] = "movi";
+    auto it = std::search(data.begin(), data.end(), movi, movi + 4);
+    if (it == data.end()) {
+        return std::string();
+    }
+    size_t offset = static_cast<size_t>(it - data.begin()) + 4;
+    int frames = 0;
+    while (offset + 8 <= data.size()) {
+        if (std::memcmp(&data[offset + 2], "dc", 2) == 0 && frames++ == REAL_FRAMES) {
+            break;
+        }
+        uint32_t size = 0;
+        std::memcpy(&size, &data[offset + 4], sizeof(size));
+        offset += 8 + size + (size & 1);
+    }
+    if (frames <= REAL_FRAMES) {
+        return std::string();
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), static_cast<std::streamsize>(offset));
+    return path;
+}
+
+// Перемотка за фактический конец файла: позиция и число кадров соответствуют концу файла, а следующая
+// перемотка внутри файла показывает нужный кадр
+void checkSeekPastEnd(const std::string& path) {
+    TCaptureExecutor executor(1);
+    TFileFrameProvider provider;
+    provider.setExecutor(&executor);
+    provider.setUrl(path);
+    provider.setFrameRate(FILE_RATE_UNTHROTTLED);
+    provider.start([]() {});
+
+    provider.seek(CLAIMED_FRAMES - 5);
+    ASSERT_TRUE(waitFor([&]() { return provider.frameCount() == REAL_FRAMES && provider.position() == REAL_FRAMES; }));
+    // Провайдер стоит в конце файла и не портит счётчик
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(provider.frameCount(), REAL_FRAMES);
+    EXPECT_EQ(provider.position(), REAL_FRAMES);
+
+    // Кадры медленно, чтобы поймать первый кадр после перемотки
+    provider.setFrameRate(2.0);
+    provider.getFrame();
+    provider.seek(3);
+    ASSERT_TRUE(waitFor([&]() { return provider.isReady(); }));
+    TFramePacketPtr packet = provider.getFrame();
+    ASSERT_TRUE(packet);
+    EXPECT_NEAR(qGray(packet->image.pixel(WIDTH / 2, HEIGHT / 2)), frameLevel(3), 4);
+    EXPECT_EQ(provider.position(), 4);
+    EXPECT_EQ(provider.frameCount(), REAL_FRAMES);
+    provider.stop();
+}
+}
+
+// Сырой дамп с завышенным числом кадров в заголовке
+TEST(TFileFrameProviderTest, RawDumpSeekPastEnd) {
+    const std::string path = writeShortRawDump();
+    checkSeekPastEnd(path);
+    std::remove(path.c_str());
+}
+
+// Видео, контейнер которого завышает число кадров
+TEST(TFileFrameProviderTest, VideoSeekPastEnd) {
+    const std::string path = writeTruncatedVideo();
+    if (path.empty()) {
+        GTEST_SKIP() << "MJPEG AVI writer is not available";
+    }
+    checkSeekPastEnd(path);
+    std::remove(path.c_str());
+}
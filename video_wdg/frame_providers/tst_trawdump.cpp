@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include "trawdump.h"
+
+namespace {
+// Читает файл целиком
+std::vector<uint8_t> readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+std::string tempPath(const char* name) {
+    return testing::TempDir() + name;
+}
+}
+
+// Размер кадра для каждого формата при плотной упаковке строк
+TEST(TRawDumpTest, FrameSizes) {
+    EXPECT_EQ(rawFrameSize(makeRawDumpHeader(TRawPixelFormat::BGRA32, 640, 480, 30.0)), 640u * 480 * 4);
+    EXPECT_EQ(rawFrameSize(makeRawDumpHeader(TRawPixelFormat::Gray8, 641, 481, 30.0)), 641u * 481);
+    EXPECT_EQ(rawFrameSize(makeRawDumpHeader(TRawPixelFormat::BGR24, 641, 480, 30.0)), 641u * 480 * 3);
+    EXPECT_EQ(rawFrameSize(makeRawDumpHeader(TRawPixelFormat::NV12, 640, 480, 30.0)), 640u * 480 * 3 / 2);
+    EXPECT_EQ(rawFrameSize(makeRawDumpHeader(TRawPixelFormat::I420, 640, 480, 30.0)), 640u * 480 * 3 / 2);
+    EXPECT_EQ(rawFrameSize(makeRawDumpHeader(TRawPixelFormat::YUYV, 640, 480, 30.0)), 640u * 480 * 2);
+
+    // Строки с выравниванием
+    TRawDumpHeader header = makeRawDumpHeader(TRawPixelFormat::NV12, 640, 480, 30.0);
+    header.bytesPerLine = 704;
+    EXPECT_EQ(rawFrameSize(header), 704u * 480 * 3 / 2);
+}
+
+// Неверная сигнатура, версия, формат или геометрия отклоняются
+TEST(TRawDumpTest, RejectsInvalidHeaders) {
+    EXPECT_TRUE(isValidRawDumpHeader(makeRawDumpHeader(TRawPixelFormat::BGRA32, 2, 2, 0.0)));
+
+    TRawDumpHeader header = makeRawDumpHeader(TRawPixelFormat::BGRA32, 2, 2, 0.0);
+    header.magic[0] = 'X';
+    EXPECT_FALSE(isValidRawDumpHeader(header));
+    header = makeRawDumpHeader(TRawPixelFormat::BGRA32, 2, 2, 0.0);
+    header.version = RAW_DUMP_VERSION + 1;
+    EXPECT_FALSE(isValidRawDumpHeader(header));
+    header = makeRawDumpHeader(TRawPixelFormat::BGRA32, 2, 2, 0.0);
+    header.format = 100;
+    EXPECT_FALSE(isValidRawDumpHeader(header));
+    header = makeRawDumpHeader(TRawPixelFormat::BGRA32, 2, 2, 0.0);
+    header.bytesPerLine = 7;
+    EXPECT_FALSE(isValidRawDumpHeader(header));
+    EXPECT_EQ(rawFrameSize(header), 0u);
+    EXPECT_FALSE(isValidRawDumpHeader(makeRawDumpHeader(TRawPixelFormat::Gray8, 0, 2, 0.0)));
+    EXPECT_FALSE(isValidRawDumpHeader(makeRawDumpHeader(TRawPixelFormat::NV12, 4, 3, 0.0)));
+    EXPECT_FALSE(isValidRawDumpHeader(makeRawDumpHeader(TRawPixelFormat::YUYV, 3, 4, 0.0)));
+    EXPECT_TRUE(isValidRawDumpHeader(makeRawDumpHeader(TRawPixelFormat::YUYV, 4, 3, 0.0)));
+}
+
+// Записанный дамп читается обратно: заголовок, число кадров и содержимое кадров
+TEST(TRawDumpTest, WriteAndRead) {
+    const std::string path = tempPath("tst_trawdump_write.raw");
+    const TRawDumpHeader header = makeRawDumpHeader(TRawPixelFormat::Gray8, 5, 3, 25.0);
+    {
+        TRawDumpWriter writer;
+        ASSERT_TRUE(writer.open(path, header));
+        for (uint8_t i = 0; i < 4; ++i) {
+            const std::vector<uint8_t> frame(15, i);
+            ASSERT_TRUE(writer.writeFrame(frame.data()));
+        }
+        EXPECT_EQ(writer.frameCount(), 4u);
+    }
+
+    const std::vector<uint8_t> data = readFile(path);
+    ASSERT_EQ(data.size(), RAW_DUMP_HEADER_SIZE + 4 * 15);
+    TRawDumpHeader read;
+    ASSERT_TRUE(readRawDumpHeader(data.data(), data.size(), &read));
+    EXPECT_EQ(read.frameCount, 4u);
+    EXPECT_EQ(read.width, 5u);
+    EXPECT_EQ(read.height, 3u);
+    EXPECT_EQ(read.fps, 25.0);
+    EXPECT_EQ(read.format, static_cast<uint32_t>(TRawPixelFormat::Gray8));
+    for (size_t i = 0; i < 4; ++i) {
+        EXPECT_EQ(data[RAW_DUMP_HEADER_SIZE + i * 15], i);
+        EXPECT_EQ(data[RAW_DUMP_HEADER_SIZE + i * 15 + 14], i);
+    }
+    std::remove(path.c_str());
+}
+
+// Незавершенный дамп (запись прервана) воспроизводится по фактически записанным кадрам
+TEST(TRawDumpTest, TruncatedDump) {
+    TRawDumpHeader header = makeRawDumpHeader(TRawPixelFormat::BGRA32, 2, 2, 0.0);
+    header.frameCount = 10;
+    std::vector<uint8_t> data(RAW_DUMP_HEADER_SIZE + 3 * 16 + 5);
+    std::memcpy(data.data(), &header, sizeof(header));
+    TRawDumpHeader read;
+    ASSERT_TRUE(readRawDumpHeader(data.data(), data.size(), &read));
+    EXPECT_EQ(read.frameCount, 3u);
+
+    EXPECT_FALSE(readRawDumpHeader(data.data(), RAW_DUMP_HEADER_SIZE - 1, &read));
+    EXPECT_FALSE(readRawDumpHeader(nullptr, data.size(), &read));
+}
+
+// Некорректный заголовок не открывает файл
+TEST(TRawDumpTest, WriterRejectsInvalidHeader) {
+    TRawDumpWriter writer;
+    EXPECT_FALSE(writer.open(tempPath("tst_trawdump_invalid.raw"), makeRawDumpHeader(TRawPixelFormat::I420, 3, 2, 0.0)));
+    EXPECT_FALSE(writer.isOpen());
+    const uint8_t frame[6] = {};
+    EXPECT_FALSE(writer.writeFrame(frame));
+}
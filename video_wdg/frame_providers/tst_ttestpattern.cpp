@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include "ttestpattern.h"
+
+namespace {
+const double kPi = 3.14159265358979323846;
+const TTestPattern::Kind kKinds[] = {TTestPattern::Kind::MovingEdges, TTestPattern::Kind::Circles,
+                                     TTestPattern::Kind::Noise, TTestPattern::Kind::Gradient};
+
+// Кадр B G R A с выравниванием строк
+struct Frame {
+    unsigned int width;
+    unsigned int height;
+    size_t bytesPerLine;
+    std::vector<uint8_t> data;
+
+    Frame(unsigned int w, unsigned int h) : width(w), height(h), bytesPerLine(4 * w + 12), data(bytesPerLine * h, 0x5A) {}
+    uint8_t* row(unsigned int y) { return data.data() + y * bytesPerLine; }
+    uint8_t gray(unsigned int x, unsigned int y) const { return data[y * bytesPerLine + 4 * x]; }
+};
+
+Frame render(const TTestPattern& pattern, unsigned int width, unsigned int height, const TTestPattern::Stamp& stamp) {
+    Frame frame(width, height);
+    pattern.render(frame.data.data(), frame.bytesPerLine, width, height, stamp);
+    return frame;
+}
+
+// Уменьшение кадра усреднением по области, как cv::INTER_AREA
+Frame downscale(const Frame& src, unsigned int width, unsigned int height) {
+    Frame dst(width, height);
+    for (unsigned int y = 0; y < height; ++y) {
+        for (unsigned int x = 0; x < width; ++x) {
+            const unsigned int x0 = x * src.width / width;
+            const unsigned int x1 = std::max(x0 + 1, (x + 1) * src.width / width);
+            const unsigned int y0 = y * src.height / height;
+            const unsigned int y1 = std::max(y0 + 1, (y + 1) * src.height / height);
+            for (int c = 0; c < 4; ++c) {
+                unsigned int sum = 0;
+                for (unsigned int sy = y0; sy < y1; ++sy) {
+                    for (unsigned int sx = x0; sx < x1; ++sx) {
+                        sum += src.data[sy * src.bytesPerLine + 4 * sx + c];
+                    }
+                }
+                dst.row(y)[4 * x + c] = static_cast<uint8_t>(sum / ((x1 - x0) * (y1 - y0)));
+            }
+        }
+    }
+    return dst;
+}
+}
+
+// Метка читается обратно для всех узоров и размеров
+TEST(TTestPatternTest, StampRoundTrip) {
+    TTestPattern pattern;
+    const TTestPattern::Stamp stamp{0x0123456789ABCDEFull, 0xFEDCBA9876543210ull};
+    for (TTestPattern::Kind kind : kKinds) {
+        pattern.setKind(kind);
+        for (unsigned int width : {64u, 640u, 1280u, 1921u}) {
+            const unsigned int height = TTestPattern::stampHeight(width) + 7;
+            const Frame frame = render(pattern, width, height, stamp);
+            TTestPattern::Stamp decoded;
+            ASSERT_TRUE(TTestPattern::decodeStamp(frame.data.data(), frame.bytesPerLine, width, height, &decoded))
+                << TTestPattern::kindName(kind) << " " << width;
+            EXPECT_EQ(decoded.frame, stamp.frame);
+            EXPECT_EQ(decoded.timestampUs, stamp.timestampUs);
+        }
+    }
+}
+
+// Метка читается и после уменьшения кадра для отображения
+TEST(TTestPatternTest, StampSurvivesDownscale) {
+    TTestPattern pattern;
+    pattern.setKind(TTestPattern::Kind::Noise);
+    const TTestPattern::Stamp stamp{12345, 987654321};
+    const Frame frame = render(pattern, 1920, 1080, stamp);
+    for (double scale : {0.5, 0.37, 0.25}) {
+        const unsigned int width = static_cast<unsigned int>(1920 * scale);
+        const unsigned int height = static_cast<unsigned int>(1080 * scale);
+        const Frame small = downscale(frame, width, height);
+        TTestPattern::Stamp decoded;
+        ASSERT_TRUE(TTestPattern::decodeStamp(small.data.data(), small.bytesPerLine, width, height, &decoded)) << scale;
+        EXPECT_EQ(decoded.frame, stamp.frame);
+        EXPECT_EQ(decoded.timestampUs, stamp.timestampUs);
+    }
+}
+
+// Поврежденная метка отклоняется контрольной суммой, слишком маленький кадр метки не несет
+TEST(TTestPatternTest, RejectsCorruptedStamp) {
+    TTestPattern pattern;
+    Frame frame = render(pattern, 640, 480, TTestPattern::Stamp{7, 8});
+    TTestPattern::Stamp decoded;
+    ASSERT_TRUE(TTestPattern::decodeStamp(frame.data.data(), frame.bytesPerLine, 640, 480, &decoded));
+    // Инвертируем одну ячейку счетчика кадров
+    for (unsigned int y = 0; y < 20; ++y) {
+        for (unsigned int x = 620; x < 640; ++x) {
+            for (int c = 0; c < 3; ++c) {
+                frame.row(y)[4 * x + c] ^= 0xFF;
+            }
+        }
+    }
+    EXPECT_FALSE(TTestPattern::decodeStamp(frame.data.data(), frame.bytesPerLine, 640, 480, &decoded));
+
+    const Frame small = render(pattern, 63, 40, TTestPattern::Stamp{7, 8});
+    EXPECT_FALSE(TTestPattern::decodeStamp(small.data.data(), small.bytesPerLine, 63, 40, &decoded));
+    EXPECT_FALSE(TTestPattern::decodeStamp(frame.data.data(), frame.bytesPerLine, 640, 99, &decoded));
+}
+
+// Края полос находятся в известных позициях и сдвигаются на заданный шаг за кадр
+TEST(TTestPatternTest, MovingEdgesAtKnownPositions) {
+    TTestPattern pattern;
+    pattern.setKind(TTestPattern::Kind::MovingEdges);
+    pattern.setBarWidth(20);
+    pattern.setEdgeSpeed(3);
+    const unsigned int width = 640;
+    const unsigned int height = 200;
+    for (uint64_t n : {0ull, 1ull, 13ull, 1000001ull}) {
+        const Frame frame = render(pattern, width, height, TTestPattern::Stamp{n, 0});
+        std::vector<unsigned int> edges;
+        const unsigned int y = height - 1;
+        for (unsigned int x = 1; x < width; ++x) {
+            if (frame.gray(x, y) != frame.gray(x - 1, y)) {
+                edges.push_back(x);
+            }
+        }
+        EXPECT_EQ(edges, pattern.edgePositions(width, n)) << n;
+        ASSERT_FALSE(edges.empty());
+        EXPECT_EQ(edges.front(), (n * 3) % 20 == 0 ? 20 : (n * 3) % 20) << n;
+    }
+}
+
+// Диски имеют заданный радиус и лежат ниже метки
+TEST(TTestPatternTest, CirclesOfKnownRadius) {
+    TTestPattern pattern;
+    pattern.setKind(TTestPattern::Kind::Circles);
+    pattern.setCircleRadius(25);
+    const unsigned int width = 640;
+    const unsigned int height = 480;
+    const Frame frame = render(pattern, width, height, TTestPattern::Stamp{1, 2});
+    const auto centers = pattern.circleCenters(width, height);
+    ASSERT_EQ(centers.size(), 8u * 5u);
+
+    size_t white = 0;
+    for (unsigned int y = TTestPattern::stampHeight(width); y < height; ++y) {
+        for (unsigned int x = 0; x < width; ++x) {
+            white += frame.gray(x, y) == 255 ? 1 : 0;
+        }
+    }
+    // Площадь дискретного диска совпадает с pi * r^2 с точностью до периметра
+    const double area = kPi * 25 * 25;
+    EXPECT_NEAR(static_cast<double>(white) / centers.size(), area, 2 * kPi * 25 * 0.1);
+
+    for (const auto& center : centers) {
+        ASSERT_GE(center.second - 25, TTestPattern::stampHeight(width));
+        const unsigned int cx = static_cast<unsigned int>(center.first);
+        const unsigned int cy = static_cast<unsigned int>(center.second);
+        // Диаметр по строке через центр - ровно 2r
+        unsigned int run = 0;
+        for (unsigned int x = cx - 30; x < cx + 30; ++x) {
+            run += frame.gray(x, cy) == 255 ? 1 : 0;
+        }
+        EXPECT_EQ(run, 50u);
+        EXPECT_EQ(frame.gray(cx + 25, cy), 0);
+        EXPECT_EQ(frame.gray(cx - 26, cy), 0);
+    }
+}
+
+// Шум воспроизводим для номера кадра и меняется от кадра к кадру; все пиксели непрозрачны
+TEST(TTestPatternTest, NoiseIsReproducible) {
+    TTestPattern pattern;
+    pattern.setKind(TTestPattern::Kind::Noise);
+    const Frame a = render(pattern, 320, 240, TTestPattern::Stamp{5, 0});
+    const Frame b = render(pattern, 320, 240, TTestPattern::Stamp{5, 0});
+    const Frame c = render(pattern, 320, 240, TTestPattern::Stamp{6, 0});
+    const unsigned int top = TTestPattern::stampHeight(320);
+    size_t same = 0;
+    double sum = 0;
+    for (unsigned int y = top; y < 240; ++y) {
+        for (unsigned int x = 0; x < 320; ++x) {
+            EXPECT_EQ(a.gray(x, y), b.gray(x, y));
+            same += a.gray(x, y) == c.gray(x, y) ? 1 : 0;
+            sum += a.gray(x, y);
+            ASSERT_EQ(a.data[y * a.bytesPerLine + 4 * x + 3], 255);
+        }
+    }
+    const double pixels = 320.0 * (240 - top);
+    EXPECT_LT(same, pixels / 64);
+    EXPECT_NEAR(sum / pixels, 127.5, 2.0);
+}
+
+// Градиент: синий растет слева направо, зеленый сверху вниз
+TEST(TTestPatternTest, Gradient) {
+    TTestPattern pattern;
+    pattern.setKind(TTestPattern::Kind::Gradient);
+    const Frame frame = render(pattern, 256, 256, TTestPattern::Stamp{});
+    const uint8_t* last = frame.data.data() + 255 * frame.bytesPerLine + 4 * 255;
+    EXPECT_EQ(last[0], 255);
+    EXPECT_EQ(last[1], 255);
+    EXPECT_EQ(last[2], 0);
+    const uint8_t* middle = frame.data.data() + 128 * frame.bytesPerLine + 4 * 64;
+    EXPECT_EQ(middle[0], 64);
+    EXPECT_EQ(middle[1], 128);
+    EXPECT_EQ(middle[2], 255 - 64);
+}
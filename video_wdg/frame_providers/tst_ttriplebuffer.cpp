@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <atomic>
+#include <set>
+#include <thread>
+#include "ttriplebuffer.h"
+
+// Слот с данными, которые легко проверить на целостность
+struct TestSlot {
+    uint64_t seq = 0;
+    std::array<uint64_t, 64> payload{};
+};
+
+// Пустой буфер не содержит новых данных
+TEST(TTripleBufferTest, EmptyBuffer) {
+    TTripleBuffer<int> buffer;
+    EXPECT_FALSE(buffer.hasNew());
+    EXPECT_FALSE(buffer.consume());
+}
+
+// Опубликованное значение доступно потребителю
+TEST(TTripleBufferTest, PublishConsume) {
+    TTripleBuffer<int> buffer;
+    buffer.back() = 42;
+    EXPECT_FALSE(buffer.publish());
+    EXPECT_TRUE(buffer.hasNew());
+    EXPECT_TRUE(buffer.consume());
+    EXPECT_EQ(buffer.front(), 42);
+    EXPECT_FALSE(buffer.hasNew());
+    EXPECT_FALSE(buffer.consume());
+    EXPECT_EQ(buffer.front(), 42);
+}
+
+// Непрочитанное значение заменяется новым и считается потерянным
+TEST(TTripleBufferTest, LatestValueWins) {
+    TTripleBuffer<int> buffer;
+    buffer.back() = 1;
+    EXPECT_FALSE(buffer.publish());
+    buffer.back() = 2;
+    EXPECT_TRUE(buffer.publish());
+    buffer.back() = 3;
+    EXPECT_TRUE(buffer.publish());
+    EXPECT_TRUE(buffer.consume());
+    EXPECT_EQ(buffer.front(), 3);
+}
+
+// Буферы переиспользуются, новые слоты не создаются
+TEST(TTripleBufferTest, SlotsAreReused) {
+    TTripleBuffer<int> buffer;
+    std::set<const int*> slots;
+    for (int i = 0; i < 100; ++i) {
+        slots.insert(&buffer.back());
+        buffer.back() = i;
+        buffer.publish();
+        if (i % 3 == 0) {
+            buffer.consume();
+            slots.insert(&buffer.front());
+        }
+    }
+    EXPECT_EQ(slots.size(), 3u);
+}
+
+// Нагрузочный тест: производитель и потребитель работают одновременно
+TEST(TTripleBufferTest, ConcurrentStress) {
+    constexpr uint64_t FRAMES = 2000000;
+    TTripleBuffer<TestSlot> buffer;
+    std::atomic<bool> done{false};
+
+    std::thread producer([&]() {
+        for (uint64_t seq = 1; seq <= FRAMES; ++seq) {
+            TestSlot& slot = buffer.back();
+            slot.seq = seq;
+            slot.payload.fill(seq);
+            buffer.publish();
+        }
+        done = true;
+    });
+
+    uint64_t lastSeq = 0;
+    uint64_t received = 0;
+    bool consistent = true;
+    bool ordered = true;
+    while (true) {
+        bool finished = done;
+        if (buffer.consume()) {
+            const TestSlot& slot = buffer.front();
+            for (uint64_t v : slot.payload) {
+                if (v != slot.seq) {
+                    consistent = false;
+                }
+            }
+            if (slot.seq <= lastSeq) {
+                ordered = false;
+            }
+            lastSeq = slot.seq;
+            ++received;
+        } else if (finished) {
+            break;
+        }
+    }
+    producer.join();
+
+    EXPECT_TRUE(consistent) << "Consumer observed a partially written slot";
+    EXPECT_TRUE(ordered) << "Consumer observed frames out of order";
+    EXPECT_EQ(lastSeq, FRAMES) << "Consumer must end with the latest frame";
+    EXPECT_GT(received, 0u);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,230 @@
+#include "ttestpattern.h"
+#include <cstring>
+#include <initializer_list>
+
+namespace {
+constexpr unsigned int STAMP_BITS = TEST_STAMP_COLUMNS * TEST_STAMP_ROWS;
+
+// Fills pixels [from, to) of a row with an opaque gray.
+void fillRow(uint8_t* row, unsigned int from, unsigned int to, uint8_t value)
+{
+    for (uint8_t* px = row + 4 * static_cast<size_t>(from); px < row + 4 * static_cast<size_t>(to); px += 4) {
+        px[0] = px[1] = px[2] = value;
+        px[3] = 255;
+    }
+}
+
+// FNV-1a over the little endian bytes of the counter and the timestamp.
+uint32_t stampChecksum(const TTestPattern::Stamp& stamp)
+{
+    uint32_t hash = 2166136261u;
+    for (uint64_t value : {stamp.frame, stamp.timestampUs}) {
+        for (int i = 0; i < 8; ++i) {
+            hash ^= static_cast<uint8_t>(value >> (8 * i));
+            hash *= 16777619u;
+        }
+    }
+    return hash;
+}
+
+// Bit i of the stamp, most significant bit of each field first.
+bool stampBit(const TTestPattern::Stamp& stamp, uint32_t checksum, unsigned int i)
+{
+    if (i < 64) {
+        return (stamp.frame >> (63 - i)) & 1;
+    }
+    if (i < 128) {
+        return (stamp.timestampUs >> (127 - i)) & 1;
+    }
+    return (checksum >> (159 - i)) & 1;
+}
+
+// Cell boundaries scale with the frame width, so a downscaled frame keeps the same cell grid.
+unsigned int cellEdge(unsigned int width, unsigned int index)
+{
+    return static_cast<unsigned int>(static_cast<uint64_t>(index) * width / TEST_STAMP_COLUMNS);
+}
+
+uint64_t splitMix(uint64_t value)
+{
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+}
+
+void TTestPattern::render(uint8_t *bgra, size_t bytesPerLine, unsigned int width, unsigned int height,
+                          const Stamp &stamp) const
+{
+    switch (kind_) {
+    case Kind::MovingEdges: {
+        const unsigned int period = 2 * barWidth_;
+        const unsigned int offset = barOffset(stamp.frame);
+        uint8_t* first = bgra;
+        for (unsigned int x = 0; x < width; ++x) {
+            const bool white = (x + period - offset) % period < barWidth_;
+            fillRow(first, x, x + 1, white ? 255 : 0);
+        }
+        for (unsigned int y = 1; y < height; ++y) {
+            std::memcpy(bgra + y * bytesPerLine, first, 4 * static_cast<size_t>(width));
+        }
+        break;
+    }
+    case Kind::Circles: {
+        for (unsigned int y = 0; y < height; ++y) {
+            fillRow(bgra + y * bytesPerLine, 0, width, 0);
+        }
+        const double r2 = static_cast<double>(circleRadius_) * circleRadius_;
+        for (const auto& center : circleCenters(width, height)) {
+            const unsigned int top = static_cast<unsigned int>(center.second) - circleRadius_;
+            const unsigned int left = static_cast<unsigned int>(center.first) - circleRadius_;
+            for (unsigned int y = top; y < top + 2 * circleRadius_; ++y) {
+                uint8_t* row = bgra + y * bytesPerLine;
+                const double dy = y + 0.5 - center.second;
+                for (unsigned int x = left; x < left + 2 * circleRadius_; ++x) {
+                    const double dx = x + 0.5 - center.first;
+                    if (dx * dx + dy * dy <= r2) {
+                        fillRow(row, x, x + 1, 255);
+                    }
+                }
+            }
+        }
+        break;
+    }
+    case Kind::Noise: {
+        uint64_t state = splitMix(stamp.frame);
+        for (unsigned int y = 0; y < height; ++y) {
+            uint8_t* row = bgra + y * bytesPerLine;
+            uint64_t bits = 0;
+            for (unsigned int x = 0; x < width; ++x, bits >>= 8) {
+                if (x % 8 == 0) {
+                    // xorshift64*
+                    state ^= state >> 12;
+                    state ^= state << 25;
+                    state ^= state >> 27;
+                    bits = state * 0x2545F4914F6CDD1Dull;
+                }
+                const uint8_t value = static_cast<uint8_t>(bits);
+                row[4 * x] = row[4 * x + 1] = row[4 * x + 2] = value;
+                row[4 * x + 3] = 255;
+            }
+        }
+        break;
+    }
+    case Kind::Gradient:
+        for (unsigned int y = 0; y < height; ++y) {
+            uint8_t* row = bgra + y * bytesPerLine;
+            const uint8_t green = height > 1 ? static_cast<uint8_t>(y * 255u / (height - 1)) : 0;
+            for (unsigned int x = 0; x < width; ++x) {
+                const uint8_t blue = width > 1 ? static_cast<uint8_t>(x * 255u / (width - 1)) : 0;
+                row[4 * x] = blue;
+                row[4 * x + 1] = green;
+                row[4 * x + 2] = static_cast<uint8_t>(255 - blue);
+                row[4 * x + 3] = 255;
+            }
+        }
+        break;
+    }
+
+    if (width < TEST_STAMP_MIN_WIDTH || height < stampHeight(width)) {
+        return;
+    }
+    const uint32_t checksum = stampChecksum(stamp);
+    for (unsigned int i = 0; i < STAMP_BITS; ++i) {
+        const unsigned int column = i % TEST_STAMP_COLUMNS;
+        const unsigned int line = i / TEST_STAMP_COLUMNS;
+        const uint8_t value = stampBit(stamp, checksum, i) ? 255 : 0;
+        for (unsigned int y = cellEdge(width, line); y < cellEdge(width, line + 1); ++y) {
+            fillRow(bgra + y * bytesPerLine, cellEdge(width, column), cellEdge(width, column + 1), value);
+        }
+    }
+}
+
+std::vector<unsigned int> TTestPattern::edgePositions(unsigned int width, uint64_t frame) const
+{
+    std::vector<unsigned int> edges;
+    // Edges lie where a bar starts: (x - offset) is a multiple of the bar width.
+    const unsigned int first = barOffset(frame) % barWidth_;
+    for (unsigned int x = first; x < width; x += barWidth_) {
+        if (x > 0) {
+            edges.push_back(x);
+        }
+    }
+    return edges;
+}
+
+std::vector<std::pair<double, double> > TTestPattern::circleCenters(unsigned int width, unsigned int height) const
+{
+    std::vector<std::pair<double, double> > centers;
+    const unsigned int top = width >= TEST_STAMP_MIN_WIDTH && height >= stampHeight(width) ? stampHeight(width) : 0;
+    // Discs one radius apart, the grid centred in the area below the stamp.
+    const unsigned int spacing = 3 * circleRadius_;
+    const unsigned int columns = width / spacing;
+    const unsigned int rows = (height - top) / spacing;
+    const unsigned int left = (width - columns * spacing) / 2 + spacing / 2;
+    const unsigned int upper = top + (height - top - rows * spacing) / 2 + spacing / 2;
+    for (unsigned int j = 0; j < rows; ++j) {
+        for (unsigned int i = 0; i < columns; ++i) {
+            centers.emplace_back(left + i * spacing, upper + j * spacing);
+        }
+    }
+    return centers;
+}
+
+unsigned int TTestPattern::stampHeight(unsigned int width)
+{
+    return cellEdge(width, TEST_STAMP_ROWS);
+}
+
+bool TTestPattern::decodeStamp(const uint8_t *bgra, size_t bytesPerLine, unsigned int width, unsigned int height,
+                               Stamp *stamp)
+{
+    if (!bgra || width < TEST_STAMP_MIN_WIDTH || height < stampHeight(width)) {
+        return false;
+    }
+    Stamp decoded;
+    uint32_t checksum = 0;
+    for (unsigned int i = 0; i < STAMP_BITS; ++i) {
+        // Sample the middle of the cell.
+        const unsigned int x = static_cast<unsigned int>((2 * static_cast<uint64_t>(i % TEST_STAMP_COLUMNS) + 1) * width
+                                                         / (2 * TEST_STAMP_COLUMNS));
+        const unsigned int y = static_cast<unsigned int>((2 * static_cast<uint64_t>(i / TEST_STAMP_COLUMNS) + 1) * width
+                                                         / (2 * TEST_STAMP_COLUMNS));
+        const uint8_t* px = bgra + y * bytesPerLine + 4 * static_cast<size_t>(x);
+        const uint64_t bit = (px[0] + px[1] + px[2]) >= 3 * 128 ? 1 : 0;
+        if (i < 64) {
+            decoded.frame = (decoded.frame << 1) | bit;
+        } else if (i < 128) {
+            decoded.timestampUs = (decoded.timestampUs << 1) | bit;
+        } else {
+            checksum = (checksum << 1) | static_cast<uint32_t>(bit);
+        }
+    }
+    if (checksum != stampChecksum(decoded)) {
+        return false;
+    }
+    *stamp = decoded;
+    return true;
+}
+
+const char *TTestPattern::kindName(Kind kind)
+{
+    switch (kind) {
+    case Kind::MovingEdges:
+        return "moving edges";
+    case Kind::Circles:
+        return "circles";
+    case Kind::Noise:
+        return "noise";
+    case Kind::Gradient:
+        return "gradient";
+    }
+    return "unknown";
+}
+
+unsigned int TTestPattern::barOffset(uint64_t frame) const
+{
+    const unsigned int period = 2 * barWidth_;
+    return static_cast<unsigned int>((frame % period) * edgeSpeed_ % period);
+}
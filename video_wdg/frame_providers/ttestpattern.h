@@ -0,0 +1,156 @@
+/** @file
+ *
+ * TVideoWdg - SimpleMeasurementByVideoTool
+ * By Ilia.belou <ilia.belou@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef TTESTPATTERN_H
+#define TTESTPATTERN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+constexpr unsigned int TEST_STAMP_COLUMNS = 32;  ///< Cells per row of the stamp; a cell is 1/32 of the frame width.
+constexpr unsigned int TEST_STAMP_ROWS = 5;      ///< Rows of cells: 64-bit frame counter, 64-bit timestamp, 32-bit checksum.
+constexpr unsigned int TEST_STAMP_MIN_WIDTH = 64; ///< Narrowest frame that carries a stamp (2 pixels per cell).
+
+/*!
+ * \class TTestPattern
+ * \brief Renders synthetic test frames with an embedded frame counter and timestamp.
+ *
+ * The `TTestPattern` class draws one of several patterns into a 32-bit B G R A buffer (`QImage::Format_RGB32` on
+ * little endian systems): vertical bars whose edges move by a fixed step per frame, a grid of discs of known radius,
+ * reproducible noise, or a colour gradient. The geometry of every pattern is known exactly (see edgePositions() and
+ * circleCenters()), so measurements on the frames can be checked automatically.
+ *
+ * The top of each frame holds a stamp: `TEST_STAMP_ROWS` rows of `TEST_STAMP_COLUMNS` black or white square cells
+ * encoding the frame counter, a timestamp and a checksum. Cells scale with the frame width, so decodeStamp() also reads
+ * frames that were downscaled for display. Comparing the decoded values with the frames actually seen measures drops
+ * and end-to-end latency exactly.
+ */
+class TTestPattern
+{
+public:
+    /*!
+     * \brief Enumeration for the patterns.
+     */
+    enum class Kind : unsigned int {
+        MovingEdges,    ///< White and black vertical bars moving right.
+        Circles,        ///< White discs on black below the stamp.
+        Noise,          ///< Gray noise, the same for the same frame counter.
+        Gradient        ///< Blue rising left to right, green top to bottom, red falling left to right.
+    };
+
+    /*!
+     * \brief Values embedded in a frame.
+     */
+    struct Stamp {
+        uint64_t frame = 0;         ///< Frame counter.
+        uint64_t timestampUs = 0;   ///< Timestamp in microseconds, e.g. of the steady clock.
+    };
+
+    /*!
+     * \brief Sets the pattern.
+     * \param kind The pattern to render.
+     */
+    void setKind(Kind kind) { kind_ = kind; }
+
+    /*!
+     * \brief Retrieves the pattern.
+     * \return The pattern rendered.
+     */
+    Kind getKind() const { return kind_; }
+
+    /*!
+     * \brief Sets the width of the bars of Kind::MovingEdges.
+     * \param width Bar width in pixels, at least 1.
+     */
+    void setBarWidth(unsigned int width) { barWidth_ = width > 0 ? width : 1; }
+
+    /*!
+     * \brief Sets the speed of the edges of Kind::MovingEdges.
+     * \param pixels Displacement per frame in pixels.
+     */
+    void setEdgeSpeed(unsigned int pixels) { edgeSpeed_ = pixels; }
+
+    /*!
+     * \brief Sets the radius of the discs of Kind::Circles.
+     * \param radius Radius in pixels, at least 1.
+     */
+    void setCircleRadius(unsigned int radius) { circleRadius_ = radius > 0 ? radius : 1; }
+
+    /*!
+     * \brief Renders a frame.
+     * \param bgra Destination buffer of height rows of bytesPerLine bytes.
+     * \param bytesPerLine Bytes per row of the buffer, at least 4 * width.
+     * \param width Frame width in pixels.
+     * \param height Frame height in pixels.
+     * \param stamp Values to embed. The frame counter also drives the motion and the noise.
+     *
+     * The stamp is drawn if the frame is at least `TEST_STAMP_MIN_WIDTH` wide and stampHeight() high.
+     */
+    void render(uint8_t* bgra, size_t bytesPerLine, unsigned int width, unsigned int height, const Stamp& stamp) const;
+
+    /*!
+     * \brief Computes the edge columns of Kind::MovingEdges.
+     * \param width Frame width in pixels.
+     * \param frame Frame counter.
+     * \return Columns x > 0 whose colour differs from column x - 1, in increasing order.
+     */
+    std::vector<unsigned int> edgePositions(unsigned int width, uint64_t frame) const;
+
+    /*!
+     * \brief Computes the centres of the discs of Kind::Circles.
+     * \param width Frame width in pixels.
+     * \param height Frame height in pixels.
+     * \return Centres (x, y) in pixel coordinates, where pixel (i, j) covers [i, i + 1) x [j, j + 1). Each disc holds
+     * the pixels whose centre lies within the radius.
+     */
+    std::vector<std::pair<double, double> > circleCenters(unsigned int width, unsigned int height) const;
+
+    /*!
+     * \brief Computes the height of the stamp.
+     * \param width Frame width in pixels.
+     * \return Rows taken by the stamp at the top of the frame.
+     */
+    static unsigned int stampHeight(unsigned int width);
+
+    /*!
+     * \brief Reads the stamp of a frame.
+     * \param bgra Frame buffer of height rows of bytesPerLine bytes, 32-bit B G R A (any channel order works, the
+     * cells are gray).
+     * \param bytesPerLine Bytes per row of the buffer.
+     * \param width Frame width in pixels.
+     * \param height Frame height in pixels.
+     * \param stamp Receives the embedded values.
+     * \return True if a stamp with a valid checksum was found.
+     */
+    static bool decodeStamp(const uint8_t* bgra, size_t bytesPerLine, unsigned int width, unsigned int height,
+                            Stamp* stamp);
+
+    /*!
+     * \brief Retrieves the name of a pattern.
+     * \param kind The pattern.
+     * \return Human-readable name.
+     */
+    static const char* kindName(Kind kind);
+
+private:
+    Kind kind_ = Kind::MovingEdges;     ///< Pattern to render.
+    unsigned int barWidth_ = 32;        ///< Bar width of Kind::MovingEdges in pixels.
+    unsigned int edgeSpeed_ = 4;        ///< Displacement of the edges per frame in pixels.
+    unsigned int circleRadius_ = 40;    ///< Radius of the discs of Kind::Circles in pixels.
+
+    /*!
+     * \brief Computes the horizontal offset of the bars.
+     * \param frame Frame counter.
+     * \return Offset in [0, 2 * barWidth_).
+     */
+    unsigned int barOffset(uint64_t frame) const;
+};
+
+#endif // TTESTPATTERN_H
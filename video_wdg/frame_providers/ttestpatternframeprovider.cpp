@@ -0,0 +1,95 @@
+#include "ttestpatternframeprovider.h"
+#include <chrono>
+#include <iterator>
+
+TTestPatternFrameProvider::TTestPatternFrameProvider(TTestPattern::Kind kind, QObject *parent)
+    : IFrameProvider{parent}
+{
+    pattern_.setKind(kind);
+}
+
+TTestPatternFrameProvider::~TTestPatternFrameProvider()
+{
+    stop();
+}
+
+QList<std::string> TTestPatternFrameProvider::getDeviceDesc()
+{
+    std::lock_guard<std::mutex> lock(patternmtx_);
+    return QList<std::string> {QString("Test pattern %1: %2").arg(sourceId_)
+                                   .arg(TTestPattern::kindName(pattern_.getKind())).toStdString()};
+}
+
+void TTestPatternFrameProvider::setDeviceByDesc(std::string desc)
+{
+
+}
+
+QList<std::string> TTestPatternFrameProvider::getCurrentDeviceAvaliableFormats()
+{
+    QList<std::string> formats;
+    for (const auto& size : TEST_PATTERN_SIZES) {
+        formats.append(QString("%1,%2").arg(size[0]).arg(size[1]).toStdString());
+    }
+    return formats;
+}
+
+void TTestPatternFrameProvider::setCurrentDeviceFormatByIdx(int idx)
+{
+    if (idx >= 0 && idx < static_cast<int>(std::size(TEST_PATTERN_SIZES))) {
+        sizeIdx_ = idx;
+    }
+}
+
+void TTestPatternFrameProvider::setUrl(std::string url)
+{
+
+}
+
+void TTestPatternFrameProvider::setFrameRate(double fps)
+{
+    frameRate_ = fps;
+    wakeCapture();
+}
+
+void TTestPatternFrameProvider::setPattern(const TTestPattern &pattern)
+{
+    std::lock_guard<std::mutex> lock(patternmtx_);
+    pattern_ = pattern;
+}
+
+bool TTestPatternFrameProvider::decodeStamp(const QImage &image, TTestPattern::Stamp *stamp)
+{
+    if (image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32
+            && image.format() != QImage::Format_ARGB32_Premultiplied) {
+        return false;
+    }
+    return TTestPattern::decodeStamp(image.constBits(), static_cast<size_t>(image.bytesPerLine()),
+                                     static_cast<unsigned int>(image.width()), static_cast<unsigned int>(image.height()),
+                                     stamp);
+}
+
+bool TTestPatternFrameProvider::openSource()
+{
+    restartPacing();
+    return true;
+}
+
+TCaptureStep TTestPatternFrameProvider::captureFrame()
+{
+    const int* size = TEST_PATTERN_SIZES[sizeIdx_];
+    TFramePacketPtr packet = acquirePacket();
+    QImage& image = packet->ensureImage(size[0], size[1], QImage::Format_RGB32);
+    TTestPattern::Stamp stamp;
+    stamp.frame = packet->sequence;
+    stamp.timestampUs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(packet->captureTime.time_since_epoch()).count());
+    {
+        std::lock_guard<std::mutex> lock(patternmtx_);
+        pattern_.render(image.bits(), static_cast<size_t>(image.bytesPerLine()), static_cast<unsigned int>(size[0]),
+                        static_cast<unsigned int>(size[1]), stamp);
+    }
+    publishFrame(std::move(packet));
+
+    return paceNext(frameRate_, true);
+}
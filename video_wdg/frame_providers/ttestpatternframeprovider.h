@@ -0,0 +1,121 @@
+/** @file
+ *
+ * TVideoWdg - SimpleMeasurementByVideoTool
+ * By Ilia.belou <ilia.belou@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef TTESTPATTERNFRAMEPROVIDER_H
+#define TTESTPATTERNFRAMEPROVIDER_H
+
+#include <QObject>
+#include <QDebug>
+#include <mutex>
+
+#include "iframeprovider.h"
+#include "ttestpattern.h"
+
+constexpr double TEST_PATTERN_DEFAULT_FPS = 30.0;   ///< Default frame rate of the test pattern.
+constexpr int TEST_PATTERN_SIZES[][2] = {{640, 480}, {1280, 720}, {1920, 1080}, {3840, 2160}}; ///< Selectable frame sizes.
+
+/*!
+ * \class TTestPatternFrameProvider
+ * \brief Frame provider generating synthetic test frames.
+ *
+ * The `TTestPatternFrameProvider` class implements the `IFrameProvider` interface without any device: it renders a
+ * `TTestPattern` into each pooled packet (`QImage::Format_RGB32`) at a fixed rate or unthrottled, at one of the
+ * `TEST_PATTERN_SIZES`. The stamp of every frame holds the packet sequence number and its capture time in microseconds
+ * of `TFramePacket::Clock`, so decodeStamp() on a frame anywhere downstream gives the exact number of frames lost and
+ * the time since capture.
+ */
+class TTestPatternFrameProvider : public IFrameProvider
+{
+    Q_OBJECT
+public:
+    /*!
+     * \brief Constructs a TTestPatternFrameProvider instance.
+     * \param kind The pattern to render (default is TTestPattern::Kind::MovingEdges).
+     * \param parent The parent QObject (default is nullptr).
+     */
+    explicit TTestPatternFrameProvider(TTestPattern::Kind kind = TTestPattern::Kind::MovingEdges,
+                                       QObject *parent = nullptr);
+
+    /*!
+     * \brief Destructor.
+     *
+     * Stops the provider.
+     */
+    ~TTestPatternFrameProvider();
+
+    /*!
+     * \brief Retrieves the description of the pattern source.
+     * \return A list containing "Test pattern <source id>: <pattern name>".
+     */
+    QList<std::string> getDeviceDesc() override;
+
+    /*!
+     * \brief Sets the active device by description.
+     * \param desc The device description (currently unused).
+     */
+    void setDeviceByDesc(std::string desc) override;
+
+    /*!
+     * \brief Retrieves the selectable frame sizes.
+     * \return A list of `TEST_PATTERN_SIZES` (width,height).
+     */
+    QList<std::string> getCurrentDeviceAvaliableFormats() override;
+
+    /*!
+     * \brief Sets the frame size by index.
+     * \param idx The index in `TEST_PATTERN_SIZES`; takes effect on the next frame.
+     */
+    void setCurrentDeviceFormatByIdx(int idx) override;
+
+    /*!
+     * \brief Sets the URL for streaming sources.
+     * \param url Unused, the pattern has no URL.
+     */
+    void setUrl(std::string url) override;
+
+    /*!
+     * \brief Sets the frame rate.
+     * \param fps Frames per second, 0 to render as fast as possible.
+     */
+    void setFrameRate(double fps);
+
+    /*!
+     * \brief Sets the pattern.
+     * \param pattern The pattern and its geometry; takes effect on the next frame.
+     */
+    void setPattern(const TTestPattern& pattern);
+
+    /*!
+     * \brief Reads the stamp of a test frame.
+     * \param image The frame, `Format_RGB32`, `Format_ARGB32` or `Format_ARGB32_Premultiplied`, possibly downscaled.
+     * \param stamp Receives the sequence number of the frame and its capture time in microseconds.
+     * \return True if a valid stamp was found.
+     */
+    static bool decodeStamp(const QImage& image, TTestPattern::Stamp* stamp);
+
+protected:
+    /*!
+     * \brief Starts the frame clock.
+     * \return Always true.
+     */
+    bool openSource() override;
+
+    /*!
+     * \brief Renders and publishes one frame.
+     * \return The deadline of the next frame, or now when unthrottled.
+     */
+    TCaptureStep captureFrame() override;
+
+private:
+    std::mutex patternmtx_;                             ///< Mutex protecting pattern_.
+    TTestPattern pattern_;                              ///< Pattern to render.
+    std::atomic<double> frameRate_{TEST_PATTERN_DEFAULT_FPS}; ///< Frame rate, 0 for unthrottled.
+    std::atomic<int> sizeIdx_{1};                       ///< Index of the frame size in TEST_PATTERN_SIZES.
+};
+
+#endif // TTESTPATTERNFRAMEPROVIDER_H
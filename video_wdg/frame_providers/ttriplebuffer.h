@@ -0,0 +1,107 @@
+/** @file
+ *
+ * TVideoWdg - SimpleMeasurementByVideoTool
+ * By Ilia.belou <ilia.belou@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef TTRIPLEBUFFER_H
+#define TTRIPLEBUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/*!
+ * \class TTripleBuffer
+ * \brief Lock-free single-producer/single-consumer triple buffer.
+ *
+ * The `TTripleBuffer` class hands the latest value from one producer thread to one consumer thread without locks.
+ * It owns three slots: the producer writes into the back slot, the consumer reads from the front slot, and the middle
+ * slot holds the most recently published value. Publishing and consuming atomically swap a private slot with the
+ * middle one, so neither side ever blocks and the consumer always sees a complete value. The slots are reused for the
+ * whole lifetime of the buffer; a value published while the previous one is still unconsumed replaces it.
+ *
+ * \tparam T The slot type. Must be default constructible.
+ */
+template<typename T>
+class TTripleBuffer
+{
+public:
+    /*!
+     * \brief Constructs a TTripleBuffer with default constructed slots.
+     */
+    TTripleBuffer() = default;
+
+    TTripleBuffer(const TTripleBuffer&) = delete;
+    TTripleBuffer& operator=(const TTripleBuffer&) = delete;
+
+    /*!
+     * \brief Retrieves the slot owned by the producer.
+     * \return Reference to the back slot. Must only be used by the producer thread.
+     */
+    T& back() {
+        return slots_[back_];
+    }
+
+    /*!
+     * \brief Publishes the back slot to the consumer.
+     * \return True if the previously published value was never consumed and has been dropped.
+     *
+     * After publishing the producer owns a different slot, which holds an older value that can be overwritten.
+     */
+    bool publish() {
+        uint8_t prev = middle_.exchange(back_ | DIRTY_BIT, std::memory_order_acq_rel);
+        back_ = prev & INDEX_MASK;
+        return (prev & DIRTY_BIT) != 0;
+    }
+
+    /*!
+     * \brief Checks if a published value is waiting to be consumed.
+     * \return True if the consumer would get a new value from consume().
+     */
+    bool hasNew() const {
+        return (middle_.load(std::memory_order_acquire) & DIRTY_BIT) != 0;
+    }
+
+    /*!
+     * \brief Takes the latest published value into the front slot.
+     * \return True if a new value was taken, false if the front slot still holds the last consumed value.
+     */
+    bool consume() {
+        if (!hasNew()) {
+            return false;
+        }
+        uint8_t prev = middle_.exchange(front_, std::memory_order_acq_rel);
+        front_ = prev & INDEX_MASK;
+        return true;
+    }
+
+    /*!
+     * \brief Retrieves the slot owned by the consumer.
+     * \return Reference to the front slot. Must only be used by the consumer thread.
+     */
+    T& front() {
+        return slots_[front_];
+    }
+
+    /*!
+     * \brief Retrieves the slot owned by the consumer.
+     * \return Const reference to the front slot. Must only be used by the consumer thread.
+     */
+    const T& front() const {
+        return slots_[front_];
+    }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;  ///< Bits holding the slot index in middle_.
+    static constexpr uint8_t DIRTY_BIT = 0x4;   ///< Bit set in middle_ when it holds an unconsumed value.
+
+    std::array<T, 3> slots_{};                  ///< Storage for the three slots.
+    uint8_t back_ = 0;                          ///< Index of the slot owned by the producer.
+    std::atomic<uint8_t> middle_{1};            ///< Index of the shared slot and the dirty flag.
+    uint8_t front_ = 2;                         ///< Index of the slot owned by the consumer.
+};
+
+#endif // TTRIPLEBUFFER_H
@@ -97,7 +97,8 @@ void TVideoDeviceFrameProvider::run()
 
 void TVideoDeviceFrameProvider::updateFrame(const QVideoFrame &frame)
 {
-    std::lock_guard<std::mutex> lock(framemtx_);
-    frame_ = frame.toImage();
-    frameReady_ = true;
+    // QVideoFrame is implicitly shared, conversion is left to the consumer.
+    TFramePacketPtr packet = acquirePacket();
+    packet->videoFrame = frame;
+    publishFrame(std::move(packet));
 }
@@ -26,7 +26,8 @@
  *
  * The `TVideoDeviceFrameProvider` class implements the `IFrameProvider` interface to capture video frames from USB
  * cameras using Qt's `QCamera` and `QMediaCaptureSession`. It supports selecting devices, configuring video formats,
- * and processing frames asynchronously via a `QVideoSink`. Frames are provided as `QImage` objects with thread-safe access.
+ * and processing frames asynchronously via a `QVideoSink`. The latest `QVideoFrame` is kept as is and converted to a
+ * `QImage` only when the consumer retrieves it, so frames dropped between two retrievals cost no conversion.
  */
 class TVideoDeviceFrameProvider : public IFrameProvider
 {
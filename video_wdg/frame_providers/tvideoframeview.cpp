@@ -0,0 +1,182 @@
+#include "tvideoframeview.h"
+#include <opencv2/imgproc.hpp>
+
+TVideoFrameView::TVideoFrameView(const QVideoFrame &frame) :
+    frame_(frame)
+{
+    if (frame_.isValid()) {
+        mapped_ = frame_.map(QVideoFrame::ReadOnly);
+    }
+}
+
+TVideoFrameView::~TVideoFrameView()
+{
+    if (mapped_) {
+        frame_.unmap();
+    }
+}
+
+bool TVideoFrameView::isMapped() const
+{
+    return mapped_;
+}
+
+cv::Mat TVideoFrameView::luma()
+{
+    if (!mapped_) {
+        return cv::Mat();
+    }
+
+    QtOcv::YuvImage yuv;
+    if (yuvImage(&yuv)) {
+        cv::Mat y = QtOcv::yuv2Gray_shared(yuv);
+        if (y.empty() && QtOcv::yuv2Mat(yuv, lumaScratch_, CV_8UC1)) {
+            // Packed formats have no Y plane.
+            return lumaScratch_;
+        }
+        return y;
+    }
+
+    const int width = frame_.width();
+    const int height = frame_.height();
+    void* bits = const_cast<uchar*>(frame_.bits(0));
+    const size_t step = static_cast<size_t>(frame_.bytesPerLine(0));
+
+    switch (frame_.pixelFormat()) {
+    case QVideoFrameFormat::Format_YUV422P:
+    case QVideoFrameFormat::Format_Y8:
+        return cv::Mat(height, width, CV_8UC1, bits, step);
+    case QVideoFrameFormat::Format_BGRA8888:
+    case QVideoFrameFormat::Format_BGRX8888:
+        cv::cvtColor(cv::Mat(height, width, CV_8UC4, bits, step), lumaScratch_, cv::COLOR_BGRA2GRAY);
+        return lumaScratch_;
+    case QVideoFrameFormat::Format_RGBA8888:
+    case QVideoFrameFormat::Format_RGBX8888:
+        cv::cvtColor(cv::Mat(height, width, CV_8UC4, bits, step), lumaScratch_, cv::COLOR_RGBA2GRAY);
+        return lumaScratch_;
+    default:
+        return cv::Mat();
+    }
+}
+
+bool TVideoFrameView::canConvertToColor() const
+{
+    QtOcv::YuvImage yuv;
+    if (yuvImage(&yuv)) {
+        return hasBt601VideoRange();
+    }
+    if (!mapped_) {
+        return false;
+    }
+    switch (frame_.pixelFormat()) {
+    case QVideoFrameFormat::Format_BGRA8888:
+    case QVideoFrameFormat::Format_BGRX8888:
+    case QVideoFrameFormat::Format_RGBA8888:
+    case QVideoFrameFormat::Format_RGBX8888:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool TVideoFrameView::convertToColor(cv::Mat &dst, QtOcv::MatColorOrder order)
+{
+    QtOcv::YuvImage yuv;
+    if (yuvImage(&yuv)) {
+        return hasBt601VideoRange() && QtOcv::yuv2Mat(yuv, dst, CV_8UC4, order);
+    }
+    if (!mapped_ || order == QtOcv::MCO_ARGB) {
+        return false;
+    }
+
+    bool bgr = false;
+    bool opaque = false;
+    switch (frame_.pixelFormat()) {
+    case QVideoFrameFormat::Format_BGRX8888:
+        opaque = true;
+        Q_FALLTHROUGH();
+    case QVideoFrameFormat::Format_BGRA8888:
+        bgr = true;
+        break;
+    case QVideoFrameFormat::Format_RGBX8888:
+        opaque = true;
+        break;
+    case QVideoFrameFormat::Format_RGBA8888:
+        break;
+    default:
+        return false;
+    }
+    const cv::Mat src(frame_.height(), frame_.width(), CV_8UC4, const_cast<uchar*>(frame_.bits(0)),
+                      static_cast<size_t>(frame_.bytesPerLine(0)));
+    // The X byte is undefined: force an opaque alpha, in the same pass as the copy where possible.
+    const cv::Scalar alpha(0, 0, 0, 255);
+    if (bgr == (order == QtOcv::MCO_BGRA)) {
+        if (opaque) {
+            cv::bitwise_or(src, alpha, dst);
+        } else {
+            src.copyTo(dst);
+        }
+    } else {
+        cv::cvtColor(src, dst, cv::COLOR_BGRA2RGBA);
+        if (opaque) {
+            cv::bitwise_or(dst, alpha, dst);
+        }
+    }
+    return true;
+}
+
+bool TVideoFrameView::hasBt601VideoRange() const
+{
+    const QVideoFrameFormat format = frame_.surfaceFormat();
+    const QVideoFrameFormat::ColorSpace space = format.colorSpace();
+    return (space == QVideoFrameFormat::ColorSpace_Undefined || space == QVideoFrameFormat::ColorSpace_BT601)
+        && format.colorRange() != QVideoFrameFormat::ColorRange_Full;
+}
+
+bool TVideoFrameView::yuvImage(QtOcv::YuvImage *yuv) const
+{
+    if (!mapped_) {
+        return false;
+    }
+
+    int planeCount = 0;
+    switch (frame_.pixelFormat()) {
+    case QVideoFrameFormat::Format_NV12:
+        yuv->format = QtOcv::YUV_NV12;
+        planeCount = 2;
+        break;
+    case QVideoFrameFormat::Format_NV21:
+        yuv->format = QtOcv::YUV_NV21;
+        planeCount = 2;
+        break;
+    case QVideoFrameFormat::Format_YUV420P:
+        yuv->format = QtOcv::YUV_I420;
+        planeCount = 3;
+        break;
+    case QVideoFrameFormat::Format_YV12:
+        yuv->format = QtOcv::YUV_YV12;
+        planeCount = 3;
+        break;
+    case QVideoFrameFormat::Format_YUYV:
+        yuv->format = QtOcv::YUV_YUYV;
+        planeCount = 1;
+        break;
+    case QVideoFrameFormat::Format_UYVY:
+        yuv->format = QtOcv::YUV_UYVY;
+        planeCount = 1;
+        break;
+    default:
+        return false;
+    }
+    if (frame_.planeCount() < planeCount) {
+        return false;
+    }
+
+    yuv->width = frame_.width();
+    yuv->height = frame_.height();
+    for (int i = 0; i < 3; ++i) {
+        yuv->planes[i] = i < planeCount ? frame_.bits(i) : nullptr;
+        yuv->steps[i] = i < planeCount ? static_cast<size_t>(frame_.bytesPerLine(i)) : 0;
+    }
+    return true;
+}
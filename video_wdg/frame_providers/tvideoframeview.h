@@ -0,0 +1,104 @@
+/** @file
+ *
+ * TVideoWdg - SimpleMeasurementByVideoTool
+ * By Ilia.belou <ilia.belou@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef TVIDEOFRAMEVIEW_H
+#define TVIDEOFRAMEVIEW_H
+
+#include <QVideoFrame>
+#include <opencv2/core.hpp>
+
+#include "video_wdg/cv_to_qt_image/cvmatandqimage.h"
+
+/*!
+ * \class TVideoFrameView
+ * \brief Read-only view of the planes of a QVideoFrame as OpenCV matrices.
+ *
+ * The `TVideoFrameView` class maps a `QVideoFrame` for reading for its whole lifetime and exposes its planes as
+ * `cv::Mat` headers over the mapped memory, without colour conversion. For planar and semi-planar YUV formats
+ * (NV12, NV21, YUV420P, YV12, YUV422P, Y8) the luma plane is returned without any copy; packed YUV formats (YUYV, UYVY)
+ * and 32-bit RGB formats produce the luma in a scratch matrix owned by the view. Formats that need decoding (e.g. MJPEG)
+ * or have more than 8 bits per sample are not supported and yield empty matrices, so callers can fall back to
+ * `QVideoFrame::toImage()`. Matrices returned by the view must not be used after the view is destroyed.
+ *
+ * YUV frames (NV12, NV21, YUV420P, YV12, YUYV, UYVY) can also be converted to colour in a single pass straight from
+ * their planes, see `QtOcv::yuv2Mat()`, which avoids the generic converter of `QVideoFrame::toImage()`. That conversion
+ * uses the BT.601 limited range matrix of OpenCV, so it is only offered for frames whose surface format declares that
+ * colour space and range or leaves them undefined; `toImage()` follows the declared ones, e.g. BT.709 or full range.
+ */
+class TVideoFrameView
+{
+public:
+    /*!
+     * \brief Constructs a view and maps the frame for reading.
+     * \param frame The video frame to map.
+     */
+    explicit TVideoFrameView(const QVideoFrame& frame);
+
+    /*!
+     * \brief Destructor.
+     *
+     * Unmaps the frame.
+     */
+    ~TVideoFrameView();
+
+    TVideoFrameView(const TVideoFrameView&) = delete;
+    TVideoFrameView& operator=(const TVideoFrameView&) = delete;
+
+    /*!
+     * \brief Checks if the frame was mapped successfully.
+     * \return True if the frame planes are accessible.
+     */
+    bool isMapped() const;
+
+    /*!
+     * \brief Retrieves the luma (Y) of the frame as a single-channel 8-bit matrix.
+     * \return The luma matrix, or an empty matrix if the pixel format is not supported.
+     *
+     * Aliases the mapped Y plane for planar and semi-planar formats; otherwise the luma is extracted into a scratch
+     * matrix owned by the view.
+     */
+    cv::Mat luma();
+
+    /*!
+     * \brief Checks if the frame can be converted by convertToColor().
+     * \return True if the frame is mapped and its pixel format is BT.601 limited range YUV or 32-bit RGB.
+     */
+    bool canConvertToColor() const;
+
+    /*!
+     * \brief Converts the frame to 4-channel 8-bit colour.
+     * \param dst Destination matrix. Written in place if it already is a `CV_8UC4` matrix of the frame size, e.g. a
+     * view over the bits of a `QImage::Format_RGB32` image.
+     * \param order Channel order of the result. 32-bit RGB frames support `QtOcv::MCO_BGRA` and `QtOcv::MCO_RGBA`.
+     * \return True on success, false if the frame cannot be converted (see canConvertToColor()).
+     *
+     * The alpha of the result is 0xFF for YUV and for RGB formats without alpha (BGRX, RGBX), whose fourth byte is
+     * undefined, so the result can back a `QImage::Format_RGB32` image.
+     */
+    bool convertToColor(cv::Mat& dst, QtOcv::MatColorOrder order = QtOcv::MCO_BGRA);
+
+private:
+    QVideoFrame frame_;     ///< Mapped video frame (shallow copy of the source frame).
+    bool mapped_ = false;   ///< Flag indicating if the frame is mapped.
+    cv::Mat lumaScratch_;   ///< Luma extracted from packed formats.
+
+    /*!
+     * \brief Describes the mapped planes of a YUV frame.
+     * \param yuv Receives the format, size and planes of the frame.
+     * \return True if the frame is mapped and has a pixel format supported by `QtOcv::YuvImage`.
+     */
+    bool yuvImage(QtOcv::YuvImage* yuv) const;
+
+    /*!
+     * \brief Checks if the YUV matrix of the frame is the one `QtOcv::yuv2Mat()` converts with.
+     * \return True if the surface format declares BT.601 or no colour space, and limited or unknown range.
+     */
+    bool hasBt601VideoRange() const;
+};
+
+#endif // TVIDEOFRAMEVIEW_H
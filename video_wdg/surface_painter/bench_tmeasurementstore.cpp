@@ -0,0 +1,126 @@
+#include <benchmark/benchmark.h>
+#include <QGuiApplication>
+#include <vector>
+#include "tmeasurementlayer.h"
+#include "tmeasurementstore.h"
+
+namespace {
+// Измерения на сетке 100 x N с шагом 40 пикселей: через одно линия и окружность
+TMeasurement makeMeasurement(int i) {
+    const QPointF p((i % 100) * 40.0, (i / 100) * 40.0);
+    TMeasurement m;
+    if (i % 2) {
+        m.type = TMeasurement::Type::Line;
+        m.p1 = p;
+        m.p2 = p + QPointF(30, 10);
+    } else {
+        m.type = TMeasurement::Type::Circle;
+        m.p1 = p + QPointF(15, 15);
+        m.p2 = m.p1 + QPointF(10, 0);
+    }
+    return m;
+}
+
+// Хранилище с count измерениями
+void fillStore(TMeasurementStore& store, int count) {
+    for (int i = 0; i < count; ++i) {
+        const TMeasurement m = makeMeasurement(i);
+        store.add(m, TMeasurementStore::shapeRect(m).adjusted(-2, -2, 2, 2));
+    }
+}
+
+// Добавление count измерений в пустое хранилище
+void BM_Add(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        TMeasurementStore store;
+        fillStore(store, count);
+        benchmark::DoNotOptimize(store.size());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_Add)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+// Выборка прямоугольника 10 x 10 ячеек сетки
+void BM_Query(benchmark::State& state) {
+    TMeasurementStore store;
+    fillStore(store, static_cast<int>(state.range(0)));
+    std::vector<int> found;
+    for (auto _ : state) {
+        found.clear();
+        store.query(QRectF(0, 0, 395, 395), found);
+        benchmark::DoNotOptimize(found.data());
+    }
+}
+BENCHMARK(BM_Query)->Arg(1000)->Arg(10000);
+
+// Поиск измерения под курсором
+void BM_HitTest(benchmark::State& state) {
+    TMeasurementStore store;
+    fillStore(store, static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(store.hitTest(QPointF(40 * 51 + 15, 40 * 7)));
+    }
+}
+BENCHMARK(BM_HitTest)->Arg(1000)->Arg(10000);
+
+// Очистка заполненного хранилища, заполнение не входит в замер
+void BM_Clear(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        TMeasurementStore store;
+        fillStore(store, count);
+        state.ResumeTiming();
+        store.clear();
+        benchmark::DoNotOptimize(store.size());
+    }
+}
+BENCHMARK(BM_Clear)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+// Смена калибровки слоя, как при перетаскивании спинбокса: значения в пределах зарезервированной ширины подписи
+void BM_LayerSetCalibration(benchmark::State& state) {
+    TMeasurementStore store;
+    TMeasurementLayer layer(&store);
+    for (int i = 0; i < state.range(0); ++i) {
+        layer.addMeasurement(makeMeasurement(i));
+    }
+    double mmInPixel = 0.1;
+    for (auto _ : state) {
+        mmInPixel = mmInPixel == 0.1 ? 0.2 : 0.1;
+        layer.setCalibration(mmInPixel, mmInPixel);
+    }
+}
+BENCHMARK(BM_LayerSetCalibration)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+// Смена калибровки, при которой значения превышают зарезервированную ширину подписи: пересчет всех областей
+void BM_LayerSetCalibrationRelayout(benchmark::State& state) {
+    TMeasurementStore store;
+    TMeasurementLayer layer(&store);
+    for (int i = 0; i < state.range(0); ++i) {
+        layer.addMeasurement(makeMeasurement(i));
+    }
+    double mmInPixel = 10000.0;
+    for (auto _ : state) {
+        mmInPixel = mmInPixel == 10000.0 ? 20000.0 : 10000.0;
+        layer.setCalibration(mmInPixel, mmInPixel);
+    }
+}
+BENCHMARK(BM_LayerSetCalibrationRelayout)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+}
+
+int main(int argc, char** argv)
+{
+    // Метрикам шрифта подписей нужно приложение; окна не создаются
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
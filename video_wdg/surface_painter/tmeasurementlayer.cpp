@@ -0,0 +1,159 @@
+#include "tmeasurementlayer.h"
+#include "tsurfacepainter.h"
+
+#include <QStyleOptionGraphicsItem>
+#include <algorithm>
+
+TMeasurementLayer::TMeasurementLayer(TMeasurementStore *store, QGraphicsItem *parent) :
+    QGraphicsItem(parent),
+    store_(store)
+{
+    setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+int TMeasurementLayer::addMeasurement(const TMeasurement &measurement)
+{
+    const QRectF area = measurementRect(measurement);
+    if (!store_->bounds().contains(area)) {
+        prepareGeometryChange();
+    }
+    const int index = store_->add(measurement, area);
+    update(area);
+    return index;
+}
+
+void TMeasurementLayer::clear()
+{
+    prepareGeometryChange();
+    store_->clear();
+}
+
+void TMeasurementLayer::setCalibration(double mmInPixelsWidth, double mmInPixelsHeight)
+{
+    if (mmInPixelsWidth == mmInPixelsWidth_ && mmInPixelsHeight == mmInPixelsHeight_) {
+        return;
+    }
+    // Areas are sized for LABEL_RESERVED_MM: they only change for a value that reaches it before or after.
+    bool relayout = false;
+    for (int i = 0; i < store_->size() && !relayout; ++i) {
+        const TMeasurement& m = store_->at(i);
+        relayout = m.valueMm(mmInPixelsWidth_, mmInPixelsHeight_) >= LABEL_RESERVED_MM
+                   || m.valueMm(mmInPixelsWidth, mmInPixelsHeight) >= LABEL_RESERVED_MM;
+    }
+    mmInPixelsWidth_ = mmInPixelsWidth;
+    mmInPixelsHeight_ = mmInPixelsHeight;
+    if (store_->size() == 0) {
+        return;
+    }
+    if (!relayout) {
+        update();
+        return;
+    }
+    areas_.resize(store_->size());
+    for (int i = 0; i < store_->size(); ++i) {
+        areas_[i] = measurementRect(store_->at(i));
+    }
+    prepareGeometryChange();
+    store_->updateAreas(areas_);
+    update();
+}
+
+void TMeasurementLayer::updateMeasurement(int index)
+{
+    update(store_->areaAt(index));
+}
+
+QRectF TMeasurementLayer::boundingRect() const
+{
+    return store_->bounds();
+}
+
+void TMeasurementLayer::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+    store_->query(option->exposedRect, visible_);
+    painter->setBrush(Qt::NoBrush);
+    int fontSize = -1;
+    qreal ascent = 0;
+    for (int index : visible_) {
+        const TMeasurement& m = store_->at(index);
+        const QColor color = m.selected ? QColor(SELECTED_MEASUREMENT_COLOR)
+                                        : QColor(m.type == TMeasurement::Type::Line ? Qt::red : Qt::blue);
+        painter->setPen(QPen(color, m.lineWidth));
+        switch (m.type) {
+        case TMeasurement::Type::Line:
+            painter->drawLine(m.p1, m.p2);
+            break;
+        case TMeasurement::Type::Circle:
+        {
+            const qreal radius = m.valuePx();
+            painter->drawEllipse(m.p1, radius, radius);
+        }
+        break;
+        }
+        if (m.fontSize != fontSize) {
+            fontSize = m.fontSize;
+            painter->setFont(QFont("Arial", fontSize));
+            ascent = painter->fontMetrics().ascent();
+        }
+        painter->drawText(labelAnchor(m) + QPointF(TEXT_DOCUMENT_MARGIN, TEXT_DOCUMENT_MARGIN + ascent), labelText(m));
+    }
+}
+
+QString TMeasurementLayer::labelText(const TMeasurement &measurement) const
+{
+    return formatLabel(measurement, measurement.valueMm(mmInPixelsWidth_, mmInPixelsHeight_));
+}
+
+QPointF TMeasurementLayer::labelAnchor(const TMeasurement &measurement)
+{
+    QPointF anchor;
+    switch (measurement.type) {
+    case TMeasurement::Type::Line:
+        anchor = QPointF(qMax(measurement.p1.x(), measurement.p2.x()) + TEXT_DISPLAY_OFFSET_HOR_INPX,
+                         qMin(measurement.p1.y(), measurement.p2.y()) - TEXT_DISPLAY_OFFSET_VERT_INPX);
+        break;
+    case TMeasurement::Type::Circle:
+    {
+        const qreal radius = measurement.valuePx();
+        anchor = QPointF(measurement.p1.x() + radius + TEXT_DISPLAY_OFFSET_HOR_INPX,
+                         measurement.p1.y() - radius - TEXT_DISPLAY_OFFSET_VERT_INPX);
+    }
+    break;
+    }
+    return anchor;
+}
+
+QRectF TMeasurementLayer::labelRect(const TMeasurement &measurement)
+{
+    const QPointF anchor = labelAnchor(measurement);
+    const double valueMm = measurement.valueMm(mmInPixelsWidth_, mmInPixelsHeight_);
+    // Digits are equally wide, so the reserved value is as wide as any smaller one.
+    const QSizeF textSize = fontMetrics(measurement.fontSize)
+        .size(0, formatLabel(measurement, std::max(valueMm, LABEL_RESERVED_MM)));
+    return QRectF(anchor, textSize).adjusted(0, 0, 2 * TEXT_DOCUMENT_MARGIN, 2 * TEXT_DOCUMENT_MARGIN);
+}
+
+QRectF TMeasurementLayer::measurementRect(const TMeasurement &measurement)
+{
+    const qreal halfPen = measurement.lineWidth / 2.0 + 1;
+    return TMeasurementStore::shapeRect(measurement).adjusted(-halfPen, -halfPen, halfPen, halfPen)
+        .united(labelRect(measurement));
+}
+
+QString TMeasurementLayer::formatLabel(const TMeasurement &measurement, double valueMm)
+{
+    return QString(measurement.type == TMeasurement::Type::Line ? "L: %1 px, %2 mm" : "R: %1 px, %2 mm")
+        .arg(measurement.valuePx(), 0, 'f', PX_DISPLAY_PRESICION)
+        .arg(valueMm, 0, 'f', UNITS_MES_DISPLAY_PRESICION);
+}
+
+const QFontMetricsF &TMeasurementLayer::fontMetrics(int fontSize)
+{
+    auto it = metrics_.find(fontSize);
+    if (it == metrics_.end()) {
+        it = metrics_.emplace(fontSize, QFontMetricsF(QFont("Arial", fontSize))).first;
+    }
+    return it->second;
+}
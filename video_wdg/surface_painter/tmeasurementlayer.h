@@ -0,0 +1,144 @@
+/** @file
+ *
+ * TVideoWdg - SimpleMeasurementByVideoTool
+ * By Ilia.belou <ilia.belou@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef TMEASUREMENTLAYER_H
+#define TMEASUREMENTLAYER_H
+
+#include <QColor>
+#include <QFont>
+#include <QFontMetricsF>
+#include <QGraphicsItem>
+#include <QPainter>
+#include <QString>
+#include <map>
+#include <vector>
+
+#include "tmeasurementstore.h"
+
+constexpr qreal TEXT_DOCUMENT_MARGIN = 4.0;                     ///< Margin around measurement labels, as used by QGraphicsTextItem.
+constexpr Qt::GlobalColor SELECTED_MEASUREMENT_COLOR = Qt::yellow; ///< Color of selected measurements.
+constexpr double LABEL_RESERVED_MM = 99999.0;                   ///< Largest millimeter value annotation areas are sized for.
+
+/*!
+ * \class TMeasurementLayer
+ * \brief Graphics item drawing all finished measurements as one cached layer.
+ *
+ * The `TMeasurementLayer` class replaces a graphics item per shape and per label with a single item that paints the
+ * measurements of a `TMeasurementStore`. The item uses `QGraphicsItem::DeviceCoordinateCache`, so the layer is rendered
+ * into a pixmap only when the measurements or the view zoom change; repainting a new video frame underneath composites
+ * the cached pixmap in one blit instead of redrawing every shape and text. When the cache is rebuilt, the spatial
+ * index of the store limits drawing to the measurements in the exposed area.
+ *
+ * Annotations are built at paint time from the pixel geometry and the current calibration. The annotation area of a
+ * measurement is sized for a millimeter value as wide as `LABEL_RESERVED_MM` rather than for the actual value, so it
+ * does not depend on the calibration: a calibration change only invalidates the cache, without formatting or laying
+ * out a single label. Only when a value reaches `LABEL_RESERVED_MM` under the old or the new calibration are the areas
+ * of all measurements recomputed in one pass. No graphics item is created or destroyed.
+ */
+class TMeasurementLayer : public QGraphicsItem
+{
+public:
+    /*!
+     * \brief Constructs a TMeasurementLayer instance.
+     * \param store The measurements to draw (not owned). Must be modified through the layer.
+     * \param parent The parent item (default is nullptr).
+     */
+    explicit TMeasurementLayer(TMeasurementStore* store, QGraphicsItem* parent = nullptr);
+
+    /*!
+     * \brief Adds a measurement to the store and draws it.
+     * \param measurement The measurement.
+     * \return Index of the measurement in the store.
+     */
+    int addMeasurement(const TMeasurement& measurement);
+
+    /*!
+     * \brief Removes all measurements.
+     */
+    void clear();
+
+    /*!
+     * \brief Sets the calibration used for the annotations and repaints all measurements.
+     * \param mmInPixelsWidth Millimeters per pixel along x.
+     * \param mmInPixelsHeight Millimeters per pixel along y.
+     */
+    void setCalibration(double mmInPixelsWidth, double mmInPixelsHeight);
+
+    /*!
+     * \brief Redraws a measurement after its selection state changed.
+     * \param index Index of the measurement in the store.
+     */
+    void updateMeasurement(int index);
+
+    /*!
+     * \brief Retrieves the bounding rectangle of the layer.
+     * \return Union of the areas of all measurements in item coordinates.
+     */
+    QRectF boundingRect() const override;
+
+    /*!
+     * \brief Paints the measurements intersecting the exposed area.
+     * \param painter The painter.
+     * \param option The style options holding the exposed rectangle.
+     * \param widget The widget being painted on (unused).
+     */
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget = nullptr) override;
+
+    /*!
+     * \brief Builds the annotation of a measurement.
+     * \param measurement The measurement.
+     * \return The annotation text.
+     */
+    QString labelText(const TMeasurement& measurement) const;
+
+    /*!
+     * \brief Computes the top left corner of the annotation of a measurement.
+     * \param measurement The measurement.
+     * \return The corner in item coordinates.
+     */
+    static QPointF labelAnchor(const TMeasurement& measurement);
+
+    /*!
+     * \brief Computes the rectangle of the annotation of a measurement.
+     * \param measurement The measurement.
+     * \return The annotation rectangle in item coordinates.
+     */
+    QRectF labelRect(const TMeasurement& measurement);
+
+    /*!
+     * \brief Computes the area covered by a measurement.
+     * \param measurement The measurement.
+     * \return The rectangle covering the shape and its annotation.
+     */
+    QRectF measurementRect(const TMeasurement& measurement);
+
+private:
+    TMeasurementStore* store_;                  ///< Measurements to draw.
+    std::vector<int> visible_;                  ///< Scratch list of the measurements in the exposed area.
+    std::vector<QRectF> areas_;                 ///< Scratch list of recomputed areas.
+    std::map<int, QFontMetricsF> metrics_;      ///< Annotation font metrics by font size.
+    double mmInPixelsWidth_ = 0.001;            ///< Millimeters per pixel along x.
+    double mmInPixelsHeight_ = 0.001;           ///< Millimeters per pixel along y.
+
+    /*!
+     * \brief Formats the annotation of a measurement.
+     * \param measurement The measurement.
+     * \param valueMm The millimeter value to show.
+     * \return The annotation text.
+     */
+    static QString formatLabel(const TMeasurement& measurement, double valueMm);
+
+    /*!
+     * \brief Retrieves the annotation font metrics for a font size.
+     * \param fontSize The font size.
+     * \return The cached metrics.
+     */
+    const QFontMetricsF& fontMetrics(int fontSize);
+};
+
+#endif // TMEASUREMENTLAYER_H
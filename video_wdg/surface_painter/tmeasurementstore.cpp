@@ -0,0 +1,161 @@
+#include "tmeasurementstore.h"
+
+#include <algorithm>
+#include <cmath>
+
+template<typename Fn>
+void TMeasurementStore::forEachCell(const QRectF &rect, const Fn &fn)
+{
+    const int x0 = static_cast<int>(std::floor(rect.left() / MEASUREMENT_GRID_CELL));
+    const int x1 = static_cast<int>(std::floor(rect.right() / MEASUREMENT_GRID_CELL));
+    const int y0 = static_cast<int>(std::floor(rect.top() / MEASUREMENT_GRID_CELL));
+    const int y1 = static_cast<int>(std::floor(rect.bottom() / MEASUREMENT_GRID_CELL));
+    for (int cy = y0; cy <= y1; ++cy) {
+        for (int cx = x0; cx <= x1; ++cx) {
+            fn(cx, cy);
+        }
+    }
+}
+
+int TMeasurementStore::add(const TMeasurement &measurement, const QRectF &area)
+{
+    const int index = size();
+    items_.push_back(measurement);
+    areas_.push_back(area);
+    marks_.push_back(0);
+    bounds_ = bounds_.isNull() ? area : bounds_.united(area);
+    indexArea(index);
+    return index;
+}
+
+void TMeasurementStore::updateAreas(const std::vector<QRectF> &areas)
+{
+    areas_ = areas;
+    bounds_ = QRectF();
+    ++generation_;
+    for (int i = 0; i < size(); ++i) {
+        bounds_ = bounds_.isNull() ? areas_[i] : bounds_.united(areas_[i]);
+        indexArea(i);
+    }
+}
+
+void TMeasurementStore::clear()
+{
+    // Trivially destructible elements: clearing does not touch them.
+    items_.clear();
+    areas_.clear();
+    marks_.clear();
+    bounds_ = QRectF();
+    ++generation_;
+}
+
+void TMeasurementStore::query(const QRectF &rect, std::vector<int> &out) const
+{
+    out.clear();
+    if (items_.empty() || !rect.intersects(bounds_)) {
+        return;
+    }
+    if (++queryStamp_ == 0) {
+        std::fill(marks_.begin(), marks_.end(), 0);
+        queryStamp_ = 1;
+    }
+    forEachCell(rect.intersected(bounds_), [this, &rect, &out](int cx, int cy) {
+        auto it = cells_.find(cellKey(cx, cy));
+        if (it == cells_.end() || it->second.generation != generation_) {
+            return;
+        }
+        for (int index : it->second.items) {
+            if (marks_[index] != queryStamp_ && areas_[index].intersects(rect)) {
+                marks_[index] = queryStamp_;
+                out.push_back(index);
+            }
+        }
+    });
+    std::sort(out.begin(), out.end());
+}
+
+int TMeasurementStore::hitTest(const QPointF &point, qreal tolerance) const
+{
+    std::vector<int> candidates;
+    query(QRectF(point.x() - tolerance, point.y() - tolerance, 2 * tolerance, 2 * tolerance), candidates);
+    for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+        const TMeasurement& m = items_[*it];
+        const qreal reach = tolerance + m.lineWidth / 2.0;
+        qreal distance = 0;
+        switch (m.type) {
+        case TMeasurement::Type::Line:
+        {
+            const QPointF d = m.p2 - m.p1;
+            const qreal lengthSq = QPointF::dotProduct(d, d);
+            const qreal t = lengthSq > 0 ? std::clamp(QPointF::dotProduct(point - m.p1, d) / lengthSq, 0.0, 1.0) : 0.0;
+            distance = QLineF(point, m.p1 + t * d).length();
+        }
+        break;
+        case TMeasurement::Type::Circle:
+            distance = std::abs(QLineF(point, m.p1).length() - m.valuePx());
+            break;
+        }
+        if (distance <= reach) {
+            return *it;
+        }
+    }
+    return -1;
+}
+
+int TMeasurementStore::selectInRect(const QRectF &rect)
+{
+    std::vector<int> candidates;
+    query(rect, candidates);
+    int selected = 0;
+    for (int index : candidates) {
+        TMeasurement& m = items_[index];
+        if (!m.selected && rect.contains(shapeRect(m))) {
+            m.selected = true;
+            ++selected;
+        }
+    }
+    return selected;
+}
+
+void TMeasurementStore::clearSelection(std::vector<int> *changed)
+{
+    for (int i = 0; i < size(); ++i) {
+        if (items_[i].selected) {
+            items_[i].selected = false;
+            if (changed != nullptr) {
+                changed->push_back(i);
+            }
+        }
+    }
+}
+
+QRectF TMeasurementStore::shapeRect(const TMeasurement &measurement)
+{
+    switch (measurement.type) {
+    case TMeasurement::Type::Line:
+        return QRectF(measurement.p1, measurement.p2).normalized();
+    case TMeasurement::Type::Circle:
+    {
+        const qreal radius = measurement.valuePx();
+        return QRectF(measurement.p1.x() - radius, measurement.p1.y() - radius, 2 * radius, 2 * radius);
+    }
+    }
+    return QRectF();
+}
+
+void TMeasurementStore::indexArea(int index)
+{
+    forEachCell(areas_[index], [this, index](int cx, int cy) {
+        Cell& cell = cells_[cellKey(cx, cy)];
+        if (cell.generation != generation_) {
+            cell.items.clear();
+            cell.generation = generation_;
+        }
+        cell.items.push_back(index);
+    });
+}
+
+uint64_t TMeasurementStore::cellKey(int cx, int cy)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+}
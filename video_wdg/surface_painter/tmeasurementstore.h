@@ -0,0 +1,209 @@
+/** @file
+ *
+ * TVideoWdg - SimpleMeasurementByVideoTool
+ * By Ilia.belou <ilia.belou@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef TMEASUREMENTSTORE_H
+#define TMEASUREMENTSTORE_H
+
+#include <QLineF>
+#include <QPointF>
+#include <QRectF>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+constexpr qreal MEASUREMENT_GRID_CELL = 128.0;      ///< Side of a spatial index cell in scene pixels.
+constexpr qreal MEASUREMENT_HIT_TOLERANCE = 5.0;    ///< Default distance from a shape that still hits it, in scene pixels.
+
+/*!
+ * \struct TMeasurement
+ * \brief A finished measurement.
+ *
+ * Only the geometry and the drawing style are stored; the value in millimeters, the annotation and the colour are
+ * derived when drawing, so they always follow the current calibration.
+ */
+struct TMeasurement
+{
+    /*!
+     * \brief Enumeration for measurement types.
+     */
+    enum class Type : uint {
+        Line,   ///< Line segment from p1 to p2.
+        Circle  ///< Circle centred at p1 passing through p2.
+    };
+
+    Type type = Type::Line;     ///< Measurement type.
+    QPointF p1;                 ///< Line start or circle centre in scene pixels.
+    QPointF p2;                 ///< Line end or point on the circle in scene pixels.
+    int lineWidth = 1;          ///< Line width of the shape.
+    int fontSize = 10;          ///< Font size of the annotation.
+    bool selected = false;      ///< Flag indicating if the measurement is selected.
+
+    /*!
+     * \brief Computes the measured value in pixels.
+     * \return Length of the line or radius of the circle.
+     */
+    double valuePx() const { return QLineF(p1, p2).length(); }
+
+    /*!
+     * \brief Computes the measured value in millimeters.
+     * \param mmInPixelsWidth Millimeters per pixel along x.
+     * \param mmInPixelsHeight Millimeters per pixel along y.
+     * \return Length of the line or radius of the circle.
+     */
+    double valueMm(double mmInPixelsWidth, double mmInPixelsHeight) const {
+        const double dx = (p2.x() - p1.x()) * mmInPixelsWidth;
+        const double dy = (p2.y() - p1.y()) * mmInPixelsHeight;
+        return std::sqrt(dx * dx + dy * dy);
+    }
+};
+
+/*!
+ * \class TMeasurementStore
+ * \brief Compact storage of measurements with a spatial index.
+ *
+ * The `TMeasurementStore` class keeps measurements in a flat array together with the scene area each one covers, and
+ * indexes the areas in a uniform grid of `MEASUREMENT_GRID_CELL` cells. Rectangle queries and hit-tests only look at
+ * the measurements registered in the cells they touch, so their cost does not grow with the total number of
+ * measurements. Clearing the store is O(1): the grid is invalidated by bumping a generation counter, and each cell is
+ * emptied lazily, keeping its memory, the next time it is used.
+ */
+class TMeasurementStore
+{
+public:
+    /*!
+     * \brief Adds a measurement.
+     * \param measurement The measurement.
+     * \param area The scene area covered by the measurement and its annotation.
+     * \return Index of the measurement.
+     */
+    int add(const TMeasurement& measurement, const QRectF& area);
+
+    /*!
+     * \brief Removes all measurements.
+     */
+    void clear();
+
+    /*!
+     * \brief Retrieves the number of measurements.
+     * \return The number of measurements.
+     */
+    int size() const { return static_cast<int>(items_.size()); }
+
+    /*!
+     * \brief Retrieves a measurement.
+     * \param index Index of the measurement.
+     * \return The measurement.
+     */
+    const TMeasurement& at(int index) const { return items_[index]; }
+
+    /*!
+     * \brief Retrieves the area covered by a measurement.
+     * \param index Index of the measurement.
+     * \return The area passed to add().
+     */
+    const QRectF& areaAt(int index) const { return areas_[index]; }
+
+    /*!
+     * \brief Replaces the areas of all measurements and rebuilds the index.
+     * \param areas The new area of each measurement, in index order.
+     *
+     * Used when the annotations change size, e.g. after a calibration change. The size of `areas` must match size().
+     */
+    void updateAreas(const std::vector<QRectF>& areas);
+
+    /*!
+     * \brief Retrieves the union of the areas of all measurements.
+     * \return The bounding rectangle, null if the store is empty.
+     */
+    QRectF bounds() const { return bounds_; }
+
+    /*!
+     * \brief Finds the measurements whose area intersects a rectangle.
+     * \param rect The rectangle in scene pixels.
+     * \param out Receives the indices in ascending order. Cleared first.
+     */
+    void query(const QRectF& rect, std::vector<int>& out) const;
+
+    /*!
+     * \brief Finds the topmost measurement whose shape passes near a point.
+     * \param point The point in scene pixels.
+     * \param tolerance The largest distance from the shape outline.
+     * \return Index of the measurement, or -1 if none is hit.
+     */
+    int hitTest(const QPointF& point, qreal tolerance = MEASUREMENT_HIT_TOLERANCE) const;
+
+    /*!
+     * \brief Selects or deselects a measurement.
+     * \param index Index of the measurement.
+     * \param selected The new selection state.
+     */
+    void setSelected(int index, bool selected) { items_[index].selected = selected; }
+
+    /*!
+     * \brief Selects the measurements whose shape lies inside a rectangle.
+     * \param rect The rectangle in scene pixels.
+     * \return Number of newly selected measurements.
+     */
+    int selectInRect(const QRectF& rect);
+
+    /*!
+     * \brief Deselects all measurements.
+     * \param changed Receives the indices of the measurements that were selected, if not null.
+     */
+    void clearSelection(std::vector<int>* changed = nullptr);
+
+    /*!
+     * \brief Computes the bounding rectangle of the shape of a measurement.
+     * \param measurement The measurement.
+     * \return The rectangle, without the line width and the annotation.
+     */
+    static QRectF shapeRect(const TMeasurement& measurement);
+
+private:
+    /*!
+     * \struct Cell
+     * \brief Grid cell listing the measurements whose area overlaps it.
+     */
+    struct Cell {
+        uint64_t generation = 0;    ///< Store generation the list belongs to.
+        std::vector<int> items;     ///< Indices of the measurements.
+    };
+
+    /*!
+     * \brief Computes the key of a grid cell.
+     * \param cx Column of the cell.
+     * \param cy Row of the cell.
+     * \return The key.
+     */
+    static uint64_t cellKey(int cx, int cy);
+
+    /*!
+     * \brief Registers the area of a measurement in the grid cells it overlaps.
+     * \param index Index of the measurement.
+     */
+    void indexArea(int index);
+
+    /*!
+     * \brief Calls a function for every grid cell overlapping a rectangle.
+     * \param rect The rectangle in scene pixels.
+     * \param fn Callable taking the cell column and row.
+     */
+    template<typename Fn>
+    static void forEachCell(const QRectF& rect, const Fn& fn);
+
+    std::vector<TMeasurement> items_;               ///< Measurements in insertion order.
+    std::vector<QRectF> areas_;                     ///< Area of each measurement.
+    std::unordered_map<uint64_t, Cell> cells_;      ///< Grid cells that have been used.
+    uint64_t generation_ = 1;                       ///< Current generation, cells of older ones are empty.
+    QRectF bounds_;                                 ///< Union of all areas.
+    mutable std::vector<uint32_t> marks_;           ///< Per-measurement stamp removing duplicates from queries.
+    mutable uint32_t queryStamp_ = 0;               ///< Stamp of the current query.
+};
+
+#endif // TMEASUREMENTSTORE_H
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include "tmeasurementstore.h"
+
+namespace {
+// Линия с областью, расширенной на ширину пера
+TMeasurement makeLine(const QPointF& p1, const QPointF& p2) {
+    TMeasurement m;
+    m.type = TMeasurement::Type::Line;
+    m.p1 = p1;
+    m.p2 = p2;
+    return m;
+}
+
+TMeasurement makeCircle(const QPointF& centre, qreal radius) {
+    TMeasurement m;
+    m.type = TMeasurement::Type::Circle;
+    m.p1 = centre;
+    m.p2 = centre + QPointF(radius, 0);
+    return m;
+}
+
+QRectF areaOf(const TMeasurement& m) {
+    return TMeasurementStore::shapeRect(m).adjusted(-2, -2, 2, 2);
+}
+
+int addMeasurement(TMeasurementStore& store, const TMeasurement& m) {
+    return store.add(m, areaOf(m));
+}
+}
+
+// Пустое хранилище ничего не находит
+TEST(TMeasurementStoreTest, Empty) {
+    TMeasurementStore store;
+    std::vector<int> found;
+    store.query(QRectF(0, 0, 1000, 1000), found);
+    EXPECT_TRUE(found.empty());
+    EXPECT_EQ(store.hitTest(QPointF(10, 10)), -1);
+    EXPECT_TRUE(store.bounds().isNull());
+}
+
+// Запрос по прямоугольнику возвращает только пересекающиеся измерения, без повторов
+TEST(TMeasurementStoreTest, QueryRect) {
+    TMeasurementStore store;
+    const int a = addMeasurement(store, makeLine(QPointF(10, 10), QPointF(500, 10)));   // несколько ячеек
+    const int b = addMeasurement(store, makeLine(QPointF(1000, 1000), QPointF(1010, 1010)));
+    const int c = addMeasurement(store, makeCircle(QPointF(300, 300), 50));
+
+    std::vector<int> found;
+    store.query(QRectF(0, 0, 400, 400), found);
+    EXPECT_EQ(found, (std::vector<int>{a, c}));
+
+    store.query(QRectF(990, 990, 50, 50), found);
+    EXPECT_EQ(found, (std::vector<int>{b}));
+
+    store.query(QRectF(-5000, -5000, 10000, 10000), found);
+    EXPECT_EQ(found, (std::vector<int>{a, b, c}));
+}
+
+// Попадание по линии и по окружности, но не внутрь окружности
+TEST(TMeasurementStoreTest, HitTest) {
+    TMeasurementStore store;
+    const int line = addMeasurement(store, makeLine(QPointF(0, 0), QPointF(200, 0)));
+    const int circle = addMeasurement(store, makeCircle(QPointF(500, 500), 100));
+
+    EXPECT_EQ(store.hitTest(QPointF(100, 3)), line);
+    EXPECT_EQ(store.hitTest(QPointF(100, 20)), -1);
+    EXPECT_EQ(store.hitTest(QPointF(210, 0)), -1);
+    EXPECT_EQ(store.hitTest(QPointF(600, 500)), circle);
+    EXPECT_EQ(store.hitTest(QPointF(500, 398)), circle);
+    EXPECT_EQ(store.hitTest(QPointF(500, 500)), -1);
+}
+
+// При наложении выбирается верхнее (последнее) измерение
+TEST(TMeasurementStoreTest, HitTestTopmost) {
+    TMeasurementStore store;
+    addMeasurement(store, makeLine(QPointF(0, 50), QPointF(100, 50)));
+    const int top = addMeasurement(store, makeLine(QPointF(50, 0), QPointF(50, 100)));
+    EXPECT_EQ(store.hitTest(QPointF(50, 50)), top);
+}
+
+// Выделение рамкой и сброс выделения
+TEST(TMeasurementStoreTest, Selection) {
+    TMeasurementStore store;
+    const int inside = addMeasurement(store, makeLine(QPointF(10, 10), QPointF(90, 90)));
+    const int partial = addMeasurement(store, makeLine(QPointF(50, 50), QPointF(300, 50)));
+    addMeasurement(store, makeCircle(QPointF(1000, 1000), 10));
+
+    EXPECT_EQ(store.selectInRect(QRectF(0, 0, 100, 100)), 1);
+    EXPECT_TRUE(store.at(inside).selected);
+    EXPECT_FALSE(store.at(partial).selected);
+
+    store.setSelected(partial, true);
+    std::vector<int> changed;
+    store.clearSelection(&changed);
+    EXPECT_EQ(changed, (std::vector<int>{inside, partial}));
+    EXPECT_FALSE(store.at(inside).selected);
+    EXPECT_FALSE(store.at(partial).selected);
+}
+
+// После очистки старые ячейки сетки не возвращают устаревшие индексы
+TEST(TMeasurementStoreTest, ClearInvalidatesIndex) {
+    TMeasurementStore store;
+    addMeasurement(store, makeLine(QPointF(0, 0), QPointF(1000, 1000)));
+    addMeasurement(store, makeLine(QPointF(0, 1000), QPointF(1000, 0)));
+    store.clear();
+    EXPECT_EQ(store.size(), 0);
+
+    std::vector<int> found;
+    store.query(QRectF(0, 0, 1000, 1000), found);
+    EXPECT_TRUE(found.empty());
+
+    const int line = addMeasurement(store, makeLine(QPointF(100, 100), QPointF(120, 100)));
+    store.query(QRectF(0, 0, 1000, 1000), found);
+    EXPECT_EQ(found, (std::vector<int>{line}));
+    EXPECT_EQ(store.hitTest(QPointF(500, 500)), -1);
+}
+
+// Значение в мм считается по текущей калибровке отдельно по осям
+TEST(TMeasurementStoreTest, ValueMm) {
+    const TMeasurement line = makeLine(QPointF(0, 0), QPointF(30, 40));
+    EXPECT_DOUBLE_EQ(line.valuePx(), 50.0);
+    EXPECT_DOUBLE_EQ(line.valueMm(0.1, 0.1), 5.0);
+    EXPECT_DOUBLE_EQ(line.valueMm(0.2, 0.1), std::sqrt(6.0 * 6.0 + 4.0 * 4.0));
+    const TMeasurement circle = makeCircle(QPointF(10, 10), 20);
+    EXPECT_DOUBLE_EQ(circle.valueMm(0.5, 2.0), 10.0);
+}
+
+// Замена областей перестраивает индекс целиком
+TEST(TMeasurementStoreTest, UpdateAreas) {
+    TMeasurementStore store;
+    const int a = addMeasurement(store, makeLine(QPointF(0, 0), QPointF(10, 0)));
+    const int b = addMeasurement(store, makeLine(QPointF(500, 500), QPointF(510, 500)));
+
+    // Подписи стали шире: область первого измерения дотянулась до второго
+    std::vector<QRectF> areas = {QRectF(-2, -2, 800, 20), store.areaAt(b)};
+    store.updateAreas(areas);
+
+    std::vector<int> found;
+    store.query(QRectF(700, 0, 10, 10), found);
+    EXPECT_EQ(found, (std::vector<int>{a}));
+    store.query(QRectF(495, 495, 10, 10), found);
+    EXPECT_EQ(found, (std::vector<int>{b}));
+    EXPECT_EQ(store.bounds().right(), 798);
+}
+
+// 10000 измерений: добавление, запрос, попадание и очистка за миллисекунды
+TEST(TMeasurementStoreTest, TenThousandMeasurements) {
+    constexpr int COUNT = 10000;
+    TMeasurementStore store;
+
+    for (int i = 0; i < COUNT; ++i) {
+        const QPointF p((i % 100) * 40.0, (i / 100) * 40.0);
+        addMeasurement(store, i % 2 ? makeLine(p, p + QPointF(30, 10)) : makeCircle(p + QPointF(15, 15), 10));
+    }
+    EXPECT_EQ(store.size(), COUNT);
+    std::vector<int> found;
+    store.query(QRectF(0, 0, 395, 395), found);
+    EXPECT_EQ(found.size(), 100u);
+    EXPECT_EQ(store.hitTest(QPointF(40 * 51 + 15, 40 * 7)), 7 * 100 + 51);
+    store.clear();
+    EXPECT_EQ(store.size(), 0);
+}
@@ -3,7 +3,20 @@
 
 TSurfacePainter::TSurfacePainter(QGraphicsScene *scene_) : scene_(scene_)
 {
-
+    // Spinbox drags and key repeat deliver a value per event loop pass: relabel at most once per RELABEL_PERIOD.
+    relabelTimer_.setSingleShot(true);
+    relabelTimer_.setInterval(RELABEL_PERIOD);
+    connect(&relabelTimer_, &QTimer::timeout, this, [this]() {
+        if (layer_ != nullptr) {
+            layer_->setCalibration(mmInPixelsWidth_, mmInPixelsHeight_);
+        }
+    });
+    if (scene_ != nullptr) {
+        layer_ = new TMeasurementLayer(&store_);
+        layer_->setZValue(MEASUREMENT_LAYER_Z);
+        layer_->setCalibration(mmInPixelsWidth_, mmInPixelsHeight_);
+        scene_->addItem(layer_);
+    }
 }
 
 TSurfacePainter::~TSurfacePainter()
@@ -11,15 +24,23 @@ TSurfacePainter::~TSurfacePainter()
     clearScene();
     clearTempObjs();
     delete tempItem_;
-    delete lastItem_;
     delete tempTextItem_;
-    delete lastTextItem_;
+    if (layer_ != nullptr) {
+        scene_->removeItem(layer_);
+        delete layer_;
+    }
 }
 
 void TSurfacePainter::handleMousePressed(QMouseEvent *event)
 {
-    if (currentDrawMode_ == DrawMode::None || event->button() != Qt::LeftButton) return;
+    if (event->button() != Qt::LeftButton) return;
     if (scene_ == nullptr) return;
+    if (currentDrawMode_ == DrawMode::None) {
+        if (!scene_->views().isEmpty()) {
+            selectAt(scene_->views().first()->mapToScene(event->pos()), event->modifiers() & Qt::ControlModifier);
+        }
+        return;
+    }
 
     // Clear tempory obj elm and text
     clearTempObjs();
@@ -75,6 +96,18 @@ void TSurfacePainter::handleMousePressed(QMouseEvent *event)
         scene_->addItem(tempTextItem_);
     }
     break;
+    case DrawMode::Roi:
+    {
+        if (!scene_->views().isEmpty()) {
+            startPoint_ = scene_->views().first()->mapToScene(event->pos());
+        }
+        isDrawing_ = true;
+        QGraphicsRectItem *rect = new QGraphicsRectItem(QRectF(startPoint_, startPoint_));
+        rect->setPen(QPen(Qt::green, lineWidth_, Qt::DashLine));
+        scene_->addItem(rect);
+        tempItem_ = rect;
+    }
+    break;
     case DrawMode::None:break;
     }
 }
@@ -148,6 +181,15 @@ void TSurfacePainter::handleMouseMoved(QMouseEvent *event)
         }
     }
     break;
+    case DrawMode::Roi:
+    {
+        QGraphicsRectItem *rect = qgraphicsitem_cast<QGraphicsRectItem*>(tempItem_);
+        if (rect) {
+            rect->setRect(QRectF(startPoint_, currentPoint).normalized());
+            scene_->update();
+        }
+    }
+    break;
     case DrawMode::None: break;
     }
 }
@@ -171,31 +213,23 @@ void TSurfacePainter::handleMouseReleased(QMouseEvent *event)
     }
 
 
+    if (currentDrawMode_ == DrawMode::Line || currentDrawMode_ == DrawMode::Circle) {
+        // Apply a pending calibration change before the new label is measured.
+        layer_->setCalibration(mmInPixelsWidth_, mmInPixelsHeight_);
+    }
+
     if (currentDrawMode_ == DrawMode::Line) {
 
         clearTempObjs();
 
 
-        QGraphicsLineItem *line = new QGraphicsLineItem(
-            startPoint_.x(), startPoint_.y(), endPoint.x(), endPoint.y()
-            );
-        line->setPen(QPen(Qt::red, lineWidth_));
-        scene_->addItem(line);
-        lastItem_ = line;
-        paintedObjInScene.append(lastItem_);
-
-        double length = QLineF(startPoint_, endPoint).length();
-        double lengthInmm = calculateLineLengthInMm(startPoint_,endPoint);
-        lastTextItem_ = new QGraphicsTextItem(QString("L: %1 px, %2 mm")
-                                                  .arg(length, 0, 'f', PX_DISPLAY_PRESICION)
-                                                  .arg(lengthInmm, 0, 'f', UNITS_MES_DISPLAY_PRESICION));
-        lastTextItem_->setFont(QFont("Arial", fontSize_));
-        lastTextItem_->setDefaultTextColor(Qt::red);
-        double textX = qMax(startPoint_.x(), endPoint.x()) + TEXT_DISPLAY_OFFSET_HOR_INPX;
-        double textY = qMin(startPoint_.y(), endPoint.y()) - TEXT_DISPLAY_OFFSET_VERT_INPX;
-        lastTextItem_->setPos(textX, textY);
-        scene_->addItem(lastTextItem_);
-        paintedTextObjInScene.append(lastTextItem_);
+        TMeasurement measurement;
+        measurement.type = TMeasurement::Type::Line;
+        measurement.p1 = startPoint_;
+        measurement.p2 = endPoint;
+        measurement.lineWidth = lineWidth_;
+        measurement.fontSize = fontSize_;
+        layer_->addMeasurement(measurement);
     } else if (currentDrawMode_ == DrawMode::Circle) {
 
         if (tempItem_ && scene_->items().contains(tempItem_)) {
@@ -209,31 +243,31 @@ void TSurfacePainter::handleMouseReleased(QMouseEvent *event)
             tempTextItem_ = nullptr;
         }
 
-        qreal radius = QLineF(startPoint_, endPoint).length();
-        qreal dx = endPoint.x() - startPoint_.x();
-        qreal dy = endPoint.y() - startPoint_.y();
-        qreal dx_mm = dx * mmInPixelsWidth_;
-        qreal dy_mm = dy * mmInPixelsHeight_;
-        qreal radiusInmm = std::sqrt(dx_mm * dx_mm + dy_mm * dy_mm);
-        QGraphicsEllipseItem *circle = new QGraphicsEllipseItem(
-            startPoint_.x() - radius, startPoint_.y() - radius, radius * 2, radius * 2
-            );
-        circle->setPen(QPen(Qt::blue, lineWidth_));
-        scene_->addItem(circle);
-        lastItem_ = circle;
-        paintedObjInScene.append(lastItem_);
-
-        lastTextItem_ = new QGraphicsTextItem(QString("R: %1 px, %2 mm")
-                                                  .arg(radius, 0, 'f', 0)
-                                                  .arg(radiusInmm, 0, 'f', 2));
-        lastTextItem_->setFont(QFont("Arial", fontSize_));
-        lastTextItem_->setDefaultTextColor(Qt::blue);
-        qreal textX = startPoint_.x() + radius + 5;
-        qreal textY = startPoint_.y() - radius - 5;
-        lastTextItem_->setPos(textX, textY);
-        scene_->addItem(lastTextItem_);
-        paintedTextObjInScene.append(lastTextItem_);
+        TMeasurement measurement;
+        measurement.type = TMeasurement::Type::Circle;
+        measurement.p1 = startPoint_;
+        measurement.p2 = endPoint;
+        measurement.lineWidth = lineWidth_;
+        measurement.fontSize = fontSize_;
+        layer_->addMeasurement(measurement);
         isSettingCircleCenter_ = true;
+    } else if (currentDrawMode_ == DrawMode::Roi) {
+
+        clearTempObjs();
+
+        const QRect roi = QRectF(startPoint_, endPoint).normalized().toRect();
+        if (roi.width() < 2 || roi.height() < 2) {
+            // A click without dragging drops the selection.
+            clearRoi();
+        } else {
+            if (roiItem_ == nullptr) {
+                roiItem_ = new QGraphicsRectItem;
+                scene_->addItem(roiItem_);
+            }
+            roiItem_->setPen(QPen(Qt::green, lineWidth_));
+            roiItem_->setRect(roi);
+            emit roiChanged(roi);
+        }
     }
 
     isDrawing_ = false;
@@ -244,20 +278,48 @@ void TSurfacePainter::clearScene()
     if (scene_ == nullptr) {
         return;
     }
-    foreach (QGraphicsItem* obj, paintedObjInScene) {
-        if (obj && scene_->items().contains(obj)) {
-            scene_->removeItem(obj);
-            delete obj;
+    layer_->clear();
+    clearRoi();
+}
+
+void TSurfacePainter::selectAt(const QPointF &point, bool toggle)
+{
+    const qreal tolerance = MEASUREMENT_HIT_TOLERANCE * qMax(1, lineWidth_);
+    const int hit = store_.hitTest(point, tolerance);
+    if (!toggle) {
+        std::vector<int> deselected;
+        store_.clearSelection(&deselected);
+        for (int index : deselected) {
+            if (index != hit) {
+                layer_->updateMeasurement(index);
+            }
         }
-    }
-    foreach (QGraphicsTextItem* objText, paintedTextObjInScene) {
-        if (objText && scene_->items().contains(objText)) {
-            scene_->removeItem(objText);
-            delete objText;
+        if (hit >= 0) {
+            store_.setSelected(hit, true);
+            layer_->updateMeasurement(hit);
         }
+    } else if (hit >= 0) {
+        store_.setSelected(hit, !store_.at(hit).selected);
+        layer_->updateMeasurement(hit);
+    }
+}
+
+void TSurfacePainter::clearRoi()
+{
+    if (roiItem_ == nullptr) {
+        return;
+    }
+    if (scene_ != nullptr && roiItem_->scene() == scene_) {
+        scene_->removeItem(roiItem_);
     }
-    lastItem_ = nullptr;
-    lastTextItem_ = nullptr;
+    delete roiItem_;
+    roiItem_ = nullptr;
+    emit roiChanged(QRect());
+}
+
+QRect TSurfacePainter::getRoi() const
+{
+    return roiItem_ ? roiItem_->rect().toRect() : QRect();
 }
 
 void TSurfacePainter::setFontSize(int size)
@@ -278,12 +340,18 @@ void TSurfacePainter::setmmInPixelsWidth(double value)
 {
     value < 0 ? value = 0.001 : false;
     mmInPixelsWidth_ = value;
+    if (!relabelTimer_.isActive()) {
+        relabelTimer_.start();
+    }
 }
 
 void TSurfacePainter::setmmInPixelsHeight(double value)
 {
     value < 0 ? value = 0.001 : false;
     mmInPixelsHeight_ = value;
+    if (!relabelTimer_.isActive()) {
+        relabelTimer_.start();
+    }
 }
 
 void TSurfacePainter::setCurrentDrawMode(DrawMode drawMode)
@@ -295,6 +363,9 @@ void TSurfacePainter::setCurrentDrawMode(DrawMode drawMode)
     case DrawMode::Circle:
         currentDrawMode_ = DrawMode::Circle;
         break;
+    case DrawMode::Roi:
+        currentDrawMode_ = DrawMode::Roi;
+        break;
     default:
         currentDrawMode_ = DrawMode::None;
     }
@@ -16,13 +16,19 @@
 #include <QGraphicsItem>
 #include <QGraphicsLineItem>
 #include <QGraphicsEllipseItem>
+#include <QGraphicsRectItem>
 #include <QGraphicsTextItem>
 #include <QGraphicsView>
+#include <QTimer>
+
+#include "tmeasurementlayer.h"
 
 constexpr int PX_DISPLAY_PRESICION = 0;                 ///< Precision for displaying pixel measurements (decimal places).
 constexpr int UNITS_MES_DISPLAY_PRESICION = 2;          ///< Precision for displaying measurements in millimeters (decimal places).
 constexpr int TEXT_DISPLAY_OFFSET_HOR_INPX = 5;         ///< Horizontal offset for text placement in pixels.
 constexpr int TEXT_DISPLAY_OFFSET_VERT_INPX = 5;        ///< Vertical offset for text placement in pixels.
+constexpr int RELABEL_PERIOD = 40;                      ///< Shortest interval in milliseconds between relabels on calibration changes.
+constexpr qreal MEASUREMENT_LAYER_Z = 1.0;              ///< Z value of the measurement layer, above the video.
 
 /*!
  * \class TSurfacePainter
@@ -30,10 +36,12 @@ constexpr int TEXT_DISPLAY_OFFSET_VERT_INPX = 5;        ///< Vertical offset for
  *
  * The `TSurfacePainter` class is a `QObject` that facilitates interactive drawing of lines and circles on a
  * `QGraphicsScene`. It supports two drawing modes: `Line` and `Circle`, allowing users to draw shapes with
- * mouse interactions and display measurements in pixels and millimeters. The class handles preview and
- * permanent graphics items, updates annotations dynamically, and supports configuration of font size, line
+ * mouse interactions and display measurements in pixels and millimeters. The shape being drawn is previewed with
+ * temporary graphics items; finished measurements are added to a cached `TMeasurementLayer`, so they are not redrawn
+ * with every video frame. The class updates annotations dynamically, and supports configuration of font size, line
  * width, and pixel-to-millimeter conversion factors. It is typically used in conjunction with a `QGraphicsView`
- * to visualize video frames or images with overlaid measurements.
+ * to visualize video frames or images with overlaid measurements. In `Roi` mode a rectangle is dragged to select the
+ * region of interest for frame processing, announced with the `roiChanged` signal; a click without dragging clears it.
  */
 class TSurfacePainter : public QObject
 {
@@ -45,7 +53,8 @@ public:
     enum class DrawMode : uint {
         None,   ///< No drawing mode (inactive).
         Line,   ///< Draw a line segment.
-        Circle  ///< Draw a circle.
+        Circle, ///< Draw a circle.
+        Roi     ///< Select the region of interest.
     };
 
     /*!
@@ -59,16 +68,35 @@ public:
     /*!
      * \brief Destructor.
      *
-     * Cleans up all temporary and permanent graphics items and text annotations from the scene.
+     * Cleans up the temporary graphics items and the measurement layer from the scene.
      */
     ~TSurfacePainter();
+
+    /*!
+     * \brief Retrieves the selected region of interest.
+     * \return The region in scene coordinates, empty if none is selected.
+     */
+    QRect getRoi() const;
+
+    /*!
+     * \brief Retrieves the finished measurements.
+     * \return The measurement store.
+     */
+    const TMeasurementStore& getMeasurements() const { return store_; }
+signals:
+    /*!
+     * \brief Emitted when the region of interest is selected or cleared.
+     * \param roi The region in scene coordinates, empty if cleared.
+     */
+    void roiChanged(const QRect& roi);
 public slots:    
     /*!
      * \brief Handles mouse press events to start drawing.
      * \param event The mouse event containing press details.
      *
      * Initiates drawing of a line or circle based on the current draw mode. For circles, it supports
-     * setting the center point if `isSettingCircleCenter_` is true.
+     * setting the center point if `isSettingCircleCenter_` is true. Without a draw mode, selects the measurement
+     * under the cursor; with Ctrl held the selection of that measurement is toggled instead.
      */
     void handleMousePressed(QMouseEvent *event);
 
@@ -85,16 +113,23 @@ public slots:
      * \brief Handles mouse release events to finalize drawing.
      * \param event The mouse event containing release details.
      *
-     * Finalizes the drawing by creating a permanent graphics item and its measurement annotation.
+     * Finalizes the drawing by adding the measurement and its annotation to the measurement layer.
      * For circles, it resets the center-setting mode.
      */
     void handleMouseReleased(QMouseEvent *event);
 
     /*!
-     * \brief Clears all permanent graphics items and text annotations from the scene.
+     * \brief Clears all finished measurements from the scene.
+     *
+     * Also clears the region of interest.
      */
     void clearScene();
 
+    /*!
+     * \brief Clears the region of interest.
+     */
+    void clearRoi();
+
     /*!
      * \brief Sets the font size for measurement annotations.
      * \param size The font size in points (clamped between 1 and 60).
@@ -110,18 +145,23 @@ public slots:
     /*!
      * \brief Sets the conversion factor from pixels to millimeters for width measurements.
      * \param value The millimeters per pixel (minimum 0.001).
+     *
+     * The labels of all existing measurements are updated once control returns to the event loop, so a burst of
+     * changes is applied as a single batch.
      */
     void setmmInPixelsWidth(double value);
 
     /*!
      * \brief Sets the conversion factor from pixels to millimeters for height measurements.
      * \param value The millimeters per pixel (minimum 0.001).
+     *
+     * The labels of all existing measurements are updated as for setmmInPixelsWidth().
      */
     void setmmInPixelsHeight(double value);
 
     /*!
      * \brief Sets the current drawing mode.
-     * \param drawMode The drawing mode (None, Line, or Circle).
+     * \param drawMode The drawing mode (None, Line, Circle or Roi).
      */
     void setCurrentDrawMode(DrawMode drawMode);
 
@@ -135,17 +175,24 @@ private:
     DrawMode currentDrawMode_ = DrawMode::None;         ///< Current drawing mode.
     QPointF startPoint_;                                ///< Starting point for the current drawing.
     QGraphicsItem* tempItem_ = nullptr;                 ///< Temporary graphics item for drawing preview.
-    QGraphicsItem* lastItem_ = nullptr;                 ///< Last permanent graphics item drawn.
-    QList<QGraphicsItem*> paintedObjInScene;            ///< List of permanent graphics items in the scene.
     QGraphicsTextItem* tempTextItem_ = nullptr;         ///< Temporary text item for measurement preview.
-    QGraphicsTextItem* lastTextItem_ = nullptr;         ///< Last permanent text item for measurements.
-    QList<QGraphicsTextItem*> paintedTextObjInScene;    ///< List of permanent text items in the scene.
+    TMeasurementStore store_;                           ///< Finished measurements.
+    TMeasurementLayer* layer_ = nullptr;                ///< Layer drawing the finished measurements.
+    QGraphicsRectItem* roiItem_ = nullptr;              ///< Outline of the selected region of interest.
     bool isSettingCircleCenter_ = false;                ///< Flag indicating if the next press sets the circle center.
     bool isDrawing_ = false;                            ///< Flag indicating if drawing is in progress.
     int fontSize_ = 10;                                 ///< Font size for measurement annotations.
     int lineWidth_ = 1;                                 ///< Line width for drawn shapes.
     double mmInPixelsWidth_ = 0.001;                    ///< Millimeters per pixel for width measurements.
     double mmInPixelsHeight_ = 0.001;                    ///< Millimeters per pixel for height measurements.
+    QTimer relabelTimer_;                               ///< Coalesces calibration changes within RELABEL_PERIOD into one relabel.
+
+    /*!
+     * \brief Selects the measurement at a point.
+     * \param point The point in scene coordinates.
+     * \param toggle If true, toggles the selection of the hit measurement and keeps the others selected.
+     */
+    void selectAt(const QPointF& point, bool toggle);
 
     /*!
      * \brief Removes temporary graphics and text items from the scene.
@@ -1,25 +1,42 @@
 #include "tvideowdg.h"
+#include <QDebug>
+#include <QFile>
+#include <QFontDatabase>
+#include <QScreen>
+#include <QtMath>
 #include "frame_middleware/tedgedetector.h"
+#include "frame_providers/tfileframeprovider.h"
 #include "frame_providers/trtcpframeprovider.h"
+#include "frame_providers/ttestpatternframeprovider.h"
 #include "frame_providers/tvideodeviceframeprovider.h"
 
+#include <sstream>
+
 TVideoWdg::TVideoWdg(QWidget *parent) :
     QGraphicsView(parent),
     scene_(new QGraphicsScene(this)),
     painter_(new TSurfacePainter(scene_.get())),
-    currentFrame_(new QGraphicsPixmapItem)
+    pipeline_(new TFramePipeline),
+    captureExecutor_(new TCaptureExecutor),
+    videoItem_(new TVideoItem)
 {
     // Painter
     connect(this,&TVideoWdg::mouseMoved,painter_,&TSurfacePainter::handleMouseMoved);
     connect(this,&TVideoWdg::mousePressed,painter_,&TSurfacePainter::handleMousePressed);
     connect(this,&TVideoWdg::mouseReleased,painter_,&TSurfacePainter::handleMouseReleased);
+    connect(painter_,&TSurfacePainter::roiChanged,this,&TVideoWdg::setRoi);
 
     // Scene
     this->setScene(scene_.get());
-    scene_->addItem(currentFrame_.get());
+    scene_->addItem(videoItem_.get());
+    // Pipeline
+    connect(pipeline_.get(), &TFramePipeline::frameProcessed, this, &TVideoWdg::scheduleFrameUpdate);
+    connect(pipeline_.get(), &TFramePipeline::degradationLevelChanged, this, &TVideoWdg::degradationLevelChanged);
+    pipeline_->start();
     // FrameProviders
     usbDevs_ = new TVideoDeviceFrameProvider;
     fproviders_.append(usbDevs_);
+    connect(usbDevs_, &IFrameProvider::frameAvailable, this, &TVideoWdg::feedPipeline);
     auto usbDevsReady = [this]() {
         videosrcDesc_.append(usbDevs_->getDeviceDesc());
         videofmtDesc_.clear();
@@ -30,15 +47,34 @@ TVideoWdg::TVideoWdg(QWidget *parent) :
     usbDevs_->start(usbDevsReady);
 
     // Frame update
+    presentFrame_.reset(new QTimer);
+    presentFrame_->setSingleShot(true);
+    connect(presentFrame_.get(),&QTimer::timeout,[this]{
+        updateFrame();
+    });
+
     updateFrame_.reset(new QTimer);
     connect(updateFrame_.get(),&QTimer::timeout,[this]{
+        feedPipeline();
         updateFrame();
     });
     updateFrame_->start(FRAME_UPDATE_PERIOD);
+
+    // Latency overlay
+    latencyOverlay_ = new QLabel(viewport());
+    latencyOverlay_->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    latencyOverlay_->setStyleSheet("background-color: rgba(0, 0, 0, 160); color: white; padding: 4px;");
+    latencyOverlay_->setAttribute(Qt::WA_TransparentForMouseEvents);
+    latencyOverlay_->hide();
+    latencyOverlayTimer_.reset(new QTimer);
+    connect(latencyOverlayTimer_.get(),&QTimer::timeout,[this]{
+        updateLatencyOverlay();
+    });
 }
 
 TVideoWdg::~TVideoWdg()
 {
+    pipeline_->stop();
     delete painter_;
     for (auto prov : fproviders_) {
         delete prov;
@@ -52,19 +88,39 @@ TSurfacePainter *TVideoWdg::getPainter()
 
 void TVideoWdg::updateFrame()
 {
-    if (fproviders_.at(currentActiveVideoProviderIdx_)->isReady()) {
-        currentFrameImg_ = fproviders_.at(currentActiveVideoProviderIdx_)->getFrame();
-        if (!fmiddlewares_.empty()) {
-            for (const auto& mw : fmiddlewares_) {
-                mw->processFrame(&currentFrameImg_);
-            }
-        }
-        currentFrame_->setPixmap(QPixmap::fromImage(currentFrameImg_));
-        updateVideoSize(currentFrameImg_);
-        scene_->update();
+    if (!pipeline_->isReady()) {
+        return;
+    }
+    TFramePacketPtr packet = pipeline_->getFrame();
+    if (!packet || packet->image.isNull()) {
+        return;
+    }
+    if (videoItem_->setFrame(packet)) {
+        updateVideoSize(videoItem_->frameSize());
+    }
+    lastPresent_.start();
+    packet->trace.mark("present");
+    latencyStats_.addTrace(packet->trace, packet->captureTime, packet->sequence, packet->sourceId);
+}
+
+void TVideoWdg::feedPipeline()
+{
+    IFrameProvider* provider = fproviders_.at(currentActiveVideoProviderIdx_);
+    if (provider->isReady()) {
+        pipeline_->submit(provider->getFrame());
     }
 }
 
+void TVideoWdg::scheduleFrameUpdate()
+{
+    if (presentFrame_->isActive()) {
+        return;
+    }
+    const int period = displayRefreshPeriod();
+    const qint64 sinceLastPresent = lastPresent_.isValid() ? lastPresent_.elapsed() : period;
+    presentFrame_->start(sinceLastPresent >= period ? 0 : static_cast<int>(period - sinceLastPresent));
+}
+
 void TVideoWdg::changeVideoSrc(const QString &src)
 {
     for (int i =0;i < fproviders_.size();i++) {
@@ -93,8 +149,9 @@ void TVideoWdg::incZoom()
     }
     resetTransform();
     scale(zoomFactor_, zoomFactor_);
-    fitInView(currentFrame_.get(), Qt::KeepAspectRatio);
+    fitInView(videoItem_.get(), Qt::KeepAspectRatio);
     scene_->update();
+    updatePreviewSize();
 }
 
 void TVideoWdg::decZoom()
@@ -105,74 +162,164 @@ void TVideoWdg::decZoom()
     }
     resetTransform();
     scale(zoomFactor_, zoomFactor_);
-    fitInView(currentFrame_.get(), Qt::KeepAspectRatio);
+    fitInView(videoItem_.get(), Qt::KeepAspectRatio);
     scene_->update();
+    updatePreviewSize();
 }
 
 void TVideoWdg::fit()
 {
-    scene_->setSceneRect(0, 0, currentFrameImg_.width(), currentFrameImg_.height());
+    if (videoItem_->getFrame()) {
+        scene_->setSceneRect(videoItem_->boundingRect());
+    }
     zoomFactor_ = 1.0;
     resetTransform();
-    fitInView(currentFrame_.get(), Qt::KeepAspectRatio);
+    fitInView(videoItem_.get(), Qt::KeepAspectRatio);
+    updatePreviewSize();
 }
 
 void TVideoWdg::useEdgeDetector(bool use)
 {
     if (use) {
-        if (!findMiddlewareByType<TEdgeDetector>()) {
-            addMiddleware(new TEdgeDetector);
+        if (!pipeline_->findMiddlewareByType<TEdgeDetector>()) {
+            TEdgeDetector* detector = new TEdgeDetector(100.0, 200.0, TEdgeDetector::Mode::Parallel);
+            // A visual aid only: may be bypassed when the chain falls behind the camera.
+            detector->setOptional(true);
+            addMiddleware(detector);
         }
     } else {
-        removeMiddlewareByType<TEdgeDetector>();
+        pipeline_->removeMiddlewareByType<TEdgeDetector>();
+    }
+}
+
+void TVideoWdg::setRoi(const QRect &roi)
+{
+    pipeline_->setRoi(roi);
+}
+
+void TVideoWdg::usePreview(bool use)
+{
+    usePreview_ = use;
+    updatePreviewSize();
+}
+
+void TVideoWdg::showLatencyOverlay(bool show)
+{
+    if (show) {
+        updateLatencyOverlay();
+        latencyOverlay_->show();
+        latencyOverlayTimer_->start(LATENCY_OVERLAY_PERIOD);
+    } else {
+        latencyOverlayTimer_->stop();
+        latencyOverlay_->hide();
     }
 }
 
+bool TVideoWdg::saveLatencyTrace(const QString &fileName)
+{
+    std::ostringstream trace;
+    if (!latencyStats_.writeChromeTrace(trace)) {
+        return false;
+    }
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "Failed to open latency trace file" << fileName;
+        return false;
+    }
+    const std::string json = trace.str();
+    return file.write(json.data(), static_cast<qint64>(json.size())) == static_cast<qint64>(json.size());
+}
+
 void TVideoWdg::addRTCPsource(QString url)
 {
     rtcp_ = new TRTCPFrameProvider;
-    fproviders_.append(rtcp_);
     rtcp_->setUrl(url.toStdString());
-    auto rtcpReady = [this]() {
-        videosrcDesc_.append(rtcp_->getDeviceDesc());
-        emit videoSourcesChanged(videosrcDesc_);
-    };
-    rtcp_->start(rtcpReady);
+    startPolledSource(rtcp_);
 }
 
-void TVideoWdg::addMiddleware(IFrameMiddleware* middleware) {
-    fmiddlewares_.push_back(std::unique_ptr<IFrameMiddleware>(middleware));
+void TVideoWdg::addFileSource(QString path)
+{
+    TFileFrameProvider* file = new TFileFrameProvider;
+    file->setUrl(path.toStdString());
+    file->setLooping(true);
+    startPolledSource(file);
 }
 
-template<typename T>
-void TVideoWdg::removeMiddlewareByType() {
-    for (auto it = fmiddlewares_.end(); it != fmiddlewares_.begin();) {
-        --it;
-        if (dynamic_cast<T*>(it->get()) != nullptr) {
-            it = fmiddlewares_.erase(it);
-        }
-    }
+void TVideoWdg::addTestPatternSource(TTestPattern::Kind kind)
+{
+    startPolledSource(new TTestPatternFrameProvider(kind));
 }
 
-template<typename T>
-bool TVideoWdg::findMiddlewareByType() {
-    for (const auto& middleware : fmiddlewares_) {
-        if (dynamic_cast<T*>(middleware.get()) != nullptr) {
-            return true;
-        }
-    }
-    return false;
+void TVideoWdg::startPolledSource(IFrameProvider* provider)
+{
+    fproviders_.append(provider);
+    connect(provider, &IFrameProvider::frameAvailable, this, &TVideoWdg::feedPipeline);
+    provider->setExecutor(captureExecutor_.get());
+    // Runs on a capture worker: touch the source list on the GUI thread only.
+    provider->start([this, provider]() {
+        QMetaObject::invokeMethod(this, [this, provider]() {
+            videosrcDesc_.append(provider->getDeviceDesc());
+            emit videoSourcesChanged(videosrcDesc_);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void TVideoWdg::addMiddleware(IFrameMiddleware* middleware) {
+    pipeline_->addMiddleware(middleware);
 }
 
 void TVideoWdg::removeAllEdgeDetectors() {
-    removeMiddlewareByType<TEdgeDetector>();
+    pipeline_->removeMiddlewareByType<TEdgeDetector>();
 }
 
-void TVideoWdg::updateVideoSize(const QImage& img)
+void TVideoWdg::updateVideoSize(const QSize& size)
 {
-    scene_->setSceneRect(0, 0, img.width(), img.height());
-    img.width()/30 > 60 ? painter_->setFontSize(60) :  painter_->setFontSize(img.width()/30);
-    img.width()/300 > 5 ? painter_->setLineWidth(5) :  painter_->setLineWidth(img.width()/300);
+    scene_->setSceneRect(0, 0, size.width(), size.height());
+    size.width()/30 > 60 ? painter_->setFontSize(60) :  painter_->setFontSize(size.width()/30);
+    size.width()/300 > 5 ? painter_->setLineWidth(5) :  painter_->setLineWidth(size.width()/300);
     resetTransform();
     scale(zoomFactor_, zoomFactor_);
+    updatePreviewSize();
+}
+
+void TVideoWdg::updatePreviewSize()
+{
+    QSize previewSize;
+    if (usePreview_ && videoItem_->getFrame()) {
+        const QSize frameSize = videoItem_->frameSize();
+        const double displayScale = transform().m11() * devicePixelRatioF();
+        if (displayScale < 1.0) {
+            previewSize = QSize(qCeil(frameSize.width() * displayScale), qCeil(frameSize.height() * displayScale));
+        }
+    }
+    if (previewSize != pipeline_->getPreviewSize()) {
+        pipeline_->setPreviewSize(previewSize);
+    }
+}
+
+int TVideoWdg::displayRefreshPeriod() const
+{
+    const QScreen* scr = screen();
+    if (scr == nullptr || scr->refreshRate() <= 0) {
+        return FRAME_UPDATE_PERIOD;
+    }
+    return qMax(1, qRound(1000.0 / scr->refreshRate()));
+}
+
+void TVideoWdg::updateLatencyOverlay()
+{
+    QString text = QString::asprintf("%-16s %7s %7s %7s", "stage, ms", "p50", "p95", "p99");
+    for (size_t i = 0; i < latencyStats_.stageCount(); ++i) {
+        text += QString::asprintf("\n%-16s %7.1f %7.1f %7.1f", latencyStats_.stageName(i).c_str(),
+                                  latencyStats_.percentile(i, 50), latencyStats_.percentile(i, 95),
+                                  latencyStats_.percentile(i, 99));
+    }
+    text += QString::asprintf("\n\n%-8s %7s %7s %7s %7s", "source", "fps", "lag, ms", "drops", "queue");
+    for (auto prov : fproviders_) {
+        const TCaptureStats stats = prov->getCaptureStats();
+        text += QString::asprintf("\n%-8d %7.1f %7.1f %7llu %7u", stats.sourceId, stats.fps, stats.lagMs,
+                                  static_cast<unsigned long long>(stats.dropped), stats.queueDepth);
+    }
+    latencyOverlay_->setText(text);
+    latencyOverlay_->adjustSize();
 }
@@ -10,25 +10,42 @@
 #define TVIDEOWDG_H
 
 #include <QGraphicsView>
+#include <QLabel>
 #include <QObject>
 #include <QTimer>
-#include <QPixmap>
+#include <QElapsedTimer>
 
 #include "video_wdg/surface_painter/tsurfacepainter.h"
 #include "video_wdg/frame_middleware/iframemiddleware.h"
 #include "video_wdg/frame_providers/iframeprovider.h"
+#include "video_wdg/frame_providers/tcaptureexecutor.h"
+#include "video_wdg/frame_providers/ttestpattern.h"
+#include "video_wdg/frame_pipeline/tframepipeline.h"
+#include "video_wdg/frame_pipeline/tlatencystats.h"
+#include "video_wdg/video_item/tvideoitem.h"
 
-constexpr int FRAME_UPDATE_PERIOD = 50; ///< Frame update period in milliseconds.
+constexpr int FRAME_UPDATE_PERIOD = 50; ///< Fallback frame polling period in milliseconds.
 constexpr double ZOOM_FACTOR = 0.05;    ///< Zoom increment/decrement factor per step.
+constexpr int LATENCY_OVERLAY_PERIOD = 500; ///< Refresh period of the latency overlay in milliseconds.
 
 /*!
  * \class TVideoWdg
  * \brief A widget for displaying and manipulating video streams with support for frame processing and zooming.
  *
  * The `TVideoWdg` class is a custom `QGraphicsView` widget designed to display video frames from various sources
- * (e.g., USB devices or RTSP streams) and apply middleware processing (e.g., edge detection). It supports zooming,
- * fitting the video to the view, and handling mouse interactions for surface painting. The widget uses a timer to
- * periodically update frames and emits signals for user interactions and video source/format changes.
+ * (e.g., USB devices or RTSP streams) and apply middleware processing (e.g., edge detection) on a `TFramePipeline`
+ * worker stage, so the GUI thread only presents finished frames. It supports zooming,
+ * fitting the video to the view, and handling mouse interactions for surface painting. Frames are presented when the
+ * providers signal them, coalesced to the display refresh rate; a slow fallback timer polls the active provider in
+ * case a notification is missed. The widget emits signals for user interactions and video source/format changes.
+ *
+ * When the video is shown smaller than its native size, the pipeline downsamples each frame once to the displayed size
+ * before middleware and presentation. The preview is drawn scaled back up to the full frame size, so scene coordinates,
+ * and therefore the measurements of the surface painter, always stay in full-resolution pixels.
+ *
+ * Every presented frame is marked with a "present" stage and its trace is added to a `TLatencyStats`. The p50/p95/p99
+ * latency of each stage can be shown in an overlay over the video, and the traces of the last frames can be saved as
+ * a Chrome trace file.
  */
 class TVideoWdg : public QGraphicsView
 {
@@ -55,6 +72,13 @@ public:
      * \return Pointer to the TSurfacePainter instance.
      */
     TSurfacePainter* getPainter();
+
+    /*!
+     * \brief Saves the traces of the last presented frames.
+     * \param fileName The path of the Chrome trace JSON file to write.
+     * \return True if the file was written successfully.
+     */
+    bool saveLatencyTrace(const QString& fileName);
 signals:
     /*!
      * \brief Emitted when the mouse is pressed on the widget.
@@ -90,16 +114,37 @@ signals:
      * \param formats The updated list of video format descriptions.
      */
     void videoFormatsChanged(QList<std::string> fmts); 
+
+    /*!
+     * \brief Emitted when the pipeline changes its degradation level under load.
+     * \param level The new level, a value of TFrameBudget::Level.
+     */
+    void degradationLevelChanged(int level);
 public slots:
 
     /*!
      * \brief Updates the displayed video frame.
      *
-     * Retrieves the latest frame from the active video provider, applies middleware processing if any,
-     * and updates the graphics scene with the new frame.
+     * Retrieves the latest processed frame from the pipeline and hands it to the video item. The view transform and
+     * the scene rectangle are only updated when the frame size changes.
      */
     void updateFrame();
 
+    /*!
+     * \brief Submits the latest frame of the active video provider to the pipeline.
+     *
+     * Called when a provider signals a new frame. Frames of inactive providers are ignored.
+     */
+    void feedPipeline();
+
+    /*!
+     * \brief Schedules presentation of a newly available frame.
+     *
+     * Called when the pipeline signals a processed frame. Presentation is deferred so that frames are shown at most once per
+     * display refresh period; further notifications before then are coalesced into the pending presentation.
+     */
+    void scheduleFrameUpdate();
+
     /*!
      * \brief Changes the active video source.
      * \param src The description of the new video source.
@@ -141,13 +186,52 @@ public slots:
      */
     void useEdgeDetector(bool use);
 
+    /*!
+     * \brief Restricts middleware processing to a region of interest.
+     * \param roi The region in frame pixels, or an empty rectangle to process whole frames.
+     *
+     * Connected to the roiChanged signal of the surface painter.
+     */
+    void setRoi(const QRect& roi);
+
+    /*!
+     * \brief Enables or disables the display-resolution preview.
+     * \param use If true, frames are processed and shown at the displayed size; if false, at full resolution.
+     */
+    void usePreview(bool use);
+
+    /*!
+     * \brief Shows or hides the latency overlay.
+     * \param show If true, the p50/p95/p99 latency of each stage and the capture statistics of each source are shown
+     * over the video.
+     */
+    void showLatencyOverlay(bool show);
+
     /*!
      * \brief Adds an RTSP video source.
      * \param url The RTSP URL of the video source.
      *
-     * Creates a new TRTCPFrameProvider, sets the URL, and starts the provider.
+     * Creates a new TRTCPFrameProvider, sets the URL, and starts the provider on the shared capture executor.
      */
     void addRTCPsource(QString url);
+
+    /*!
+     * \brief Adds a video file or raw frame dump as a video source.
+     * \param path The path of the file.
+     *
+     * Creates a new TFileFrameProvider playing the file in a loop at its recorded frame rate, and starts the provider on
+     * the shared capture executor.
+     */
+    void addFileSource(QString path);
+
+    /*!
+     * \brief Adds a synthetic test pattern as a video source.
+     * \param kind The pattern to render.
+     *
+     * Creates a new TTestPatternFrameProvider rendering 1280x720 frames at `TEST_PATTERN_DEFAULT_FPS`, and starts the
+     * provider on the shared capture executor.
+     */
+    void addTestPatternSource(TTestPattern::Kind kind);
 protected:
     /*!
      * \brief Handles mouse press events.
@@ -181,15 +265,19 @@ protected:
      */
     void resizeEvent(QResizeEvent *event) override {
         QGraphicsView::resizeEvent(event);
+        updatePreviewSize();
         emit resized();
     }
 private:
     std::unique_ptr<QGraphicsScene> scene_;                        ///< Graphics scene for displaying
     TSurfacePainter *painter_;                                     ///< Painter for drawing for measurement on the scene.
     QList<IFrameProvider* > fproviders_;                           ///< List of video frame providers.
-    std::vector<std::unique_ptr<IFrameMiddleware> > fmiddlewares_; ///< List of middleware processors for frames.
-    std::unique_ptr<QTimer> updateFrame_;                          ///< Timer for periodic frame updates.
-    std::unique_ptr<QGraphicsPixmapItem > currentFrame_;           ///< Current video frame as a pixmap item.
+    std::unique_ptr<TFramePipeline> pipeline_;                     ///< Worker stage running the middleware chain.
+    std::unique_ptr<TCaptureExecutor> captureExecutor_;            ///< Threads shared by the polling video sources.
+    std::unique_ptr<QTimer> updateFrame_;                          ///< Fallback timer for periodic frame polling.
+    std::unique_ptr<QTimer> presentFrame_;                         ///< Single-shot timer for coalesced frame presentation.
+    QElapsedTimer lastPresent_;                                    ///< Time since the last presented frame.
+    std::unique_ptr<TVideoItem> videoItem_;                        ///< Item painting the current video frame.
     int currentActiveVideoProviderIdx_ = 0;                        ///< Current video source idx.
     std::string currentActiveFormatSrc_{};                         ///< Current video avaliable formats description.
     QList<std::string> videosrcDesc_;                              ///< List of available video source descriptions.
@@ -197,41 +285,53 @@ private:
     IFrameProvider* usbDevs_;                                      ///< USB video device provider (default provider).
     IFrameProvider* rtcp_;                                         ///< RTSP video provider.
     double zoomFactor_ = 0.5;                                      ///< Current zoom factor.
-    QImage currentFrameImg_;                                       ///< Current frame data as a QImage.
+    bool usePreview_ = true;                                       ///< Flag indicating if the preview is enabled.
+    TLatencyStats latencyStats_;                                   ///< Latency of the presented frames.
+    QLabel* latencyOverlay_ = nullptr;                             ///< Overlay showing the latency percentiles.
+    std::unique_ptr<QTimer> latencyOverlayTimer_;                  ///< Timer refreshing the latency overlay.
 
     /*!
      * \brief Updates the video size and scene properties based on the frame.
-     * \param img The current frame image.
+     * \param size The full-resolution size of the current frame.
      *
-     * Adjusts the scene rectangle, painter font size, and line width based on the image dimensions.
+     * Adjusts the scene rectangle, painter font size, and line width based on the frame dimensions.
      */
-    void updateVideoSize(const QImage &img);
+    void updateVideoSize(const QSize &size);
 
     /*!
-     * \brief Adds a middleware processor to the frame processing chain.
-     * \param middleware The middleware to add.
+     * \brief Updates the pipeline preview size to the size the current frame is displayed at.
      */
-    void addMiddleware(IFrameMiddleware *middleware);
+    void updatePreviewSize();
 
     /*!
-     * \brief Removes all middleware processors of a specific type.
-     * \tparam T The type of middleware to remove.
+     * \brief Retrieves the refresh period of the screen showing the widget.
+     * \return The refresh period in milliseconds, or FRAME_UPDATE_PERIOD if the screen is unknown.
      */
-    template<typename T>
-    void removeMiddlewareByType();
+    int displayRefreshPeriod() const;
 
     /*!
-     * \brief Removes all edge detector middleware processors.
+     * \brief Refreshes the latency overlay text from the latency statistics.
      */
-    void removeAllEdgeDetectors();
+    void updateLatencyOverlay();
 
     /*!
-     * \brief Checks if a middleware processor of a specific type exists.
-     * \tparam T The type of middleware to check for.
-     * \return True if the middleware exists, false otherwise.
+     * \brief Registers a configured polled source and starts it on the shared capture executor.
+     * \param provider The source, owned by the widget from now on.
+     *
+     * The source is added to the source list once it has opened.
+     */
+    void startPolledSource(IFrameProvider *provider);
+
+    /*!
+     * \brief Adds a middleware processor to the frame processing chain.
+     * \param middleware The middleware to add.
      */
-    template<typename T>
-    bool findMiddlewareByType();
+    void addMiddleware(IFrameMiddleware *middleware);
+
+    /*!
+     * \brief Removes all edge detector middleware processors.
+     */
+    void removeAllEdgeDetectors();
 };
 
 #endif // TVIDEOWDG_H
@@ -0,0 +1,49 @@
+#include "tvideoitem.h"
+
+TVideoItem::TVideoItem(QGraphicsItem *parent) :
+    QGraphicsItem(parent)
+{}
+
+bool TVideoItem::setFrame(const TFramePacketPtr &packet)
+{
+    const QSize size = packet ? packet->frameSize() : QSize();
+    const bool sizeChanged = size != frameSize_;
+    if (sizeChanged) {
+        prepareGeometryChange();
+        frameSize_ = size;
+    }
+    packet_ = packet;
+    update();
+    return sizeChanged;
+}
+
+QRectF TVideoItem::boundingRect() const
+{
+    return QRectF(QPointF(0, 0), frameSize_);
+}
+
+QPainterPath TVideoItem::opaqueArea() const
+{
+    QPainterPath path;
+    if (packet_ && !packet_->image.hasAlphaChannel()) {
+        path.addRect(boundingRect());
+    }
+    return path;
+}
+
+void TVideoItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+    if (!packet_ || packet_->image.isNull()) {
+        return;
+    }
+    const QImage& img = packet_->image;
+    if (img.size() == frameSize_) {
+        painter->drawImage(QPointF(0, 0), img);
+    } else {
+        // Preview: stretch over the full-resolution frame rectangle.
+        painter->setRenderHint(QPainter::SmoothPixmapTransform);
+        painter->drawImage(boundingRect(), img);
+    }
+}
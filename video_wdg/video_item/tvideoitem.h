@@ -0,0 +1,81 @@
+/** @file
+ *
+ * TVideoWdg - SimpleMeasurementByVideoTool
+ * By Ilia.belou <ilia.belou@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef TVIDEOITEM_H
+#define TVIDEOITEM_H
+
+#include <QGraphicsItem>
+#include <QPainter>
+
+#include "video_wdg/frame_packet/tframepacket.h"
+
+/*!
+ * \class TVideoItem
+ * \brief Graphics item painting the image of a frame packet directly.
+ *
+ * The `TVideoItem` class shows video frames in a `QGraphicsScene` without converting them to `QPixmap`. It keeps a
+ * reference to the displayed packet and paints its image straight from the packet buffer, so presenting a frame copies
+ * nothing and only invalidates the area of the item. The item always spans the full-resolution frame size; a
+ * downsampled preview is stretched over it, so scene coordinates stay in full-resolution pixels.
+ */
+class TVideoItem : public QGraphicsItem
+{
+public:
+    /*!
+     * \brief Constructs a TVideoItem instance.
+     * \param parent The parent item (default is nullptr).
+     */
+    explicit TVideoItem(QGraphicsItem* parent = nullptr);
+
+    /*!
+     * \brief Sets the displayed frame.
+     * \param packet The packet holding the frame. The item keeps a reference to it until the next frame.
+     * \return True if the frame size changed.
+     *
+     * Schedules a repaint of the item area only.
+     */
+    bool setFrame(const TFramePacketPtr& packet);
+
+    /*!
+     * \brief Retrieves the displayed frame.
+     * \return Handle to the packet, empty if no frame was set.
+     */
+    const TFramePacketPtr& getFrame() const { return packet_; }
+
+    /*!
+     * \brief Retrieves the full-resolution size of the displayed frame.
+     * \return The size, empty if no frame was set.
+     */
+    QSize frameSize() const { return frameSize_; }
+
+    /*!
+     * \brief Retrieves the bounding rectangle of the item.
+     * \return The frame rectangle in item coordinates.
+     */
+    QRectF boundingRect() const override;
+
+    /*!
+     * \brief Retrieves the opaque area of the item.
+     * \return The frame rectangle if the frame has no alpha channel, otherwise an empty path.
+     */
+    QPainterPath opaqueArea() const override;
+
+    /*!
+     * \brief Paints the frame.
+     * \param painter The painter.
+     * \param option The style options (unused).
+     * \param widget The widget being painted on (unused).
+     */
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget = nullptr) override;
+
+private:
+    TFramePacketPtr packet_;    ///< Displayed frame packet.
+    QSize frameSize_;           ///< Full-resolution size of the displayed frame.
+};
+
+#endif // TVIDEOITEM_H